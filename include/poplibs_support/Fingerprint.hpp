@@ -0,0 +1,118 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#ifndef poplibs_support_Fingerprint_hpp
+#define poplibs_support_Fingerprint_hpp
+
+#include <poplar/Type.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace poplibs_support {
+
+// Computes a 64-bit FNV-1a hash of a sequence of values. Unlike std::hash and
+// boost::hash the result only depends on the values added, so it is the same
+// in every process and can be written to files. Integers are added as 8
+// little-endian bytes and containers are prefixed with their size.
+//
+// Values of other class types are added by calling addToFingerprint(f, value),
+// which is found by argument dependent lookup. Values that compare equal must
+// add the same bytes.
+class Fingerprint {
+public:
+  Fingerprint &addBytes(const void *data, std::size_t size) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i != size; ++i) {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ULL;
+    }
+    return *this;
+  }
+
+  template <typename T> Fingerprint &add(const T &value) {
+    addValue(value);
+    return *this;
+  }
+
+  std::uint64_t get() const { return hash; }
+
+private:
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+
+  template <typename T>
+  std::enable_if_t<std::is_integral<T>::value || std::is_enum<T>::value>
+  addValue(T value) {
+    auto v = static_cast<std::uint64_t>(value);
+    unsigned char bytes[8];
+    for (auto &byte : bytes) {
+      byte = v & 0xff;
+      v >>= 8;
+    }
+    addBytes(bytes, sizeof(bytes));
+  }
+
+  void addValue(double value) {
+    // 0.0 and -0.0 compare equal.
+    if (value == 0) {
+      value = 0;
+    }
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    addValue(bits);
+  }
+
+  void addValue(const std::string &s) {
+    addValue(s.size());
+    addBytes(s.data(), s.size());
+  }
+
+  void addValue(const poplar::Type &type) {
+    addValue(std::string(type.toString()));
+  }
+
+  template <typename T> void addValue(const std::vector<T> &values) {
+    addValue(values.size());
+    for (const auto &value : values) {
+      addValue(static_cast<const T &>(value));
+    }
+  }
+
+  template <typename T> void addValue(const boost::optional<T> &value) {
+    addValue(static_cast<bool>(value));
+    if (value) {
+      addValue(*value);
+    }
+  }
+
+  template <typename T>
+  std::enable_if_t<std::is_base_of<boost::property_tree::ptree, T>::value>
+  addValue(const T &tree) {
+    addValue(tree.data());
+    addValue(tree.size());
+    for (const auto &child : tree) {
+      addValue(child.first);
+      addValue(child.second);
+    }
+  }
+
+  template <typename T>
+  std::enable_if_t<std::is_class<T>::value &&
+                   !std::is_base_of<boost::property_tree::ptree, T>::value>
+  addValue(const T &value) {
+    addToFingerprint(*this, value);
+  }
+};
+
+template <typename T> std::uint64_t fingerprint(const T &value) {
+  return Fingerprint().add(value).get();
+}
+
+} // namespace poplibs_support
+
+#endif // poplibs_support_Fingerprint_hpp
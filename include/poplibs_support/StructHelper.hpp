@@ -23,7 +23,18 @@ template <typename... Ps> struct StructHelper {
     return tie(lhs) == tie(rhs);
   }
 
+  // call f on each of the members of t in order.
+  template <typename T, typename F> void forEach(const T &t, F &&f) const {
+    forEach(tie(t), f, std::make_index_sequence<sizeof...(Ps)>{});
+  }
+
 private:
+  template <typename Tuple, typename F, std::size_t... Is>
+  static void forEach(const Tuple &members, F &f, std::index_sequence<Is...>) {
+    using Expand = int[];
+    (void)Expand{0, (f(std::get<Is>(members)), 0)...};
+  }
+
   template <typename T> constexpr auto tie(const T &t) const {
     return tie(t, std::make_index_sequence<sizeof...(Ps)>{});
   }
@@ -8,6 +8,17 @@
 namespace poplibs_test {
 namespace conv {
 
+/// The implementation used by the reference convolution functions.
+enum class Implementation {
+  /// Visit every output element, kernel element and input channel in turn.
+  /// This is slow but straightforward and is used to test PARALLEL.
+  NAIVE,
+  /// Precompute the input element read by each pair of output and kernel
+  /// elements and process independent channels in parallel. Each result is
+  /// accumulated in the same order as NAIVE so the results are bit-identical.
+  PARALLEL
+};
+
 void convolution(const std::vector<unsigned> &inputFieldSize,
                  const std::vector<unsigned> &truncationLower,
                  const std::vector<unsigned> &truncationUpper,
@@ -30,7 +41,8 @@ void convolution(const std::vector<unsigned> &inputFieldSize,
                  boost::const_multi_array_ref<double, 3> in,
                  boost::const_multi_array_ref<double, 4> weights,
                  boost::const_multi_array_ref<double, 1> biases,
-                 boost::multi_array_ref<double, 3> out);
+                 boost::multi_array_ref<double, 3> out,
+                 Implementation implementation = Implementation::PARALLEL);
 
 void convolutionBackward(const std::vector<unsigned> &inputFieldSize,
                          const std::vector<unsigned> &truncationLower,
@@ -53,7 +65,9 @@ void convolutionBackward(const std::vector<unsigned> &inputFieldSize,
                          const std::vector<unsigned> &outputPaddingUpper,
                          boost::const_multi_array_ref<double, 3> in,
                          boost::const_multi_array_ref<double, 4> weights,
-                         boost::multi_array_ref<double, 3> out);
+                         boost::multi_array_ref<double, 3> out,
+                         Implementation implementation =
+                             Implementation::PARALLEL);
 
 void weightUpdate(const std::vector<unsigned> &inputFieldSize,
                   const std::vector<unsigned> &truncationLower,
@@ -78,7 +92,8 @@ void weightUpdate(const std::vector<unsigned> &inputFieldSize,
                   boost::const_multi_array_ref<double, 3> activations,
                   boost::const_multi_array_ref<double, 3> deltas,
                   boost::multi_array_ref<double, 4> weights,
-                  boost::multi_array_ref<double, 1> biases);
+                  boost::multi_array_ref<double, 1> biases,
+                  Implementation implementation = Implementation::PARALLEL);
 
 } // namespace conv
 } // namespace poplibs_test
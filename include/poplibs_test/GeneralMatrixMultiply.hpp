@@ -8,6 +8,18 @@
 namespace poplibs_test {
 namespace gemm {
 
+/// The implementation used by the matrix-matrix multiplication functions.
+enum class Implementation {
+  /// Compute each element of the result with a dot product. This is slow but
+  /// straightforward and is used to test BLOCKED.
+  NAIVE,
+  /// Compute blocks of the result in parallel, accumulating whole rows at a
+  /// time so the inner loop can be vectorized. Each element is accumulated in
+  /// the same order as NAIVE so the results are bit-identical. Operands that
+  /// aren't stored densely in row-major order are multiplied with NAIVE.
+  BLOCKED
+};
+
 /*
  * Computes matC = alpha * op(matA) .* op(matB)
  *
@@ -77,7 +89,9 @@ void generalMatrixMultiply(const boost::multi_array_ref<double, 2> matA,
                            const boost::multi_array_ref<double, 2> matC,
                            boost::multi_array_ref<double, 2> matD,
                            float alpha = 1.0, float beta = 1.0,
-                           bool transposeA = false, bool transposeB = false);
+                           bool transposeA = false, bool transposeB = false,
+                           Implementation implementation =
+                               Implementation::BLOCKED);
 
 /*
  * Computes matD = beta * matC + alpha * op(matA) * op(matB) for each matrix in
@@ -98,7 +112,9 @@ void generalGroupedMatrixMultiply(const boost::multi_array_ref<double, 3> matA,
                                   boost::multi_array_ref<double, 3> matD,
                                   float alpha = 1.0, float beta = 1.0,
                                   bool transposeA = false,
-                                  bool transposeB = false);
+                                  bool transposeB = false,
+                                  Implementation implementation =
+                                      Implementation::BLOCKED);
 
 /*
  * Computes matC = op(matA) * op(matB)
@@ -114,7 +130,9 @@ void generalGroupedMatrixMultiply(const boost::multi_array_ref<double, 3> matA,
 void generalMatrixMultiply(const boost::multi_array_ref<double, 2> matA,
                            const boost::multi_array_ref<double, 2> matB,
                            boost::multi_array_ref<double, 2> matC,
-                           bool transposeA = false, bool transposeB = false);
+                           bool transposeA = false, bool transposeB = false,
+                           Implementation implementation =
+                               Implementation::BLOCKED);
 
 /*
  * Computes matC = op(matA) * op(matB) for each matrix in
@@ -133,7 +151,9 @@ void generalGroupedMatrixMultiply(const boost::multi_array_ref<double, 3> matA,
                                   const boost::multi_array_ref<double, 3> matB,
                                   boost::multi_array_ref<double, 3> matC,
                                   bool transposeA = false,
-                                  bool transposeB = false);
+                                  bool transposeB = false,
+                                  Implementation implementation =
+                                      Implementation::BLOCKED);
 
 } // End namespace gemm.
 } // namespace poplibs_test
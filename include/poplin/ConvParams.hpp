@@ -6,6 +6,10 @@
 #include <tuple>
 #include <vector>
 
+namespace poplibs_support {
+class Fingerprint;
+} // namespace poplibs_support
+
 namespace poplin {
 
 struct ConvParams {
@@ -155,6 +159,14 @@ std::ostream &operator<<(std::ostream &os, const ConvParams &p);
 std::size_t hash_value(const ConvParams::InputTransform &it);
 std::size_t hash_value(const ConvParams::OutputTransform &ot);
 
+/// Add the parameters to a stable fingerprint. Parameters that compare equal
+/// have the same fingerprint.
+void addToFingerprint(poplibs_support::Fingerprint &f,
+                      const ConvParams::InputTransform &it);
+void addToFingerprint(poplibs_support::Fingerprint &f,
+                      const ConvParams::OutputTransform &ot);
+void addToFingerprint(poplibs_support::Fingerprint &f, const ConvParams &p);
+
 } // namespace poplin
 
 namespace std {
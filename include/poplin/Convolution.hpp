@@ -6,6 +6,7 @@
 #include <poplar/Graph.hpp>
 #include <poplar/OptionFlags.hpp>
 #include <poplar/Program.hpp>
+#include <cstdint>
 #include <set>
 #include <tuple>
 
@@ -124,6 +125,15 @@ double getWuPerfectCycleCount(const poplar::Graph &graph,
  *
  *       If true, then convolutions with different parameters will be laid out
  *       from different tiles in an effort to improve tile balance in models.
+ *
+ *    * `plannerSearchStrategy` (linear, bisect) [=linear]
+ *
+ *       The strategy the planner uses to search for the best plan. `bisect`
+ *       splits large ranges of candidate values in half and only considers
+ *       values that divide the dimension being split, which is typically
+ *       faster for large convolutions. Both strategies find a plan of the
+ *       same estimated cost, but when several plans have equal cost they may
+ *       choose different ones.
  */
 /*[INTERNAL]
  *    * `numIPUs` Integer [=target.getNumIPUs()]
@@ -477,11 +487,92 @@ poplar::Tensor fullyConnectedWeightTranspose(
 
 struct Plan;
 
+/// Counters describing the work done by the convolution planner.
+struct PlanningStats {
+  /// The number of candidate plans that were solved. Each candidate is a
+  /// combination of transforms, types and vertex type for one convolution.
+  std::uint64_t candidates = 0;
+  /// The total time spent solving candidates in seconds. Candidates are solved
+  /// in parallel so this may exceed the elapsed time.
+  double solveSeconds = 0;
+  /// The number of nodes of the search trees explored by the solver.
+  std::uint64_t nodes = 0;
+  /// The number of times the solver propagated constraints to a fixed point.
+  std::uint64_t propagations = 0;
+  /// The number of times the solver propagated an individual constraint.
+  std::uint64_t constraintEvaluations = 0;
+  /// The number of times the solver undid a choice.
+  std::uint64_t backtracks = 0;
+  /// The number of choices the solver rejected because constraint
+  /// propagation failed.
+  std::uint64_t prunes = 0;
+};
+
 class PlanningCacheImpl;
 class PlanningCache {
 public:
   PlanningCache();
   ~PlanningCache();
+
+  /** Add the plans stored in a file previously written by save() to the
+   *  cache. Plans found in the file are used instead of running the planner.
+   *
+   *  Only plans that were created for a target with the same properties as
+   *  \p target are used. Files with an unsupported format version are
+   *  ignored.
+   *
+   * \param target      The target the plans will be used for.
+   * \param path        The file to read the plans from.
+   */
+  void load(const poplar::Target &target, const std::string &path);
+
+  /** Write the plans in the cache to a file so they can be reused by a later
+   *  process using load().
+   *
+   *  Plans read from the file by load() for other targets are preserved.
+   *
+   * \param target      The target the plans in the cache were created for.
+   * \param path        The file to write the plans to.
+   */
+  void save(const poplar::Target &target, const std::string &path) const;
+
+  /** Use the plans in a plan index file written by mergeIntoIndex().
+   *
+   *  The file is memory mapped read-only rather than parsed, so it is cheap
+   *  to load and can be shared by many processes at once. Plans are looked
+   *  up in the index when they are not otherwise found in the cache. The
+   *  index is ignored if it was created for a target with different
+   *  properties to \p target or with an unsupported format version.
+   *
+   * \param target      The target the plans will be used for.
+   * \param path        The plan index file to map.
+   */
+  void loadIndex(const poplar::Target &target, const std::string &path);
+
+  /** Add the plans in the cache to a plan index file, creating the file if
+   *  it does not exist. Plans already in the index are kept.
+   *
+   *  Concurrent merges into the same file by different processes are
+   *  serialized using a lock file named \p path with ".lock" appended. The
+   *  lock file is not removed afterwards and may be deleted once no merges
+   *  into the index are in progress. The index is replaced atomically so
+   *  processes that have already loaded it are unaffected.
+   *
+   * \param target      The target the plans in the cache were created for.
+   * \param path        The plan index file to update.
+   *
+   * \throw poputil::poplibs_error If the existing index was created for a
+   *        target with different properties.
+   */
+  void mergeIntoIndex(const poplar::Target &target,
+                      const std::string &path) const;
+
+  /** Get counters describing the work done by the planner for all the plans
+   *  created using this cache. Plans that were found in the cache do not
+   *  contribute to the counters.
+   */
+  PlanningStats getStats() const;
+
   std::unique_ptr<PlanningCacheImpl> impl;
 };
 
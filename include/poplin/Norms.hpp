@@ -68,10 +68,12 @@ createNormParams(poplar::Graph &graph, const poplar::Tensor &acts);
 ///                       appended with the code to perform the normalisation.
 /// \param unbiasedVarEstimate
 ///                       Compute unbiased variance estimate.
-/// \param stableAlgo     If true, computes the mean first and subtracts
-///                       the activations by it before computing the variance.
-///                       The implementation with this flag set to true is
-//                        slower than when set to false.
+/// \param stableAlgo     If true, computes the mean and the variance about it
+///                       in a single pass over the activations, using
+///                       Welford's algorithm on each tile and combining the
+///                       partial results of the tiles. The implementation
+///                       with this flag set to true is slower than when set
+///                       to false.
 /// \param partialsType   Poplar type used for partials.
 /// \param debugPrefix    A debug prefix added to compute set and tensor names.
 ///
@@ -163,6 +165,28 @@ poplar::Tensor normStatisticsGradients(
     const poplar::Type &partialsType = poplar::FLOAT,
     const std::string &debugPrefix = "");
 
+/// Propagate the gradients through both the normalisation and the norm
+/// statistics layers. This is equivalent to calling normGradients() with
+/// \p gamma followed by normStatisticsGradients(), but doesn't create the
+/// intermediate gradients and reads the whitened activations and the
+/// gradients once to compute both sums over each channel and once more to
+/// compute the output gradients. \p gamma must have the same elements as
+/// \p invStdDev.
+/// \param graph        The graph to which the normalisaton operation is added.
+/// \param actsWhitened Forward whitened activations.
+/// \param gradsIn      Input gradients to the normalisation layer.
+/// \param invStdDev    Inverse standard deviation from norm statistics.
+/// \param gamma        Multiplicative parameter used in the normalisation.
+/// \param prog         A reference to the a program sequence which will be
+///                     appended with the code to perform the normalisation.
+/// \param debugPrefix  A debug prefix added to compute set and tensor names.
+poplar::Tensor normStatisticsGradients(
+    poplar::Graph &graph, const poplar::Tensor &actsWhitened,
+    const poplar::Tensor &gradsIn, const poplar::Tensor &invStdDev,
+    const poplar::Tensor &gamma, poplar::program::Sequence &prog,
+    const poplar::Type &partialsType = poplar::FLOAT,
+    const std::string &debugPrefix = "");
+
 } // namespace poplin
 
 #endif // poplin_Norms_hpp
@@ -5,7 +5,13 @@
 
 namespace popnn {
 
-enum LossType { SUM_SQUARED_LOSS, CROSS_ENTROPY_LOSS };
+enum LossType {
+  SUM_SQUARED_LOSS,
+  CROSS_ENTROPY_LOSS,
+  /// Cross entropy loss of the softmax of the model outputs, which are
+  /// logits rather than probabilities.
+  SOFTMAX_CROSS_ENTROPY_LOSS
+};
 
 } // end namespace popnn
 
@@ -47,6 +53,15 @@ namespace popnn {
  *  \param lossType           Method for calculating loss measurement.
  *  \param debugPrefix        Optional debug prefix for operations and tensors
  *                            for this operation.
+ *
+ *  With SOFTMAX_CROSS_ENTROPY_LOSS the softmax is fused with the loss. The
+ *  model outputs are logits and deltas is the gradient of the loss with
+ *  respect to them, scaled by deltasScale. The maximum and the sum of the
+ *  exponentials of each row are found, in float, from partials computed on
+ *  the tiles the logits are mapped to, and the deltas are computed from them
+ *  without the probabilities being stored. Logits may be -infinity, for
+ *  example to mask classes, as long as each row has a finite logit.
+ *  modelOutputScaling isn't used.
  */
 poplar::program::Program
 calcLoss(poplar::Graph &graph, const poplar::Tensor &modelOutputs,
@@ -143,9 +158,14 @@ poplar::Tensor argMin(poplar::Graph &graph, const poplar::Tensor &input,
  * [batch][values] and will return a tensor in the shape of [batch][K] where K
  * is the max values of each batch of values.
  *
+ * The top K elements of the part of each row of the input on a tile are found
+ * on that tile, and the candidates are then merged in stages across tiles, so
+ * the input is never fully sorted or gathered onto a single tile.
+ *
  *  \param graph          Graph to add operations and tensors to.
  *  \param input          2D tensor of inputs
- *  \param indices        The tensor to store the indices in.
+ *  \param indices        Set to a [batch][K] tensor of the indices of the
+ *                        returned values in the values dimension of |input|.
  *  \param K              The number of values to return.
  *  \param sort           If true values will be sorted in descending order.
  *  \param prog           Program to which the graph for this operation is added
@@ -100,7 +100,19 @@ uint64_t getBasicLstmCellWuFlops(const LstmParams &params);
  *        yielding some reduction in memory footprint for the layer.
  *
  *      * full: Recompute everything from the forward pass. Saves the most
- *        memory at the cost of an extra forward pass of cycles.
+ *        memory at the cost of an extra forward pass of cycles. Only the
+ *        state at the start of every `recomputationCheckpointInterval`
+ *        steps is saved and the backward pass recomputes the steps after
+ *        each of these states when it needs them.
+ *
+ *    * `recomputationCheckpointInterval` Integer [=0]
+ *
+ *      The number of steps between the states saved by the forward pass
+ *      when `recomputationMode` is full. A smaller interval saves more states
+ *      but needs fewer intermediates of recomputed steps at once. If set to
+ *      the number of time steps only the initial state is saved. If 0 the
+ *      square root of the number of time steps is used, which about
+ *      minimises the total memory.
  *
  * \param graph           Graph object.
  * \param params          The LSTM parameters.
@@ -69,6 +69,18 @@ struct Chunks {
  *        the final step only uses the links in one direction (assuming an even
  *        number of IPUs). The advantage is the that it requires fewer steps and
  *        allows the use of larger fragments.
+ *
+ *    * `exchangeType` (float, half) [=float]
+ *
+ *      The type to exchange float data in. If this is half the data is cast
+ *      to half before each exchange and the data received is cast back to
+ *      float to be reduced, which halves the amount of data exchanged. The
+ *      partial results are still accumulated in float but are rounded to
+ *      half each time they are sent, so they must fit in the range of half.
+ *      The result of an all-reduce is also gathered in half, so it is only
+ *      as precise as a half on every replica. This option is only supported
+ *      for the ADD, MUL, MIN and MAX operations and is ignored for data of
+ *      other types and by the non-replicated implementation.
  */
 /**
  * \param graph The graph.
@@ -157,6 +169,36 @@ void replicatedAllReduceInPlace(poplar::Graph &graph, poplar::Tensor &data,
                                 const std::string &debugPrefix = "",
                                 const poplar::OptionFlags &options = {});
 
+/// Perform an all-reduce operation on each of the specified replicated
+/// tensors.
+///
+/// Each all-reduce has a fixed cost which dominates for small tensors, so
+/// the tensors are grouped into buckets of the same element type and each
+/// bucket is reduced with a single all-reduce. The tensors of a bucket are
+/// concatenated as views so no copies are added to form the bucket, and the
+/// results are views of the bucket's result.
+///
+/// \param graph The replicated graph the input tensors belong to.
+/// \param data The replicated tensors to reduce.
+/// \param op The reduction operator (for example, `Operation::ADD`)
+/// \param prog The program sequence to add operations to.
+/// \param debugPrefix String used as a prefix for compute sets.
+/// \param options Collective options. As well as the options of
+///        reduceScatter() the following option is supported:
+///
+///    * `bucketSize` Integer [=1048576]
+///
+///      The target size of each bucket in bytes. Tensors are added to a
+///      bucket in order until it reaches this size. A tensor of at least
+///      the target size is reduced in its own bucket.
+/// \return The results of the all-reduces, in the order of \p data.
+std::vector<poplar::Tensor>
+replicatedAllReduceMany(poplar::Graph &graph,
+                        const std::vector<poplar::Tensor> &data,
+                        popops::Operation op, poplar::program::Sequence &prog,
+                        const std::string &debugPrefix = "",
+                        const poplar::OptionFlags &options = {});
+
 /// Perform an all-reduce operation on the specified replicated tensor.
 /// This variant of replicatedAllReduce() is deprecated and may be removed
 /// in future.
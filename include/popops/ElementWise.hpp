@@ -21,7 +21,9 @@
 #include <poplar/OptionFlags.hpp>
 #include <poplar/Program.hpp>
 #include <popops/Expr.hpp>
+#include <popops/Operation.hpp>
 #include <string>
+#include <vector>
 
 namespace popops {
 
@@ -87,7 +89,8 @@ poplar::Tensor invStdDevToVariance(poplar::Graph &graph,
  *      If true (and all of the inputs are the same size and do not alias), a
  *      codelet is generated to execute this map operation. A codelet will not
  *      be generated if there is only a single operation unless
- *      `forceGenerateCodelet` is true.
+ *      `forceGenerateCodelet` is true. Generated codelets can be compiled once
+ *      and shared between graphs and processes, see warmFusedCodeletCache().
  */
 /*[INTERNAL]
  *    * `enableVectorBroadcastOptimisations` (true, false) [=true]
@@ -210,6 +213,86 @@ inline void mapInPlace(poplar::Graph &graph, expr::TernaryOpType op,
              {a, b, c}, prog, debugPrefix, options);
 }
 
+/** A reduction of one of the results of mapMultiple(). */
+struct MapReduction {
+  /// The index of the expression whose result is reduced.
+  unsigned output;
+  /// The reduction to apply to all the elements of the result.
+  Operation op;
+};
+
+/** Map several expressions across the same tensors and reduce their results.
+ *
+ *  This is equivalent to calling map() for each expression and reducing the
+ *  results to scalars with popops::reduce(), but where possible the results
+ *  and a partial reduction for each vertex are all computed by a single
+ *  generated codelet in one pass over the tensors. Only the partials are then
+ *  reduced, so the results aren't read back from memory to be reduced. For
+ *  example, an update and its squared norm can be computed with:
+ *
+ *      auto results = mapMultiple(graph, {&update},
+ *                                 {{0, Operation::SQUARE_ADD}}, {w, g}, prog);
+ *
+ *  Reductions are fused if they are `ADD`, `SQUARE_ADD`, `MUL`, `MAX` or `MIN`
+ *  of a float, half or int result and the tensors are the same shape or
+ *  scalar and don't alias. Sums and products of half results are accumulated
+ *  in float.
+ *
+ *  \param graph      The graph to update.
+ *  \param exprs      The expressions to map across the tensors.
+ *  \param reductions The reductions of the results of the expressions.
+ *  \param ts         The list of tensors to map the expressions across.
+ *  \param prog       The sequence to extend with the execution of the
+ *                    expressions and reductions.
+ *  \param debugPrefix
+ *                    A debug prefix to be added to debug strings in compute
+ *                    sets and variables created by this function
+ *  \param options    Element wise options. See map().
+ *
+ *  \returns The result of each expression in \p exprs followed by a scalar
+ *           tensor with the result of each reduction in \p reductions, in the
+ *           type of the result reduced.
+ */
+std::vector<poplar::Tensor>
+mapMultiple(poplar::Graph &graph, const std::vector<const expr::Expr *> &exprs,
+            const std::vector<MapReduction> &reductions,
+            const std::vector<poplar::Tensor> &ts,
+            poplar::program::Sequence &prog,
+            const std::string &debugPrefix = "",
+            const poplar::OptionFlags &options = {});
+
+/** A map operation to compile the generated codelet of ahead of time with
+ *  warmFusedCodeletCache().
+ */
+struct FusedMapSignature {
+  /// The expression that will be mapped across the tensors.
+  const expr::Expr *expr;
+  /// The element types of the tensors the expression will be mapped across.
+  std::vector<poplar::Type> types;
+  /// Whether each of the tensors will have a single element.
+  std::vector<bool> isScalar;
+  /// True if the expression will be mapped with mapInPlace().
+  bool inPlace = false;
+};
+
+/** Compile the codelets that map() and mapInPlace() generate for a list of
+ *  map operations into the fused codelet cache.
+ *
+ *  The cache is enabled by setting the environment variable
+ *  `POPLIBS_FUSED_CODELET_CACHE` to the directory to keep it in. Generated
+ *  codelets are then compiled with `popc` into files named after their
+ *  source, the target and the version of `popc`, and reused by any graph or
+ *  process that generates the same codelet. Warming the cache ahead of time
+ *  takes the compilation out of graph construction.
+ *
+ *  Operations that map() would not generate a codelet for are skipped.
+ *
+ *  \param target     The target the codelets will be used on.
+ *  \param signatures The map operations to compile codelets for.
+ */
+void warmFusedCodeletCache(const poplar::Target &target,
+                           const std::vector<FusedMapSignature> &signatures);
+
 // Unary operations
 
 /** Compute the absolute value of each element in \p A.
@@ -9,6 +9,8 @@
 #include "poplar/Graph.hpp"
 #include "poplar/Program.hpp"
 #include <poplar/OptionFlags.hpp>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace popops {
@@ -136,6 +138,55 @@ void reduceWithOutput(poplar::Graph &graph, const poplar::Tensor &in,
                       const std::string &debugPrefix = "",
                       const poplar::OptionFlags &options = {});
 
+/// A reduction to be performed by reduceMany().
+struct SingleReduceOp {
+  poplar::Tensor in;
+  std::vector<std::size_t> dims;
+  ReduceParams params;
+  /// The type of the output, if reduceMany() creates it.
+  poplar::Type outType;
+  std::string debugPrefix;
+
+  SingleReduceOp(poplar::Tensor in, std::vector<std::size_t> dims,
+                 ReduceParams params, poplar::Type outType,
+                 std::string debugPrefix = "")
+      : in(std::move(in)), dims(std::move(dims)), params(std::move(params)),
+        outType(outType), debugPrefix(std::move(debugPrefix)) {}
+
+  SingleReduceOp(poplar::Tensor in, std::vector<std::size_t> dims,
+                 ReduceParams params, std::string debugPrefix = "")
+      : in(std::move(in)), dims(std::move(dims)), params(std::move(params)),
+        outType(this->in.elementType()), debugPrefix(std::move(debugPrefix)) {}
+};
+
+/// Perform several reductions together.
+///
+/// The reductions are planned together and the vertices of each stage of
+/// every reduction are added to the same compute sets, so the number of
+/// compute sets is that of the reduction with the most stages rather than the
+/// total over all the reductions. The stages that are spread over the IPU
+/// start on a different tile for each reduction so that the work of the
+/// reductions is balanced between tiles. This is more efficient than calling
+/// reduce() once for each tensor, for example to find the norms of the
+/// gradients of every layer. The reductions run in parallel, so none of them
+/// may read the output of another.
+///
+/// \param graph The graph to add the operations to
+/// \param reductions The reductions to perform
+/// \param outputs If empty, the outputs of the reductions are created and
+///                added to it. Otherwise it must contain an output for each
+///                reduction, as given to reduceWithOutput(), which is
+///                required if any of the reductions are updates.
+/// \param prog The program sequence to add the operations to
+/// \param debugPrefix Identifying prefix for debugging information
+/// \param options The options for every reduction, as for reduce()
+void reduceMany(poplar::Graph &graph,
+                const std::vector<SingleReduceOp> &reductions,
+                std::vector<poplar::Tensor> &outputs,
+                poplar::program::Sequence &prog,
+                const std::string &debugPrefix = "",
+                const poplar::OptionFlags &options = {});
+
 /// DEPRECATED
 struct ReductionDebug;
 
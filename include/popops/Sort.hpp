@@ -4,6 +4,7 @@
 #define popops_Sort_hpp
 
 #include <poplar/Graph.hpp>
+#include <poplar/OptionFlags.hpp>
 #include <poplar/Program.hpp>
 #include <string>
 
@@ -22,13 +23,34 @@ namespace popops {
  *  \param dim         The dimension to sort on.
  *  \param prog        The program to be extended.
  *  \param debugPrefix The prefix prepended to debugging info.
+ *  \param options     Sort options.
+ *
+ *  **Sort options**
+ *
+ *     * `algorithm` (oddEvenTransposition, mergeExchange)
+ *       [=oddEvenTransposition]
+ *
+ *       How the sorted intervals of each tile are combined.
+ *
+ *       * oddEvenTransposition: Repeatedly exchange the elements at the edges
+ *         of neighbouring intervals and sort the intervals again, until all
+ *         the edges are in order. The number of steps depends on the data and
+ *         is at most the number of intervals, and each step also checks
+ *         whether the tensor is sorted.
+ *
+ *       * mergeExchange: Merge and split pairs of intervals following
+ *         Batcher's merge exchange sorting network. The number of steps is
+ *         t(t + 1) / 2, where t is the base-2 logarithm of the number of
+ *         intervals rounded up, and is known when the graph is constructed.
+ *         This needs temporary memory for copies of the intervals each step.
  *
  *  \returns           A tensor which is a permutation of `t` such that all
  *                     elements in the given dimension are in order.
  */
 poplar::Tensor sort(poplar::Graph &graph, const poplar::Tensor &t, unsigned dim,
                     poplar::program::Sequence &prog,
-                    const std::string &debugPrefix = "");
+                    const std::string &debugPrefix = "",
+                    const poplar::OptionFlags &options = {});
 
 /** In-place sort a given tensor along the given dimension.
  *
@@ -40,10 +62,12 @@ poplar::Tensor sort(poplar::Graph &graph, const poplar::Tensor &t, unsigned dim,
  *  \param dim         The dimension to sort on.
  *  \param prog        The program to be extended.
  *  \param debugPrefix The prefix prepended to debugging info.
+ *  \param options     Sort options, see sort().
  */
 void sortInPlace(poplar::Graph &graph, const poplar::Tensor &t, unsigned dim,
                  poplar::program::Sequence &prog,
-                 const std::string &debugPrefix = "");
+                 const std::string &debugPrefix = "",
+                 const poplar::OptionFlags &options = {});
 
 /** Sort a given tensor by a key tensor along the given dimension.
  *
@@ -60,6 +84,7 @@ void sortInPlace(poplar::Graph &graph, const poplar::Tensor &t, unsigned dim,
  *  \param dim         The dimension to sort on.
  *  \param prog        The program to be extended.
  *  \param debugPrefix The prefix prepended to debugging info.
+ *  \param options     Sort options, see sort().
  *
  *  \returns           A tensor which is a permutation of `v` such that it is in
  *                     order with respect to the tensor `k` in the given
@@ -70,7 +95,8 @@ void sortInPlace(poplar::Graph &graph, const poplar::Tensor &t, unsigned dim,
 poplar::Tensor sortKeyValue(poplar::Graph &graph, const poplar::Tensor &k,
                             const poplar::Tensor &v, unsigned dim,
                             poplar::program::Sequence &prog,
-                            const std::string &debugPrefix = "");
+                            const std::string &debugPrefix = "",
+                            const poplar::OptionFlags &options = {});
 
 /** In-place sort a given tensor by a key tensor along the given dimension.
  *
@@ -83,6 +109,7 @@ poplar::Tensor sortKeyValue(poplar::Graph &graph, const poplar::Tensor &k,
  *  \param dim         The dimension to sort on.
  *  \param prog        The program to be extended.
  *  \param debugPrefix The prefix prepended to debugging info.
+ *  \param options     Sort options, see sort().
  *
  *  \note the 'k' tensor is also sorted by this in-place operation.
  *  \note If the `k` tensor and the `v` tensor alias, the result is undefined.
@@ -90,7 +117,8 @@ poplar::Tensor sortKeyValue(poplar::Graph &graph, const poplar::Tensor &k,
 void sortKeyValueInPlace(poplar::Graph &graph, const poplar::Tensor &k,
                          const poplar::Tensor &v, unsigned dim,
                          poplar::program::Sequence &prog,
-                         const std::string &debugPrefix = "");
+                         const std::string &debugPrefix = "",
+                         const poplar::OptionFlags &options = {});
 
 } // namespace popops
 
@@ -0,0 +1,62 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+
+#ifndef popsolver_CallMemo_hpp
+#define popsolver_CallMemo_hpp
+
+#include <boost/optional.hpp>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace popsolver {
+
+/// A table of the results of a function passed to Model::call(), indexed by
+/// the values of the function's operands. A table can be shared by several
+/// calls, including calls added to different models, provided the function
+/// gives the same result for the same operands in each of them. The table may
+/// be accessed from several threads at once.
+class CallMemo {
+public:
+  using Result = boost::optional<unsigned>;
+
+  /// Create a table that holds at most \p maxSize entries. Once the table is
+  /// full, further results are not recorded but lookups of the existing
+  /// entries continue to hit.
+  explicit CallMemo(
+      std::size_t maxSize = std::numeric_limits<std::size_t>::max())
+      : maxSize(maxSize) {}
+
+  /// Look up the result for the specified operand values.
+  /// \returns True and sets \p result if the table has an entry for
+  ///          \p values, false otherwise.
+  bool lookup(const std::vector<unsigned> &values, Result &result) const;
+  /// Record the result for the specified operand values.
+  void insert(const std::vector<unsigned> &values, Result result);
+
+  /// The number of lookups that found an entry.
+  std::uint64_t hits() const { return numHits; }
+  /// The number of lookups that did not find an entry.
+  std::uint64_t misses() const { return numMisses; }
+  /// The proportion of lookups that found an entry, or 0 if there have
+  /// been no lookups.
+  double hitRate() const;
+  /// The number of entries in the table.
+  std::size_t size() const;
+
+private:
+  struct Hash {
+    std::size_t operator()(const std::vector<unsigned> &values) const;
+  };
+  const std::size_t maxSize;
+  mutable std::mutex mutex;
+  std::unordered_map<std::vector<unsigned>, Result, Hash> table;
+  mutable std::atomic<std::uint64_t> numHits{0};
+  mutable std::atomic<std::uint64_t> numMisses{0};
+};
+
+} // End namespace popsolver.
+
+#endif // popsolver_CallMemo_hpp
@@ -5,7 +5,9 @@
 
 #include <boost/optional.hpp>
 #include <cassert>
+#include <cstdint>
 #include <functional>
+#include <iosfwd>
 #include <memory>
 #include <popsolver/Variable.hpp>
 #include <string>
@@ -14,6 +16,7 @@
 
 namespace popsolver {
 
+class CallMemo;
 class Constraint;
 class Scheduler;
 
@@ -61,10 +64,58 @@ public:
   bool validSolution() const { return values.size() > 0; }
 };
 
+/// The strategy used by Model::minimize() to search for a solution.
+enum class SearchStrategy {
+  /// Try every value in the domain of each variable in turn, from the
+  /// smallest to the largest.
+  LINEAR,
+  /// Split large domains in half and search the lower half before the upper
+  /// half, so that constraint propagation against the best solution found so
+  /// far can rule out a whole range of values at once. Variables that are
+  /// constrained to be a factor of a constant only try the divisors of that
+  /// constant. The minimum cost found is the same as with LINEAR, but if
+  /// there are several solutions of equal cost a different one may be
+  /// returned.
+  BISECT
+};
+
+std::ostream &operator<<(std::ostream &os, SearchStrategy s);
+
+/// Counters describing the work done by a call to Model::minimize().
+struct SearchStats {
+  /// The number of nodes of the search tree explored, that is the number of
+  /// times the search restricted the domain of a variable.
+  std::uint64_t nodes = 0;
+  /// The number of times constraints were propagated to a fixed point.
+  std::uint64_t propagations = 0;
+  /// The number of times an individual constraint was propagated.
+  std::uint64_t constraintEvaluations = 0;
+  /// The number of times the search undid a restriction of a domain.
+  std::uint64_t backtracks = 0;
+  /// The number of nodes rejected because constraint propagation failed.
+  std::uint64_t prunes = 0;
+
+  SearchStats &operator+=(const SearchStats &other);
+};
+
+std::ostream &operator<<(std::ostream &os, const SearchStats &s);
+
 class Model {
   void addConstraint(std::unique_ptr<Constraint> c);
   bool minimize(Scheduler &scheduler, const std::vector<Variable> &objectives,
                 bool &foundSolution, Solution &solution);
+  bool minimizeLinear(Scheduler &scheduler, Variable v,
+                      const std::vector<Variable> &objectives,
+                      bool &foundSolution, Solution &solution);
+  bool minimizeBisect(Scheduler &scheduler, Variable v,
+                      const std::vector<Variable> &objectives,
+                      bool &foundSolution, Solution &solution);
+  bool minimizeDivisors(Scheduler &scheduler, Variable v,
+                        const std::vector<Variable> &objectives,
+                        bool &foundSolution, Solution &solution);
+  bool tryDomain(Scheduler &scheduler, Variable v, unsigned min, unsigned max,
+                 const std::vector<Variable> &objectives, bool &foundSolution,
+                 Solution &solution);
   Variable product(const Variable *begin, const Variable *end,
                    const std::string &debugName);
   std::string makeProductDebugName(const Variable *begin,
@@ -75,12 +126,22 @@ class Model {
   std::string makeSumDebugName(const std::vector<Variable> &v) const;
   const std::string &getDebugName(Variable v) const;
 
+  SearchStrategy searchStrategy = SearchStrategy::LINEAR;
+  /// The divisors of each constant in factorOfConstant, in ascending order.
+  /// This is populated at the start of each search by the BISECT strategy.
+  std::unordered_map<unsigned, std::vector<unsigned>> divisors;
+  SearchStats searchStats;
+
 public:
   Model();
+  explicit Model(SearchStrategy searchStrategy);
   ~Model();
   std::vector<std::string> debugNames;
   std::unordered_map<unsigned, Variable> constants;
   std::vector<bool> isCallOperand;
+  /// For each variable, a constant that the variable is known to be a factor
+  /// of, or 0 if there is no such constant.
+  std::vector<unsigned> factorOfConstant;
   std::vector<std::unique_ptr<Constraint>> constraints;
   Domains initialDomains;
 
@@ -155,6 +216,16 @@ public:
                     const std::vector<unsigned> &values)>
                     f,
                 const std::string &debugName = "");
+  /// Add a new variable that is the result of applying the specified function
+  /// to the specified variables. Results of the function are looked up in and
+  /// added to \p memo so the function is only evaluated once for each set
+  /// of operand values that is encountered.
+  Variable call(std::vector<Variable> vars,
+                std::function<boost::optional<unsigned>(
+                    const std::vector<unsigned> &values)>
+                    f,
+                std::shared_ptr<CallMemo> memo,
+                const std::string &debugName = "");
   /// Find a solution that minimizes the value of the specified variables.
   /// Lexicographical comparison is used to compare the values of the variables.
   /// \returns The solution
@@ -162,6 +233,9 @@ public:
   /// Find a solution that minimizes the specified variable.
   /// \returns The solution
   Solution minimize(Variable v) { return minimize(std::vector<Variable>({v})); }
+  /// The counters describing the work done by the most recent call to
+  /// minimize().
+  const SearchStats &getSearchStats() const { return searchStats; }
 };
 
 } // End namespace popsolver.
@@ -50,6 +50,11 @@ class PlanningCache;
  *
  *      If set, forces the same buckets to be used for all three passes.
  *
+ *    * `plannerSearchStrategy` (linear, bisect) [=linear]
+ *
+ *      The strategy the planner uses to search for the best plan. See the
+ *      convolution option of the same name.
+ *
  *
  * * \param graph The Poplar graph.
  * \param inputType The type for inputs to the operation.
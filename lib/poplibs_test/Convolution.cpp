@@ -3,9 +3,12 @@
 #include <poplibs_test/Convolution.hpp>
 #include <poplibs_test/exceptions.hpp>
 
+#include <tbb/parallel_for.h>
+
 #include <algorithm>
 #include <cassert>
 #include <functional>
+#include <utility>
 
 using poputil::flattenIndex;
 using poputil::unflattenIndex;
@@ -445,6 +448,51 @@ static bool getInputIndices(const std::vector<unsigned> &inputSize,
   return true;
 }
 
+namespace {
+
+// For each element of the output field the pairs of (kernel element, input
+// element) that contribute to it, in increasing order of kernel element.
+// This is the same for every batch element and channel so it is computed once
+// rather than in the innermost loop of the convolution.
+struct ConvIndexTable {
+  std::vector<std::size_t> begin;
+  std::vector<std::pair<unsigned, unsigned>> entries;
+
+  ConvIndexTable(const std::vector<unsigned> &inputSize,
+                 const std::vector<unsigned> &kernelSize,
+                 const std::vector<unsigned> &outputSize) {
+    const auto outputElements = product(outputSize);
+    const auto kernelElements = product(kernelSize);
+    std::vector<std::vector<unsigned>> kernelIndices;
+    kernelIndices.reserve(kernelElements);
+    for (unsigned ke = 0; ke != kernelElements; ++ke) {
+      kernelIndices.push_back(unflattenIndex(kernelSize, ke));
+    }
+    begin.reserve(outputElements + 1);
+    std::vector<unsigned> inputIndices;
+    for (unsigned oe = 0; oe != outputElements; ++oe) {
+      begin.push_back(entries.size());
+      const auto outputIndices = unflattenIndex(outputSize, oe);
+      for (unsigned ke = 0; ke != kernelElements; ++ke) {
+        if (getInputIndices(inputSize, kernelSize, outputIndices,
+                            kernelIndices[ke], inputIndices)) {
+          entries.emplace_back(ke, flattenIndex(inputSize, inputIndices));
+        }
+      }
+    }
+    begin.push_back(entries.size());
+  }
+
+  const std::pair<unsigned, unsigned> *entriesBegin(unsigned oe) const {
+    return entries.data() + begin[oe];
+  }
+  const std::pair<unsigned, unsigned> *entriesEnd(unsigned oe) const {
+    return entries.data() + begin[oe + 1];
+  }
+};
+
+} // end anonymous namespace
+
 void poplibs_test::conv::convolution(
     const std::vector<unsigned> &inputFieldSize,
     const std::vector<unsigned> &truncationLower,
@@ -467,7 +515,7 @@ void poplibs_test::conv::convolution(
     boost::const_multi_array_ref<double, 3> in,
     boost::const_multi_array_ref<double, 4> kernel,
     boost::const_multi_array_ref<double, 1> biases,
-    boost::multi_array_ref<double, 3> out) {
+    boost::multi_array_ref<double, 3> out, Implementation implementation) {
   if (inputFieldSize.size() != truncationLower.size() ||
       inputFieldSize.size() != truncationUpper.size() ||
       inputFieldSize.size() != inputDilation.size() ||
@@ -526,29 +574,91 @@ void poplibs_test::conv::convolution(
       boost::extents[batchSize][outputChannels][convOutElements]);
   std::fill(convOut.data(), convOut.data() + convOut.num_elements(), 0.0);
   const auto paddedKernelElements = product(paddedKernelSize);
-  for (unsigned gc = 0; gc != numConvGroups; ++gc) {
+  if (implementation == Implementation::NAIVE) {
+    for (unsigned gc = 0; gc != numConvGroups; ++gc) {
+      for (unsigned b = 0; b != batchSize; ++b) {
+        // Perform convolution.
+        for (unsigned oc = 0; oc != outputChannelsPerConvGroup; ++oc) {
+          unsigned ocAct = gc * outputChannelsPerConvGroup + oc;
+          for (unsigned oe = 0; oe != convOutElements; ++oe) {
+            auto outputIndices = unflattenIndex(convOutSize, oe);
+            for (unsigned ke = 0; ke != paddedKernelElements; ++ke) {
+              auto kernelIndices = unflattenIndex(paddedKernelSize, ke);
+              std::vector<unsigned> inputIndices;
+              if (getInputIndices(paddedFieldSize, paddedKernelSize,
+                                  outputIndices, kernelIndices,
+                                  inputIndices)) {
+                const auto ie = flattenIndex(paddedFieldSize, inputIndices);
+                for (unsigned ic = 0; ic != inputChannelsPerConvGroup; ++ic) {
+                  unsigned icAct = gc * inputChannelsPerConvGroup + ic;
+                  convOut[b][ocAct][oe] +=
+                      paddedKernel[gc][oc][ic][ke] * paddedIn[b][icAct][ie];
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  } else {
+    const ConvIndexTable table(paddedFieldSize, paddedKernelSize, convOutSize);
+    // Make the input channel the innermost dimension of both operands so the
+    // innermost loop reads contiguous memory.
+    const auto paddedFieldElements = product(paddedFieldSize);
+    std::vector<double> inT(batchSize * paddedFieldElements * inputChannels);
     for (unsigned b = 0; b != batchSize; ++b) {
-      // Perform convolution.
+      for (unsigned ic = 0; ic != inputChannels; ++ic) {
+        for (unsigned ie = 0; ie != paddedFieldElements; ++ie) {
+          inT[(b * paddedFieldElements + ie) * inputChannels + ic] =
+              paddedIn[b][ic][ie];
+        }
+      }
+    }
+    std::vector<double> kernelT(numConvGroups * outputChannelsPerConvGroup *
+                                paddedKernelElements *
+                                inputChannelsPerConvGroup);
+    for (unsigned gc = 0; gc != numConvGroups; ++gc) {
       for (unsigned oc = 0; oc != outputChannelsPerConvGroup; ++oc) {
-        unsigned ocAct = gc * outputChannelsPerConvGroup + oc;
-        for (unsigned oe = 0; oe != convOutElements; ++oe) {
-          auto outputIndices = unflattenIndex(convOutSize, oe);
+        for (unsigned ic = 0; ic != inputChannelsPerConvGroup; ++ic) {
           for (unsigned ke = 0; ke != paddedKernelElements; ++ke) {
-            auto kernelIndices = unflattenIndex(paddedKernelSize, ke);
-            std::vector<unsigned> inputIndices;
-            if (getInputIndices(paddedFieldSize, paddedKernelSize,
-                                outputIndices, kernelIndices, inputIndices)) {
-              const auto ie = flattenIndex(paddedFieldSize, inputIndices);
-              for (unsigned ic = 0; ic != inputChannelsPerConvGroup; ++ic) {
-                unsigned icAct = gc * inputChannelsPerConvGroup + ic;
-                convOut[b][ocAct][oe] +=
-                    paddedKernel[gc][oc][ic][ke] * paddedIn[b][icAct][ie];
-              }
-            }
+            kernelT[((gc * outputChannelsPerConvGroup + oc) *
+                         paddedKernelElements +
+                     ke) *
+                        inputChannelsPerConvGroup +
+                    ic] = paddedKernel[gc][oc][ic][ke];
           }
         }
       }
     }
+    // Each output channel of each batch element is computed independently.
+    tbb::parallel_for(
+        std::size_t(0), numConvGroups * batchSize * outputChannelsPerConvGroup,
+        [&](std::size_t i) {
+          const unsigned oc = i % outputChannelsPerConvGroup;
+          const unsigned b = (i / outputChannelsPerConvGroup) % batchSize;
+          const unsigned gc = i / (outputChannelsPerConvGroup * batchSize);
+          const unsigned ocAct = gc * outputChannelsPerConvGroup + oc;
+          const double *kernelOc =
+              &kernelT[(gc * outputChannelsPerConvGroup + oc) *
+                       paddedKernelElements * inputChannelsPerConvGroup];
+          const double *inB = &inT[b * paddedFieldElements * inputChannels +
+                                   gc * inputChannelsPerConvGroup];
+          double *out =
+              convOut.data() + (b * outputChannels + ocAct) * convOutElements;
+          for (unsigned oe = 0; oe != convOutElements; ++oe) {
+            double sum = 0.0;
+            for (auto it = table.entriesBegin(oe), end = table.entriesEnd(oe);
+                 it != end; ++it) {
+              const double *k =
+                  kernelOc + it->first * inputChannelsPerConvGroup;
+              const double *x = inB + it->second * inputChannels;
+              for (unsigned ic = 0; ic != inputChannelsPerConvGroup; ++ic) {
+                sum += k[ic] * x[ic];
+              }
+            }
+            out[oe] = sum;
+          }
+        });
   }
 
   std::vector<bool> noFlipping(numFieldDims);
@@ -588,7 +698,8 @@ void poplibs_test::conv::convolutionBackward(
     const std::vector<unsigned> &outputPaddingUpper,
     boost::const_multi_array_ref<double, 3> deltasIn,
     boost::const_multi_array_ref<double, 4> kernel,
-    boost::multi_array_ref<double, 3> deltasOut) {
+    boost::multi_array_ref<double, 3> deltasOut,
+    Implementation implementation) {
   if (fwdInputFieldSize.size() != truncationLower.size() ||
       fwdInputFieldSize.size() != truncationUpper.size() ||
       fwdInputFieldSize.size() != inputDilation.size() ||
@@ -685,29 +796,70 @@ void poplibs_test::conv::convolutionBackward(
       boost::extents[batchSize][fwdInputChannels][fwdPaddedInElements]);
   std::fill(convOut.data(), convOut.data() + convOut.num_elements(), 0.0);
   const auto paddedKernelElements = product(paddedKernelSize);
-  for (unsigned gc = 0; gc != numConvGroups; ++gc) {
-    for (unsigned b = 0; b != batchSize; ++b) {
-      // Perform convolution.
-      for (unsigned oc = 0; oc != fwdOutputChannelsPerConvGroup; ++oc) {
-        unsigned ocAct = gc * fwdOutputChannelsPerConvGroup + oc;
-        for (unsigned oe = 0; oe != fwdConvOutElements; ++oe) {
-          auto outputIndices = unflattenIndex(fwdConvOutSize, oe);
-          for (unsigned ke = 0; ke != paddedKernelElements; ++ke) {
-            auto kernelIndices = unflattenIndex(paddedKernelSize, ke);
-            std::vector<unsigned> inputIndices;
-            if (getInputIndices(fwdPaddedInSize, paddedKernelSize,
-                                outputIndices, kernelIndices, inputIndices)) {
-              const auto ie = flattenIndex(fwdPaddedInSize, inputIndices);
-              for (unsigned ic = 0; ic != fwdInputChannelsPerConvGroup; ++ic) {
-                unsigned icAct = gc * fwdInputChannelsPerConvGroup + ic;
-                convOut[b][icAct][ie] +=
-                    paddedKernel[gc][oc][ic][ke] * paddedDeltasIn[b][ocAct][oe];
+  if (implementation == Implementation::NAIVE) {
+    for (unsigned gc = 0; gc != numConvGroups; ++gc) {
+      for (unsigned b = 0; b != batchSize; ++b) {
+        // Perform convolution.
+        for (unsigned oc = 0; oc != fwdOutputChannelsPerConvGroup; ++oc) {
+          unsigned ocAct = gc * fwdOutputChannelsPerConvGroup + oc;
+          for (unsigned oe = 0; oe != fwdConvOutElements; ++oe) {
+            auto outputIndices = unflattenIndex(fwdConvOutSize, oe);
+            for (unsigned ke = 0; ke != paddedKernelElements; ++ke) {
+              auto kernelIndices = unflattenIndex(paddedKernelSize, ke);
+              std::vector<unsigned> inputIndices;
+              if (getInputIndices(fwdPaddedInSize, paddedKernelSize,
+                                  outputIndices, kernelIndices,
+                                  inputIndices)) {
+                const auto ie = flattenIndex(fwdPaddedInSize, inputIndices);
+                for (unsigned ic = 0; ic != fwdInputChannelsPerConvGroup;
+                     ++ic) {
+                  unsigned icAct = gc * fwdInputChannelsPerConvGroup + ic;
+                  convOut[b][icAct][ie] += paddedKernel[gc][oc][ic][ke] *
+                                           paddedDeltasIn[b][ocAct][oe];
+                }
               }
             }
           }
         }
       }
     }
+  } else {
+    const ConvIndexTable table(fwdPaddedInSize, paddedKernelSize,
+                               fwdConvOutSize);
+    // Each input channel of each batch element is computed independently.
+    // The contributions to each element are accumulated in the same order as
+    // the naive loop nest, which visits the input channel innermost.
+    tbb::parallel_for(
+        std::size_t(0),
+        numConvGroups * batchSize * fwdInputChannelsPerConvGroup,
+        [&](std::size_t i) {
+          const unsigned ic = i % fwdInputChannelsPerConvGroup;
+          const unsigned b = (i / fwdInputChannelsPerConvGroup) % batchSize;
+          const unsigned gc = i / (fwdInputChannelsPerConvGroup * batchSize);
+          const unsigned icAct = gc * fwdInputChannelsPerConvGroup + ic;
+          double *out = convOut.data() +
+                        (b * fwdInputChannels + icAct) * fwdPaddedInElements;
+          for (unsigned oc = 0; oc != fwdOutputChannelsPerConvGroup; ++oc) {
+            const unsigned ocAct = gc * fwdOutputChannelsPerConvGroup + oc;
+            const double *k =
+                paddedKernel.data() +
+                ((gc * fwdOutputChannelsPerConvGroup + oc) *
+                     fwdInputChannelsPerConvGroup +
+                 ic) *
+                    paddedKernelElements;
+            const double *deltas =
+                paddedDeltasIn.data() +
+                (b * fwdOutputChannels + ocAct) * paddedDeltasIn.shape()[2];
+            for (unsigned oe = 0; oe != fwdConvOutElements; ++oe) {
+              const double d = deltas[oe];
+              for (auto it = table.entriesBegin(oe),
+                        end = table.entriesEnd(oe);
+                   it != end; ++it) {
+                out[it->second] += k[it->first] * d;
+              }
+            }
+          }
+        });
   }
   deltasOut = truncateDilatePadAndFlipActivationsInverse(
       convOut, fwdPaddedInSize, truncationLower, truncationUpper, inputDilation,
@@ -736,7 +888,7 @@ void poplibs_test::conv::weightUpdate(
     boost::const_multi_array_ref<double, 3> activations,
     boost::const_multi_array_ref<double, 3> deltas,
     boost::multi_array_ref<double, 4> kernel,
-    boost::multi_array_ref<double, 1> biases) {
+    boost::multi_array_ref<double, 1> biases, Implementation implementation) {
   if (inputFieldSize.size() != truncationLower.size() ||
       inputFieldSize.size() != truncationUpper.size() ||
       inputFieldSize.size() != inputDilation.size() ||
@@ -827,30 +979,74 @@ void poplibs_test::conv::weightUpdate(
   std::fill(paddedWeightDeltas.data(),
             paddedWeightDeltas.data() + paddedWeightDeltas.num_elements(), 0.0);
   const auto paddedDeltasElements = product(fwdConvOutSize);
-  for (unsigned gc = 0; gc != numConvGroups; ++gc) {
-    for (unsigned b = 0; b != batchSize; ++b) {
-      // Perform convolution.
-      for (unsigned oc = 0; oc != outputChannelsPerConvGroup; ++oc) {
-        unsigned ocAct = gc * outputChannelsPerConvGroup + oc;
-        for (unsigned oe = 0; oe != paddedDeltasElements; ++oe) {
-          auto outputIndices = unflattenIndex(fwdConvOutSize, oe);
-          for (unsigned ke = 0; ke != paddedKernelElements; ++ke) {
-            auto kernelIndices = unflattenIndex(paddedKernelSize, ke);
-            std::vector<unsigned> inputIndices;
-            if (getInputIndices(paddedActivationsSize, paddedKernelSize,
-                                outputIndices, kernelIndices, inputIndices)) {
-              const auto ie = flattenIndex(paddedActivationsSize, inputIndices);
-              for (unsigned ic = 0; ic != inputChannelsPerConvGroup; ++ic) {
-                unsigned icAct = gc * inputChannelsPerConvGroup + ic;
-                paddedWeightDeltas[gc][oc][ic][ke] +=
-                    paddedActivations[b][icAct][ie] *
-                    paddedDeltas[b][ocAct][oe];
+  if (implementation == Implementation::NAIVE) {
+    for (unsigned gc = 0; gc != numConvGroups; ++gc) {
+      for (unsigned b = 0; b != batchSize; ++b) {
+        // Perform convolution.
+        for (unsigned oc = 0; oc != outputChannelsPerConvGroup; ++oc) {
+          unsigned ocAct = gc * outputChannelsPerConvGroup + oc;
+          for (unsigned oe = 0; oe != paddedDeltasElements; ++oe) {
+            auto outputIndices = unflattenIndex(fwdConvOutSize, oe);
+            for (unsigned ke = 0; ke != paddedKernelElements; ++ke) {
+              auto kernelIndices = unflattenIndex(paddedKernelSize, ke);
+              std::vector<unsigned> inputIndices;
+              if (getInputIndices(paddedActivationsSize, paddedKernelSize,
+                                  outputIndices, kernelIndices,
+                                  inputIndices)) {
+                const auto ie =
+                    flattenIndex(paddedActivationsSize, inputIndices);
+                for (unsigned ic = 0; ic != inputChannelsPerConvGroup; ++ic) {
+                  unsigned icAct = gc * inputChannelsPerConvGroup + ic;
+                  paddedWeightDeltas[gc][oc][ic][ke] +=
+                      paddedActivations[b][icAct][ie] *
+                      paddedDeltas[b][ocAct][oe];
+                }
               }
             }
           }
         }
       }
     }
+  } else {
+    const ConvIndexTable table(paddedActivationsSize, paddedKernelSize,
+                               fwdConvOutSize);
+    // Each (output channel, input channel) pair of weights is computed
+    // independently. The contributions to each weight are accumulated in the
+    // same order as the naive loop nest.
+    tbb::parallel_for(
+        std::size_t(0),
+        numConvGroups * outputChannelsPerConvGroup * inputChannelsPerConvGroup,
+        [&](std::size_t i) {
+          const unsigned ic = i % inputChannelsPerConvGroup;
+          const unsigned oc = (i / inputChannelsPerConvGroup) %
+                              outputChannelsPerConvGroup;
+          const unsigned gc =
+              i / (inputChannelsPerConvGroup * outputChannelsPerConvGroup);
+          const unsigned icAct = gc * inputChannelsPerConvGroup + ic;
+          const unsigned ocAct = gc * outputChannelsPerConvGroup + oc;
+          double *weightDeltas =
+              paddedWeightDeltas.data() +
+              ((gc * outputChannelsPerConvGroup + oc) *
+                   inputChannelsPerConvGroup +
+               ic) *
+                  paddedKernelElements;
+          for (unsigned b = 0; b != batchSize; ++b) {
+            const double *acts =
+                paddedActivations.data() +
+                (b * inputChannels + icAct) * paddedActivations.shape()[2];
+            const double *deltas =
+                paddedDeltas.data() +
+                (b * outputChannels + ocAct) * paddedDeltas.shape()[2];
+            for (unsigned oe = 0; oe != paddedDeltasElements; ++oe) {
+              const double d = deltas[oe];
+              for (auto it = table.entriesBegin(oe),
+                        end = table.entriesEnd(oe);
+                   it != end; ++it) {
+                weightDeltas[it->first] += acts[it->second] * d;
+              }
+            }
+          }
+        });
   }
 
   auto weightDeltas = truncateDilatePadAndFlipKernelInverse(
@@ -3,6 +3,93 @@
 #include <poplibs_test/GeneralMatrixMultiply.hpp>
 #include <poplibs_test/exceptions.hpp>
 
+#include <tbb/blocked_range2d.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <vector>
+
+using poplibs_test::gemm::Implementation;
+
+namespace {
+
+// The size of the blocks of the result computed by each task.
+constexpr std::size_t rowsPerBlock = 32;
+constexpr std::size_t colsPerBlock = 256;
+// The number of elements of the inner dimension accumulated into a block of
+// the result before moving on to the next row of the block. This keeps the
+// rows of op(B) that are used in cache.
+constexpr std::size_t innerPerBlock = 128;
+
+// Return op(mat) as a dense row-major array with the specified number of rows
+// and columns, where op(mat) = mat' if transpose is true and mat otherwise.
+// Only transposed matrices are copied.
+const double *getRowMajor(const double *mat, std::size_t rows,
+                          std::size_t cols, bool transpose,
+                          std::vector<double> &buffer) {
+  if (!transpose) {
+    return mat;
+  }
+  buffer.resize(rows * cols);
+  for (std::size_t r = 0; r != rows; ++r) {
+    for (std::size_t c = 0; c != cols; ++c) {
+      buffer[r * cols + c] = mat[c * rows + r];
+    }
+  }
+  return buffer.data();
+}
+
+// Compute out = op(matA) * op(matB) where op(matA) is m x k, op(matB) is
+// k x n and all the matrices are dense and row-major.
+void blockedMatrixMultiply(const double *matA, const double *matB,
+                           double *out, std::size_t m, std::size_t n,
+                           std::size_t k, bool transposeA, bool transposeB) {
+  std::vector<double> bufferA, bufferB;
+  const auto a = getRowMajor(matA, m, k, transposeA, bufferA);
+  const auto b = getRowMajor(matB, k, n, transposeB, bufferB);
+  std::fill(out, out + m * n, 0.0);
+  using Range = tbb::blocked_range2d<std::size_t>;
+  tbb::parallel_for(
+      Range(0, m, rowsPerBlock, 0, n, colsPerBlock), [&](const Range &r) {
+        const auto colBegin = r.cols().begin();
+        const auto colEnd = r.cols().end();
+        // Every element accumulates the products in increasing order of the
+        // inner dimension, as the naive implementation does, so the rounding
+        // errors are the same.
+        for (std::size_t kBegin = 0; kBegin < k; kBegin += innerPerBlock) {
+          const auto kEnd = std::min(k, kBegin + innerPerBlock);
+          for (auto i = r.rows().begin(); i != r.rows().end(); ++i) {
+            const double *aRow = a + i * k;
+            double *outRow = out + i * n;
+            for (auto kIdx = kBegin; kIdx != kEnd; ++kIdx) {
+              const double aik = aRow[kIdx];
+              const double *bRow = b + kIdx * n;
+              for (auto j = colBegin; j != colEnd; ++j) {
+                outRow[j] += aik * bRow[j];
+              }
+            }
+          }
+        }
+      });
+}
+
+// Return whether the data of the array is dense and row-major, which the
+// blocked implementation requires. Other layouts use the naive
+// implementation, which indexes the arrays.
+template <std::size_t N>
+bool isDenseRowMajor(const boost::multi_array_ref<double, N> &a) {
+  boost::multi_array_types::index stride = 1;
+  for (std::size_t dim = N; dim != 0; --dim) {
+    if (a.shape()[dim - 1] != 1 && a.strides()[dim - 1] != stride) {
+      return false;
+    }
+    stride *= static_cast<boost::multi_array_types::index>(a.shape()[dim - 1]);
+  }
+  return true;
+}
+
+} // end anonymous namespace
+
 void poplibs_test::gemm::hadamardProduct(
     const boost::multi_array_ref<double, 1> matA,
     const boost::multi_array_ref<double, 1> matB,
@@ -91,7 +178,7 @@ void poplibs_test::gemm::generalMatrixMultiply(
     const boost::multi_array_ref<double, 2> matB,
     const boost::multi_array_ref<double, 2> matC,
     boost::multi_array_ref<double, 2> matD, float alpha, float beta,
-    bool transposeA, bool transposeB) {
+    bool transposeA, bool transposeB, Implementation implementation) {
 
   const auto matACols = matA.shape()[1];
   const auto matARows = matA.shape()[0];
@@ -120,6 +207,20 @@ void poplibs_test::gemm::generalMatrixMultiply(
     assert(matBCols == n);
   }
 
+  if (implementation == Implementation::BLOCKED && isDenseRowMajor(matA) &&
+      isDenseRowMajor(matB)) {
+    std::vector<double> acc(m * n);
+    blockedMatrixMultiply(matA.data(), matB.data(), acc.data(), m, n, k,
+                          transposeA, transposeB);
+    for (unsigned mIdx = 0; mIdx != m; ++mIdx) {
+      for (unsigned nIdx = 0; nIdx != n; ++nIdx) {
+        matD[mIdx][nIdx] =
+            beta * matC[mIdx][nIdx] + alpha * acc[mIdx * n + nIdx];
+      }
+    }
+    return;
+  }
+
   for (unsigned mIdx = 0; mIdx != m; ++mIdx) {
     for (unsigned nIdx = 0; nIdx != n; ++nIdx) {
       double acc = 0;
@@ -137,7 +238,7 @@ void poplibs_test::gemm::generalGroupedMatrixMultiply(
     const boost::multi_array_ref<double, 3> matB,
     const boost::multi_array_ref<double, 3> matC,
     boost::multi_array_ref<double, 3> matD, float alpha, float beta,
-    bool transposeA, bool transposeB) {
+    bool transposeA, bool transposeB, Implementation implementation) {
 
   const auto matAGroups = matA.shape()[0];
   const auto matACols = matA.shape()[2];
@@ -172,6 +273,23 @@ void poplibs_test::gemm::generalGroupedMatrixMultiply(
     assert(matBCols == n);
   }
 
+  if (implementation == Implementation::BLOCKED && isDenseRowMajor(matA) &&
+      isDenseRowMajor(matB)) {
+    std::vector<double> acc(m * n);
+    for (unsigned gIdx = 0; gIdx != g; ++gIdx) {
+      blockedMatrixMultiply(matA.data() + gIdx * m * k,
+                            matB.data() + gIdx * k * n, acc.data(), m, n, k,
+                            transposeA, transposeB);
+      for (unsigned mIdx = 0; mIdx != m; ++mIdx) {
+        for (unsigned nIdx = 0; nIdx != n; ++nIdx) {
+          matD[gIdx][mIdx][nIdx] =
+              beta * matC[gIdx][mIdx][nIdx] + alpha * acc[mIdx * n + nIdx];
+        }
+      }
+    }
+    return;
+  }
+
   for (unsigned gIdx = 0; gIdx != g; ++gIdx) {
     for (unsigned mIdx = 0; mIdx != m; ++mIdx) {
       for (unsigned nIdx = 0; nIdx != n; ++nIdx) {
@@ -190,7 +308,8 @@ void poplibs_test::gemm::generalGroupedMatrixMultiply(
 void poplibs_test::gemm::generalMatrixMultiply(
     const boost::multi_array_ref<double, 2> matA,
     const boost::multi_array_ref<double, 2> matB,
-    boost::multi_array_ref<double, 2> matC, bool transposeA, bool transposeB) {
+    boost::multi_array_ref<double, 2> matC, bool transposeA, bool transposeB,
+    Implementation implementation) {
 
   const auto matACols = matA.shape()[1];
   const auto matARows = matA.shape()[0];
@@ -219,6 +338,13 @@ void poplibs_test::gemm::generalMatrixMultiply(
     assert(matBCols == n);
   }
 
+  if (implementation == Implementation::BLOCKED && isDenseRowMajor(matA) &&
+      isDenseRowMajor(matB) && isDenseRowMajor(matC)) {
+    blockedMatrixMultiply(matA.data(), matB.data(), matC.data(), m, n, k,
+                          transposeA, transposeB);
+    return;
+  }
+
   for (unsigned mIdx = 0; mIdx != m; ++mIdx) {
     for (unsigned nIdx = 0; nIdx != n; ++nIdx) {
       double acc = 0;
@@ -234,7 +360,8 @@ void poplibs_test::gemm::generalMatrixMultiply(
 void poplibs_test::gemm::generalGroupedMatrixMultiply(
     const boost::multi_array_ref<double, 3> matA,
     const boost::multi_array_ref<double, 3> matB,
-    boost::multi_array_ref<double, 3> matC, bool transposeA, bool transposeB) {
+    boost::multi_array_ref<double, 3> matC, bool transposeA, bool transposeB,
+    Implementation implementation) {
   const auto matACols = matA.shape()[2];
   const auto matARows = matA.shape()[1];
 #ifndef NDEBUG
@@ -268,6 +395,17 @@ void poplibs_test::gemm::generalGroupedMatrixMultiply(
     assert(matBCols == n);
   }
 
+  if (implementation == Implementation::BLOCKED && isDenseRowMajor(matA) &&
+      isDenseRowMajor(matB) && isDenseRowMajor(matC)) {
+    for (unsigned gIdx = 0; gIdx != g; ++gIdx) {
+      blockedMatrixMultiply(matA.data() + gIdx * m * k,
+                            matB.data() + gIdx * k * n,
+                            matC.data() + gIdx * m * n, m, n, k, transposeA,
+                            transposeB);
+    }
+    return;
+  }
+
   for (unsigned gIdx = 0; gIdx != g; ++gIdx) {
     for (unsigned mIdx = 0; mIdx != m; ++mIdx) {
       for (unsigned nIdx = 0; nIdx != n; ++nIdx) {
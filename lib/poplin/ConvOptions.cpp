@@ -28,6 +28,10 @@ std::map<std::string, Pass> passMap{
 std::map<std::string, poplar::Type> partialsTypeMap{{"half", poplar::HALF},
                                                     {"float", poplar::FLOAT}};
 
+std::map<std::string, popsolver::SearchStrategy> searchStrategyMap{
+    {"linear", popsolver::SearchStrategy::LINEAR},
+    {"bisect", popsolver::SearchStrategy::BISECT}};
+
 std::ostream &operator<<(std::ostream &os, const Pass p) {
   switch (p) {
   case Pass::NONE:
@@ -80,7 +84,9 @@ std::ostream &operator<<(std::ostream &os, const ConvOptions &opts) {
   os << "        remapOutputTensor             ";
   os << opts.remapOutputTensor;
   os << "        enableConvDithering           ";
-  os << opts.enableConvDithering;
+  os << opts.enableConvDithering << "\n";
+  os << "        plannerSearchStrategy         ";
+  os << opts.plannerSearchStrategy;
   return os;
 }
 
@@ -119,7 +125,10 @@ void ConvOptions::parseConvOptions(const poplar::OptionFlags &options) {
        OptionHandler::createWithBool(enableSingleInputReduce)},
       {"remapOutputTensor", OptionHandler::createWithBool(remapOutputTensor)},
       {"enableConvDithering",
-       OptionHandler::createWithBool(enableConvDithering)}};
+       OptionHandler::createWithBool(enableConvDithering)},
+      {"plannerSearchStrategy",
+       OptionHandler::createWithEnum(plannerSearchStrategy,
+                                     searchStrategyMap)}};
   for (const auto &entry : options) {
     convSpec.parse(entry.first, entry.second);
   }
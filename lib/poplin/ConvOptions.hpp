@@ -2,8 +2,10 @@
 #ifndef poplin_internal_ConvOptions_hpp
 #define poplin_internal_ConvOptions_hpp
 
+#include "poplibs_support/Fingerprint.hpp"
 #include "poplibs_support/PlanConstraints.hpp"
 #include "poplibs_support/StructHelper.hpp"
+#include "popsolver/Model.hpp"
 #include <poplar/Target.hpp>
 #include <poplar/Type.hpp>
 #include <string>
@@ -59,6 +61,9 @@ public:
   // Use the ConvParams to pseudo-randomly select a start tile and direction
   // to lay out the convolution across the tiles.
   bool enableConvDithering = false;
+  // The strategy the planner's solver uses to search for the best plan.
+  popsolver::SearchStrategy plannerSearchStrategy =
+      popsolver::SearchStrategy::LINEAR;
 
   void parseConvOptions(const poplar::OptionFlags &options);
 
@@ -72,7 +77,7 @@ private:
       &ConvOptions::enableAmpHalfEnginesPlan,
       &ConvOptions::enableMultiStageReduce, &ConvOptions::enableFastReduce,
       &ConvOptions::enableSingleInputReduce, &ConvOptions::remapOutputTensor,
-      &ConvOptions::enableConvDithering);
+      &ConvOptions::enableConvDithering, &ConvOptions::plannerSearchStrategy);
 
 public:
   bool operator<(const ConvOptions &other) const {
@@ -83,6 +88,11 @@ public:
     return helper.eq(*this, other);
   }
 
+  friend void addToFingerprint(poplibs_support::Fingerprint &f,
+                               const ConvOptions &options) {
+    helper.forEach(options, [&](const auto &member) { f.add(member); });
+  }
+
   ConvOptions(unsigned numIPUs, unsigned tilesPerIPU,
               const poplar::OptionFlags &options)
       : numIPUs(numIPUs), tilesPerIPU(tilesPerIPU) {
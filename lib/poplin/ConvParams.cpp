@@ -1,6 +1,7 @@
 // Copyright (c) 2019 Graphcore Ltd. All rights reserved.
 #include "poplin/ConvParams.hpp"
 #include "ConvUtilInternal.hpp"
+#include "poplibs_support/Fingerprint.hpp"
 #include "poplibs_support/StructHelper.hpp"
 #include "poplibs_support/print.hpp"
 #include "poplin/ConvUtil.hpp"
@@ -310,6 +311,21 @@ std::size_t hash_value(const ConvParams::OutputTransform &ot) {
   return std::hash<ConvParams::OutputTransform>()(ot);
 }
 
+void addToFingerprint(poplibs_support::Fingerprint &f,
+                      const ConvParams::InputTransform &it) {
+  inputTransformHelper.forEach(it, [&](const auto &member) { f.add(member); });
+}
+
+void addToFingerprint(poplibs_support::Fingerprint &f,
+                      const ConvParams::OutputTransform &ot) {
+  outputTransformHelper.forEach(ot,
+                                [&](const auto &member) { f.add(member); });
+}
+
+void addToFingerprint(poplibs_support::Fingerprint &f, const ConvParams &p) {
+  convParamsHelper.forEach(p, [&](const auto &member) { f.add(member); });
+}
+
 ConvParams ConvParams::canonicalize() const {
   validate();
   ConvParams newParams = *this;
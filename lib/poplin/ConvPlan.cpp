@@ -9,6 +9,7 @@
 #include "poplar/Graph.hpp"
 #include "poplibs_support/Algorithm.hpp"
 #include "poplibs_support/Compiler.hpp"
+#include "poplibs_support/Fingerprint.hpp"
 #include "poplibs_support/TileHierarchy.hpp"
 #include "poplibs_support/VectorUtils.hpp"
 #include "poplibs_support/gcd.hpp"
@@ -16,6 +17,7 @@
 #include "poplibs_support/print.hpp"
 #include "poplin/ConvUtil.hpp"
 #include "poplin/Convolution.hpp"
+#include "popsolver/CallMemo.hpp"
 #include "popsolver/Model.hpp"
 #include "poputil/exceptions.hpp"
 
@@ -23,14 +25,28 @@
 #include "tbb/parallel_for.h"
 
 #include <boost/functional/hash.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/range/adaptor/filtered.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <sstream>
 #include <string>
 #include <tuple>
 #include <type_traits>
@@ -379,15 +395,24 @@ static const char *asString(Plan::Method m) {
   POPLIB_UNREACHABLE();
 }
 
+template <typename T>
+static void addToFingerprint(Fingerprint &f, const Split<T> &split) {
+  f.add(split.serial).add(split.parallel);
+}
+
+static constexpr auto partitionHelper = poplibs_support::makeStructHelper(
+    &Partition::fieldSplit, &Partition::batchSplit, &Partition::outChanSplit,
+    &Partition::kernelSplit, &Partition::inChanSplit,
+    &Partition::convGroupSplit, &Partition::fieldAxisGrainSize,
+    &Partition::convGroupGrainSize, &Partition::inChanGrainSize,
+    &Partition::outChanGrainSize);
+
 bool operator<(const Partition &a, const Partition &b) {
-  constexpr static auto helper = poplibs_support::makeStructHelper(
-      &Partition::fieldSplit, &Partition::batchSplit, &Partition::outChanSplit,
-      &Partition::kernelSplit, &Partition::inChanSplit,
-      &Partition::convGroupSplit, &Partition::fieldAxisGrainSize,
-      &Partition::convGroupGrainSize, &Partition::inChanGrainSize,
-      &Partition::outChanGrainSize);
+  return partitionHelper.lt(a, b);
+}
 
-  return helper.lt(a, b);
+static void addToFingerprint(Fingerprint &f, const Partition &p) {
+  partitionHelper.forEach(p, [&](const auto &member) { f.add(member); });
 }
 
 std::ostream &operator<<(std::ostream &os, const Partition &p) {
@@ -413,14 +438,18 @@ std::ostream &operator<<(std::ostream &os, const Partition &p) {
   return os;
 }
 
+static constexpr auto convTransformHelper = poplibs_support::makeStructHelper(
+    &ConvTransform::extraFieldDims, &ConvTransform::dilatePostConv,
+    &ConvTransform::swapOperands, &ConvTransform::expandDims,
+    &ConvTransform::outChanFlattenDims, &ConvTransform::flattenDims,
+    &ConvTransform::combineConvGroupsFactor);
+
 bool operator<(const ConvTransform &a, const ConvTransform &b) {
-  constexpr static auto helper = poplibs_support::makeStructHelper(
-      &ConvTransform::extraFieldDims, &ConvTransform::dilatePostConv,
-      &ConvTransform::swapOperands, &ConvTransform::expandDims,
-      &ConvTransform::outChanFlattenDims, &ConvTransform::flattenDims,
-      &ConvTransform::combineConvGroupsFactor);
+  return convTransformHelper.lt(a, b);
+}
 
-  return helper.lt(a, b);
+static void addToFingerprint(Fingerprint &f, const ConvTransform &t) {
+  convTransformHelper.forEach(t, [&](const auto &member) { f.add(member); });
 }
 
 std::ostream &operator<<(std::ostream &os, const ConvTransform &t) {
@@ -447,11 +476,15 @@ std::ostream &operator<<(std::ostream &os, const ConvTransform &t) {
   return os;
 }
 
+static constexpr auto convTypesHelper = poplibs_support::makeStructHelper(
+    &ConvTypes::partialType, &ConvTypes::resultType);
+
 bool operator<(const ConvTypes &a, const ConvTypes &b) {
-  constexpr static auto helper = poplibs_support::makeStructHelper(
-      &ConvTypes::partialType, &ConvTypes::resultType);
+  return convTypesHelper.lt(a, b);
+}
 
-  return helper.lt(a, b);
+static void addToFingerprint(Fingerprint &f, const ConvTypes &t) {
+  convTypesHelper.forEach(t, [&](const auto &member) { f.add(member); });
 }
 
 std::ostream &operator<<(std::ostream &os, const ConvTypes &t) {
@@ -496,15 +529,17 @@ std::ostream &operator<<(std::ostream &os, Plan::LinearizeTileDirection d) {
                                std::to_string(id) + ">");
 }
 
-bool operator<(const Plan &a, const Plan &b) {
-  constexpr static auto helper = poplibs_support::makeStructHelper(
-      &Plan::transforms, &Plan::partitions, &Plan::types,
-      &Plan::convGroupsPerGroup, &Plan::inChansPerGroup,
-      &Plan::partialChansPerGroup, &Plan::slicWindowWidth,
-      &Plan::numConvUnitsRequired, &Plan::method, &Plan::linearizeTileOrder,
-      &Plan::startTile, &Plan::linearizeTileDirection, &Plan::isJointPlan);
+static constexpr auto planHelper = poplibs_support::makeStructHelper(
+    &Plan::transforms, &Plan::partitions, &Plan::types,
+    &Plan::convGroupsPerGroup, &Plan::inChansPerGroup,
+    &Plan::partialChansPerGroup, &Plan::slicWindowWidth,
+    &Plan::numConvUnitsRequired, &Plan::method, &Plan::linearizeTileOrder,
+    &Plan::startTile, &Plan::linearizeTileDirection, &Plan::isJointPlan);
 
-  return helper.lt(a, b);
+bool operator<(const Plan &a, const Plan &b) { return planHelper.lt(a, b); }
+
+static void addToFingerprint(Fingerprint &f, const Plan &p) {
+  planHelper.forEach(p, [&](const auto &member) { f.add(member); });
 }
 
 std::ostream &operator<<(std::ostream &os, const Plan &p) {
@@ -881,6 +916,43 @@ std::ostream &operator<<(std::ostream &os, const Cost &c) {
   return os;
 }
 
+// Apply f(name, member) to every field of a Cost.
+template <typename CostT, typename F> void forEachCostField(CostT &c, F f) {
+  f("totalTiles", c.totalTiles);
+  f("totalCycles", c.totalCycles);
+  f("totalTempBytes", c.totalTempBytes);
+  f("totalPerStepCycleDiff", c.totalPerStepCycleDiff);
+  f("rearrangeBeforeSliceCycles", c.rearrangeBeforeSliceCycles);
+  f("memsetZeroBeforeAddInPlace", c.memsetZeroBeforeAddInPlace);
+  f("dynamicSliceCycles", c.dynamicSliceCycles);
+  f("transformCycles", c.transformCycles);
+  f("totalExchangeCycles", c.totalExchangeCycles);
+  f("inputExchangeCycles", c.itemisedExchangeCycles.inputExchangeCycles);
+  f("weightExchangeCycles", c.itemisedExchangeCycles.weightExchangeCycles);
+  f("reduceFirstStageExchangeCycles",
+    c.itemisedExchangeCycles.reduceFirstStageExchangeCycles);
+  f("reduceRemainingStagesExchangeCycles",
+    c.itemisedExchangeCycles.reduceRemainingStagesExchangeCycles);
+  f("tileLevelTransformCycles", c.tileLevelTransformCycles);
+  f("partialCalcCycles", c.partialCalcCycles);
+  f("reduceCycles", c.reduceCycles);
+  f("dynamicUpdateCycles", c.dynamicUpdateCycles);
+  f("addInPlaceCycles", c.addInPlaceCycles);
+  f("castCycles", c.castCycles);
+  f("rearrangeBeforeSliceTempBytes", c.rearrangeBeforeSliceTempBytes);
+  f("rearrangeBeforeSliceTempDuringRearrangeBytes",
+    c.rearrangeBeforeSliceTempDuringRearrangeBytes);
+  f("transformTempBytes", c.transformTempBytes);
+  f("tileLevelTransformTempBytes", c.tileLevelTransformTempBytes);
+  f("convTempBytes", c.convTempBytes);
+  f("reduceTempBytes", c.reduceTempBytes);
+  f("addInPlaceTempBytes", c.addInPlaceTempBytes);
+}
+
+static void addToFingerprint(Fingerprint &f, const Cost &c) {
+  forEachCostField(c, [&](const char *, unsigned value) { f.add(value); });
+}
+
 struct ConvDescription {
   // TODO pass only ConvDescriptions into the planner as the only source of
   // information to use, this will make sure the cache and planner are in
@@ -907,17 +979,85 @@ struct ConvDescription {
         minimizeForTiles{minimizeForTiles}, cycleLimit{cycleLimit},
         startTileIdxForVirtualHierarchy{startTileIdxForVirtualHierarchy} {}
 
-  bool operator<(const ConvDescription &other) const {
-    constexpr static auto helper = poplibs_support::makeStructHelper(
-        &ConvDescription::params, &ConvDescription::options,
-        &ConvDescription::referenceCost, &ConvDescription::referencePlan,
-        &ConvDescription::minimizeForTiles, &ConvDescription::cycleLimit,
-        &ConvDescription::startTileIdxForVirtualHierarchy);
+  bool operator==(const ConvDescription &other) const {
+    // Plans have no equality operator and the equality operator of costs
+    // only compares the totals, so they are compared by equivalence, which
+    // takes every field into account.
+    const auto equivalent = [](const auto &a, const auto &b) {
+      return !(a < b) && !(b < a);
+    };
+    return params == other.params && options == other.options &&
+           equivalent(referenceCost, other.referenceCost) &&
+           equivalent(referencePlan, other.referencePlan) &&
+           minimizeForTiles == other.minimizeForTiles &&
+           cycleLimit == other.cycleLimit &&
+           startTileIdxForVirtualHierarchy ==
+               other.startTileIdxForVirtualHierarchy;
+  }
+
+  // A 64-bit hash of every field that is the same in every process.
+  std::uint64_t fingerprint() const {
+    Fingerprint f;
+    f.add(*params).add(options).add(referenceCost).add(referencePlan);
+    f.add(minimizeForTiles).add(cycleLimit);
+    f.add(startTileIdxForVirtualHierarchy);
+    return f.get();
+  }
+
+  struct Hash {
+    std::size_t operator()(const ConvDescription &d) const {
+      return d.fingerprint();
+    }
+  };
+};
 
-    return helper.lt(*this, other);
-  }
+static PlanningStats &operator+=(PlanningStats &a, const PlanningStats &b) {
+  a.candidates += b.candidates;
+  a.solveSeconds += b.solveSeconds;
+  a.nodes += b.nodes;
+  a.propagations += b.propagations;
+  a.constraintEvaluations += b.constraintEvaluations;
+  a.backtracks += b.backtracks;
+  a.prunes += b.prunes;
+  return a;
+}
+
+// A read-only file of plans that is memory mapped rather than parsed, so that
+// it can be loaded cheaply and concurrently by many processes. Plans are found
+// by probing a hash table of serialized keys. See PlanningCacheImpl::
+// mergeIntoIndex() for how the files are written.
+class PlanIndex {
+public:
+  // Map the index at path. Throws if the file isn't a valid plan index.
+  explicit PlanIndex(const std::string &path);
+
+  std::uint64_t getTargetHash() const { return targetHash; }
+  std::size_t size() const { return numEntries; }
+
+  boost::optional<std::pair<Plan, Cost>> find(const std::string &key) const;
+
+  // Call f(key, payload, payloadWords) for each entry in the index.
+  template <typename F> void forEachEntry(F f) const;
+
+private:
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+  const char *data;
+  std::size_t dataSize;
+  std::uint64_t targetHash;
+  std::uint32_t numBuckets;
+  std::uint32_t numEntries;
+
+  // Read the entry at offset, checking that it lies within the file.
+  std::tuple<const char *, std::uint32_t, const std::uint32_t *, std::uint32_t>
+  readEntry(std::uint64_t offset) const;
 };
 
+// Limits on the number of partial calculation cycle estimate tables held by a
+// planning cache and on the number of entries in each of them.
+static constexpr std::size_t maxPartialCalcMemos = 256;
+static constexpr std::size_t maxPartialCalcMemoSize = 1 << 14;
+
 class PlanningCacheImpl {
 public:
   using Key = ConvDescription;
@@ -957,28 +1097,140 @@ public:
               getConvPartialSlicSupervisorCycleOuterLoopEstimate),
           mGetConvPartialSlicInnerLoopCycles(
               getConvPartialSlicInnerLoopCycles) {}
+
+    // Everything the partial calculation cycle estimate depends on other than
+    // the values of the solver variables: method, field grain size, conv
+    // groups per group, input channels per group, output channels per group,
+    // transformed dims (sorted), params, float partials, SLIC window width,
+    // number of conv units required, conv unit input load elements per cycle
+    // and the properties of the target the estimates use (number of worker
+    // contexts, data path width, conv unit coefficient load bytes per cycle,
+    // weights per conv unit and number of conv units). The same cache may be
+    // used to plan for different targets.
+    using PartialCalcKey =
+        std::tuple<Plan::Method, std::vector<unsigned>, unsigned, unsigned,
+                   unsigned, std::vector<unsigned>, ConvParams, bool, unsigned,
+                   unsigned, unsigned, unsigned, unsigned, unsigned, unsigned,
+                   unsigned>;
+    // Tables of the results of the partial calculation cycle estimates. Each
+    // table is shared by all the models that estimate the same vertex for
+    // the same convolution, for example the models of the candidates of a
+    // plan that only differ in the transforms of other levels.
+    tbb::concurrent_unordered_map<PartialCalcKey,
+                                  std::shared_ptr<popsolver::CallMemo>,
+                                  hash_tuple::hash<PartialCalcKey>>
+        partialCalcMemos;
+
+    // The tables live as long as the cache, so their number and size are
+    // limited. Once there are maxPartialCalcMemos tables, estimates for new
+    // keys get a table of their own that is dropped with their model.
+    std::shared_ptr<popsolver::CallMemo>
+    getPartialCalcMemo(const PartialCalcKey &key) {
+      const auto match = partialCalcMemos.find(key);
+      if (match != partialCalcMemos.end()) {
+        return match->second;
+      }
+      auto memo = std::make_shared<popsolver::CallMemo>(maxPartialCalcMemoSize);
+      if (partialCalcMemos.size() >= maxPartialCalcMemos) {
+        return memo;
+      }
+      // If another thread inserted a table for the same key first, use that.
+      return partialCalcMemos.insert({key, std::move(memo)}).first->second;
+    }
+
+    void logPartialCalcMemoStats() const {
+      std::uint64_t hits = 0, misses = 0;
+      for (const auto &entry : partialCalcMemos) {
+        hits += entry.second->hits();
+        misses += entry.second->misses();
+      }
+      const auto lookups = hits + misses;
+      logging::debug("Partial calculation estimates: {} tables, {} lookups, "
+                     "{:.1f}% hit rate",
+                     partialCalcMemos.size(), lookups,
+                     lookups == 0 ? 0.0 : 100.0 * hits / lookups);
+    }
+
+    // Counters describing the work done by all calls to the planner that used
+    // this cache.
+    void addPlanningStats(const PlanningStats &stats) {
+      std::lock_guard<std::mutex> lock(planningStatsMutex);
+      planningStats += stats;
+    }
+
+    PlanningStats getPlanningStats() const {
+      std::lock_guard<std::mutex> lock(planningStatsMutex);
+      return planningStats;
+    }
+
+  private:
+    mutable std::mutex planningStatsMutex;
+    PlanningStats planningStats;
   };
 
   // The plan's cycleEstimation can be used and updated in parallel.
   CycleEstimationImpl cycleEstimation;
 
 private:
-  // Updates to plans must be single-threaded.
-  std::map<Key, std::pair<Plan, Cost>> planCache;
+  // Plans can be looked up in parallel with other lookups and insertions.
+  tbb::concurrent_unordered_map<Key, std::pair<Plan, Cost>, Key::Hash>
+      planCache;
+
+  // Plans read from a plan cache file created for the current target, indexed
+  // by the serialized form of their key. These are consulted when a key is
+  // not found in planCache.
+  std::map<std::string, std::pair<Plan, Cost>> persistentPlans;
+  // Entries read from a plan cache file that were created for a different
+  // target. They are never used for planning but are written back out on
+  // save so that one file can be shared between targets.
+  std::vector<boost::property_tree::ptree> foreignEntries;
+  // Plan indices mapped by loadIndex(), consulted after persistentPlans.
+  std::vector<std::unique_ptr<PlanIndex>> planIndices;
 
 public:
   boost::optional<std::pair<Plan, Cost>> getPlan(const Key &key) {
     const auto plan = planCache.find(key);
-    if (plan == planCache.end()) {
-      return boost::none;
-    } else {
+    if (plan != planCache.end()) {
       return (*plan).second;
     }
+    if ((persistentPlans.empty() && planIndices.empty()) ||
+        !isPersistable(key)) {
+      return boost::none;
+    }
+    // Plans found here are added to planCache so that the key is only
+    // serialized the first time it is looked up.
+    const auto serializedKey = serializeKey(key);
+    const auto persistentPlan = persistentPlans.find(serializedKey);
+    if (persistentPlan != persistentPlans.end()) {
+      planCache.insert({key, persistentPlan->second});
+      return persistentPlan->second;
+    }
+    for (const auto &index : planIndices) {
+      if (auto indexedPlan = index->find(serializedKey)) {
+        planCache.insert({key, *indexedPlan});
+        return indexedPlan;
+      }
+    }
+    return boost::none;
   }
 
   void addPlanToCache(Key key, std::pair<Plan, Cost> value) {
-    planCache.emplace(std::move(key), std::move(value));
+    planCache.insert({std::move(key), std::move(value)});
   }
+
+  // Plans that were found relative to a reference plan or cost are only
+  // created as intermediate steps of multi-convolution planning and so are
+  // not written to disk.
+  static bool isPersistable(const Key &key) {
+    return !key.referencePlan && !key.referenceCost;
+  }
+  static std::string serializeKey(const Key &key);
+
+  void load(const poplar::Target &target, const std::string &path);
+  void save(const poplar::Target &target, const std::string &path) const;
+  void loadIndex(const poplar::Target &target, const std::string &path);
+  void mergeIntoIndex(const poplar::Target &target,
+                      const std::string &path) const;
 };
 
 PlanningCache::PlanningCache() {
@@ -987,6 +1239,783 @@ PlanningCache::PlanningCache() {
 
 PlanningCache::~PlanningCache() = default;
 
+void PlanningCache::load(const poplar::Target &target,
+                         const std::string &path) {
+  impl->load(target, path);
+}
+
+void PlanningCache::save(const poplar::Target &target,
+                         const std::string &path) const {
+  impl->save(target, path);
+}
+
+void PlanningCache::loadIndex(const poplar::Target &target,
+                              const std::string &path) {
+  impl->loadIndex(target, path);
+}
+
+void PlanningCache::mergeIntoIndex(const poplar::Target &target,
+                                   const std::string &path) const {
+  impl->mergeIntoIndex(target, path);
+}
+
+PlanningStats PlanningCache::getStats() const {
+  return impl->cycleEstimation.getPlanningStats();
+}
+
+// Version of the on-disk plan cache format. This must be incremented whenever
+// the planner changes in a way that would make previously cached plans
+// invalid, or the serialized form of the keys, plans or costs changes.
+static constexpr unsigned planCacheFormatVersion = 1;
+
+// A string that identifies the properties of the target that the planner
+// depends on. Plans are only reused on targets with an identical fingerprint.
+static std::string getTargetFingerprint(const poplar::Target &target) {
+  std::stringstream ss;
+  ss << "ipus=" << target.getNumIPUs()
+     << ";tiles=" << target.getTilesPerIPU()
+     << ";workers=" << target.getNumWorkerContexts()
+     << ";bytesPerTile=" << target.getBytesPerTile()
+     << ";dataPathWidth=" << target.getDataPathWidth()
+     << ";exchangeBytesPerCycle=" << target.getExchangeBytesPerCycle()
+     << ";memcpyBytesPerCycle=" << target.getMemcpyBytesPerCycle()
+     << ";tilesPerSharedExchangeBus=" << target.getTilesPerSharedExchangeBus()
+     << ";convUnits=" << target.getFp16InFp16OutConvUnitsPerTile() << ","
+     << target.getFp16InFp32OutConvUnitsPerTile() << ","
+     << target.getFp32InFp32OutConvUnitsPerTile()
+     << ";weightsPerConvUnit=" << target.getWeightsPerConvUnit(false) << ","
+     << target.getWeightsPerConvUnit(true)
+     << ";convUnitInputLoadElemsPerCycle="
+     << target.getFp16ConvUnitInputLoadElemsPerCycle() << ","
+     << target.getFp32ConvUnitInputLoadElemsPerCycle()
+     << ";convUnitCoeffLoadBytesPerCycle="
+     << target.getConvUnitCoeffLoadBytesPerCycle();
+  return ss.str();
+}
+
+std::string PlanningCacheImpl::serializeKey(const Key &key) {
+  assert(isPersistable(key));
+  const auto &p = *key.params;
+  const auto &o = key.options;
+  std::stringstream ss;
+  ss.precision(std::numeric_limits<double>::max_digits10);
+  const auto printField = [&](const auto &container) {
+    ss << ",";
+    printContainer(container, ss);
+  };
+  ss << "params:" << p.inputType << "," << p.outputType << "," << p.batchSize;
+  printField(p.inputFieldShape);
+  printField(p.kernelShape);
+  ss << "," << p.inputChannelsPerConvGroup << ","
+     << p.outputChannelsPerConvGroup << "," << p.numConvGroups;
+  for (const auto *t : {&p.inputTransform, &p.kernelTransform}) {
+    printField(t->truncationLower);
+    printField(t->truncationUpper);
+    printField(t->dilation);
+    printField(t->paddingLower);
+    printField(t->paddingUpper);
+    printField(t->flip);
+  }
+  printField(p.outputTransform.truncationLower);
+  printField(p.outputTransform.truncationUpper);
+  printField(p.outputTransform.stride);
+  printField(p.outputTransform.paddingLower);
+  printField(p.outputTransform.paddingUpper);
+  ss << ";options:" << o.numIPUs << "," << o.tilesPerIPU << ","
+     << o.availableMemoryProportion << "," << o.pass << "," << o.partialsType
+     << "," << o.interTilePartialsType << "," << o.interIpuPartialsType << ","
+     << o.use128BitConvUnitLoad << "," << o.planConstraintsOutputFilename
+     << "," << o.enableAmpHalfEnginesPlan << "," << o.enableMultiStageReduce
+     << "," << o.enableFastReduce << "," << o.enableSingleInputReduce << ","
+     << o.remapOutputTensor << "," << o.enableConvDithering << ","
+     << o.plannerSearchStrategy << "," << o.planConstraints;
+  ss << ";minimizeForTiles:" << key.minimizeForTiles;
+  ss << ";cycleLimit:";
+  if (key.cycleLimit) {
+    ss << *key.cycleLimit;
+  }
+  ss << ";startTile:" << key.startTileIdxForVirtualHierarchy;
+  return ss.str();
+}
+
+namespace {
+
+using boost::property_tree::ptree;
+
+template <typename T> ptree arrayToPtree(const std::vector<T> &values) {
+  ptree array;
+  for (const auto value : values) {
+    array.push_back(ptree::value_type("", ptree(std::to_string(value))));
+  }
+  return array;
+}
+
+template <typename T> std::vector<T> arrayFromPtree(const ptree &array) {
+  std::vector<T> values;
+  for (const auto &child : array) {
+    values.push_back(child.second.get_value<T>());
+  }
+  return values;
+}
+
+// The types that may appear in a persisted plan.
+std::vector<poplar::Type> getPersistableTypes() {
+  return {poplar::HALF,         poplar::FLOAT, poplar::INT,
+          poplar::UNSIGNED_INT, poplar::SHORT, poplar::UNSIGNED_SHORT};
+}
+
+poplar::Type typeFromString(const std::string &name) {
+  for (const auto &type : getPersistableTypes()) {
+    if (type.toString() == name) {
+      return type;
+    }
+  }
+  throw poputil::poplibs_error("Unrecognised type '" + name +
+                               "' in plan cache");
+}
+
+ptree planToPtree(const Plan &plan) {
+  ptree t;
+  ptree transforms;
+  for (const auto &transform : plan.transforms) {
+    ptree entry;
+    entry.put("extraFieldDims", transform.extraFieldDims);
+    entry.add_child("dilatePostConv", arrayToPtree(transform.dilatePostConv));
+    entry.put("swapOperands", transform.swapOperands);
+    entry.add_child("expandDims", arrayToPtree(transform.expandDims));
+    entry.add_child("outChanFlattenDims",
+                    arrayToPtree(transform.outChanFlattenDims));
+    entry.add_child("flattenDims", arrayToPtree(transform.flattenDims));
+    entry.put("combineConvGroupsFactor", transform.combineConvGroupsFactor);
+    transforms.push_back(ptree::value_type("", entry));
+  }
+  t.add_child("transforms", transforms);
+
+  ptree partitions;
+  for (const auto &partition : plan.partitions) {
+    ptree entry;
+    entry.add_child("fieldSplit", arrayToPtree(partition.fieldSplit));
+    entry.put("batchSplit", partition.batchSplit);
+    entry.put("outChanSplit.serial", partition.outChanSplit.serial);
+    entry.put("outChanSplit.parallel", partition.outChanSplit.parallel);
+    entry.add_child("kernelSplit", arrayToPtree(partition.kernelSplit));
+    entry.put("inChanSplit.serial", partition.inChanSplit.serial);
+    entry.put("inChanSplit.parallel", partition.inChanSplit.parallel);
+    entry.put("convGroupSplit", partition.convGroupSplit);
+    entry.add_child("fieldAxisGrainSize",
+                    arrayToPtree(partition.fieldAxisGrainSize));
+    entry.put("convGroupGrainSize", partition.convGroupGrainSize);
+    entry.put("inChanGrainSize", partition.inChanGrainSize);
+    entry.put("outChanGrainSize", partition.outChanGrainSize);
+    partitions.push_back(ptree::value_type("", entry));
+  }
+  t.add_child("partitions", partitions);
+
+  ptree types;
+  for (const auto &type : plan.types) {
+    ptree entry;
+    entry.put("partialType", type.partialType.toString());
+    entry.put("resultType", type.resultType.toString());
+    types.push_back(ptree::value_type("", entry));
+  }
+  t.add_child("types", types);
+
+  t.put("convGroupsPerGroup", plan.convGroupsPerGroup);
+  t.put("inChansPerGroup", plan.inChansPerGroup);
+  t.put("partialChansPerGroup", plan.partialChansPerGroup);
+  t.put("slicWindowWidth", plan.slicWindowWidth);
+  t.put("numConvUnitsRequired", plan.numConvUnitsRequired);
+  t.put("method", asString(plan.method));
+  t.put("linearizeTileOrder", static_cast<unsigned>(plan.linearizeTileOrder));
+  t.put("startTile", plan.startTile);
+  t.put("linearizeTileDirection",
+        static_cast<unsigned>(plan.linearizeTileDirection));
+  t.put("isJointPlan", plan.isJointPlan);
+  return t;
+}
+
+Plan planFromPtree(const ptree &t) {
+  Plan plan;
+  for (const auto &child : t.get_child("transforms")) {
+    const auto &entry = child.second;
+    ConvTransform transform;
+    transform.extraFieldDims = entry.get<unsigned>("extraFieldDims");
+    transform.dilatePostConv =
+        arrayFromPtree<unsigned>(entry.get_child("dilatePostConv"));
+    transform.swapOperands = entry.get<bool>("swapOperands");
+    transform.expandDims =
+        arrayFromPtree<unsigned>(entry.get_child("expandDims"));
+    transform.outChanFlattenDims =
+        arrayFromPtree<unsigned>(entry.get_child("outChanFlattenDims"));
+    transform.flattenDims =
+        arrayFromPtree<unsigned>(entry.get_child("flattenDims"));
+    transform.combineConvGroupsFactor =
+        entry.get<unsigned>("combineConvGroupsFactor");
+    plan.transforms.push_back(std::move(transform));
+  }
+
+  for (const auto &child : t.get_child("partitions")) {
+    const auto &entry = child.second;
+    Partition partition;
+    partition.fieldSplit =
+        arrayFromPtree<unsigned>(entry.get_child("fieldSplit"));
+    partition.batchSplit = entry.get<unsigned>("batchSplit");
+    partition.outChanSplit.serial = entry.get<unsigned>("outChanSplit.serial");
+    partition.outChanSplit.parallel =
+        entry.get<unsigned>("outChanSplit.parallel");
+    partition.kernelSplit =
+        arrayFromPtree<unsigned>(entry.get_child("kernelSplit"));
+    partition.inChanSplit.serial = entry.get<unsigned>("inChanSplit.serial");
+    partition.inChanSplit.parallel =
+        entry.get<unsigned>("inChanSplit.parallel");
+    partition.convGroupSplit = entry.get<unsigned>("convGroupSplit");
+    partition.fieldAxisGrainSize =
+        arrayFromPtree<unsigned>(entry.get_child("fieldAxisGrainSize"));
+    partition.convGroupGrainSize = entry.get<unsigned>("convGroupGrainSize");
+    partition.inChanGrainSize = entry.get<unsigned>("inChanGrainSize");
+    partition.outChanGrainSize = entry.get<unsigned>("outChanGrainSize");
+    plan.partitions.push_back(std::move(partition));
+  }
+
+  for (const auto &child : t.get_child("types")) {
+    const auto &entry = child.second;
+    plan.types.emplace_back(
+        typeFromString(entry.get<std::string>("partialType")),
+        typeFromString(entry.get<std::string>("resultType")));
+  }
+
+  plan.convGroupsPerGroup = t.get<unsigned>("convGroupsPerGroup");
+  plan.inChansPerGroup = t.get<unsigned>("inChansPerGroup");
+  plan.partialChansPerGroup = t.get<unsigned>("partialChansPerGroup");
+  plan.slicWindowWidth = t.get<unsigned>("slicWindowWidth");
+  plan.numConvUnitsRequired = t.get<unsigned>("numConvUnitsRequired");
+  std::stringstream method(t.get<std::string>("method"));
+  method >> plan.method;
+  plan.linearizeTileOrder = static_cast<Plan::LinearizeTileOrder>(
+      t.get<unsigned>("linearizeTileOrder"));
+  plan.startTile = t.get<unsigned>("startTile");
+  plan.linearizeTileDirection = static_cast<Plan::LinearizeTileDirection>(
+      t.get<unsigned>("linearizeTileDirection"));
+  plan.isJointPlan = t.get<bool>("isJointPlan");
+
+  if (plan.transforms.size() != plan.types.size() ||
+      plan.transforms.size() != plan.partitions.size() + 1) {
+    throw poputil::poplibs_error("Inconsistent number of levels in plan");
+  }
+  return plan;
+}
+
+ptree costToPtree(const Cost &cost) {
+  ptree t;
+  forEachCostField(cost, [&](const char *name, unsigned value) {
+    t.put(name, value);
+  });
+  return t;
+}
+
+Cost costFromPtree(const ptree &t) {
+  Cost cost;
+  forEachCostField(cost, [&](const char *name, unsigned &value) {
+    value = t.get<unsigned>(name);
+  });
+  return cost;
+}
+
+// Plans and costs are stored in a plan index as a sequence of 32-bit words
+// so that a single entry can be decoded without parsing the rest of the file.
+class PlanEncoder {
+public:
+  void put(unsigned value) { words.push_back(value); }
+  void putVector(const std::vector<unsigned> &values) {
+    put(values.size());
+    words.insert(words.end(), values.begin(), values.end());
+  }
+  void putType(const poplar::Type &type) {
+    const auto types = getPersistableTypes();
+    const auto it = std::find(types.begin(), types.end(), type);
+    if (it == types.end()) {
+      throw poputil::poplibs_error("Type " + type.toString() +
+                                   " cannot be written to a plan index");
+    }
+    put(it - types.begin());
+  }
+  std::vector<std::uint32_t> words;
+};
+
+class PlanDecoder {
+public:
+  PlanDecoder(const std::uint32_t *begin, const std::uint32_t *end)
+      : pos(begin), end(end) {}
+  unsigned getUnsigned() {
+    if (pos == end) {
+      throw poputil::poplibs_error("Truncated entry in plan index");
+    }
+    return *pos++;
+  }
+  std::vector<unsigned> getVector() {
+    const auto size = getUnsigned();
+    if (size > static_cast<std::size_t>(end - pos)) {
+      throw poputil::poplibs_error("Truncated entry in plan index");
+    }
+    std::vector<unsigned> values(pos, pos + size);
+    pos += size;
+    return values;
+  }
+  poplar::Type getType() {
+    const auto types = getPersistableTypes();
+    const auto index = getUnsigned();
+    if (index >= types.size()) {
+      throw poputil::poplibs_error("Unrecognised type in plan index");
+    }
+    return types[index];
+  }
+  bool atEnd() const { return pos == end; }
+
+private:
+  const std::uint32_t *pos;
+  const std::uint32_t *end;
+};
+
+std::vector<std::uint32_t> encodePlanAndCost(const Plan &plan,
+                                             const Cost &cost) {
+  PlanEncoder e;
+  e.put(plan.transforms.size());
+  for (const auto &transform : plan.transforms) {
+    e.put(transform.extraFieldDims);
+    e.putVector(transform.dilatePostConv);
+    e.put(transform.swapOperands);
+    e.putVector(transform.expandDims);
+    e.putVector(transform.outChanFlattenDims);
+    e.putVector(transform.flattenDims);
+    e.put(transform.combineConvGroupsFactor);
+  }
+  e.put(plan.partitions.size());
+  for (const auto &partition : plan.partitions) {
+    e.putVector(partition.fieldSplit);
+    e.put(partition.batchSplit);
+    e.put(partition.outChanSplit.serial);
+    e.put(partition.outChanSplit.parallel);
+    e.putVector(partition.kernelSplit);
+    e.put(partition.inChanSplit.serial);
+    e.put(partition.inChanSplit.parallel);
+    e.put(partition.convGroupSplit);
+    e.putVector(partition.fieldAxisGrainSize);
+    e.put(partition.convGroupGrainSize);
+    e.put(partition.inChanGrainSize);
+    e.put(partition.outChanGrainSize);
+  }
+  e.put(plan.types.size());
+  for (const auto &type : plan.types) {
+    e.putType(type.partialType);
+    e.putType(type.resultType);
+  }
+  e.put(plan.convGroupsPerGroup);
+  e.put(plan.inChansPerGroup);
+  e.put(plan.partialChansPerGroup);
+  e.put(plan.slicWindowWidth);
+  e.put(plan.numConvUnitsRequired);
+  e.put(static_cast<unsigned>(plan.method));
+  e.put(static_cast<unsigned>(plan.linearizeTileOrder));
+  e.put(plan.startTile);
+  e.put(static_cast<unsigned>(plan.linearizeTileDirection));
+  e.put(plan.isJointPlan);
+  forEachCostField(cost, [&](const char *, unsigned value) { e.put(value); });
+  return std::move(e.words);
+}
+
+std::pair<Plan, Cost> decodePlanAndCost(const std::uint32_t *begin,
+                                        const std::uint32_t *end) {
+  PlanDecoder d(begin, end);
+  Plan plan;
+  const auto numTransforms = d.getUnsigned();
+  for (unsigned i = 0; i != numTransforms; ++i) {
+    ConvTransform transform;
+    transform.extraFieldDims = d.getUnsigned();
+    transform.dilatePostConv = d.getVector();
+    transform.swapOperands = d.getUnsigned();
+    transform.expandDims = d.getVector();
+    transform.outChanFlattenDims = d.getVector();
+    transform.flattenDims = d.getVector();
+    transform.combineConvGroupsFactor = d.getUnsigned();
+    plan.transforms.push_back(std::move(transform));
+  }
+  const auto numPartitions = d.getUnsigned();
+  for (unsigned i = 0; i != numPartitions; ++i) {
+    Partition partition;
+    partition.fieldSplit = d.getVector();
+    partition.batchSplit = d.getUnsigned();
+    partition.outChanSplit.serial = d.getUnsigned();
+    partition.outChanSplit.parallel = d.getUnsigned();
+    partition.kernelSplit = d.getVector();
+    partition.inChanSplit.serial = d.getUnsigned();
+    partition.inChanSplit.parallel = d.getUnsigned();
+    partition.convGroupSplit = d.getUnsigned();
+    partition.fieldAxisGrainSize = d.getVector();
+    partition.convGroupGrainSize = d.getUnsigned();
+    partition.inChanGrainSize = d.getUnsigned();
+    partition.outChanGrainSize = d.getUnsigned();
+    plan.partitions.push_back(std::move(partition));
+  }
+  const auto numTypes = d.getUnsigned();
+  for (unsigned i = 0; i != numTypes; ++i) {
+    const auto partialType = d.getType();
+    const auto resultType = d.getType();
+    plan.types.emplace_back(partialType, resultType);
+  }
+  plan.convGroupsPerGroup = d.getUnsigned();
+  plan.inChansPerGroup = d.getUnsigned();
+  plan.partialChansPerGroup = d.getUnsigned();
+  plan.slicWindowWidth = d.getUnsigned();
+  plan.numConvUnitsRequired = d.getUnsigned();
+  plan.method = static_cast<Plan::Method>(d.getUnsigned());
+  plan.linearizeTileOrder =
+      static_cast<Plan::LinearizeTileOrder>(d.getUnsigned());
+  plan.startTile = d.getUnsigned();
+  plan.linearizeTileDirection =
+      static_cast<Plan::LinearizeTileDirection>(d.getUnsigned());
+  plan.isJointPlan = d.getUnsigned();
+  Cost cost;
+  forEachCostField(cost, [&](const char *, unsigned &value) {
+    value = d.getUnsigned();
+  });
+  if (!d.atEnd() || plan.transforms.size() != plan.types.size() ||
+      plan.transforms.size() != plan.partitions.size() + 1) {
+    throw poputil::poplibs_error("Inconsistent entry in plan index");
+  }
+  return {std::move(plan), std::move(cost)};
+}
+
+// Unlike std::hash the result is the same in every process, which is
+// required for hashes that are written to files.
+std::uint64_t stableHash(const std::string &s) {
+  return Fingerprint().addBytes(s.data(), s.size()).get();
+}
+
+} // end anonymous namespace
+
+void PlanningCacheImpl::load(const poplar::Target &target,
+                             const std::string &path) {
+  ptree file;
+  try {
+    boost::property_tree::read_json(path, file);
+  } catch (const boost::property_tree::json_parser_error &e) {
+    logging::warn("Ignoring unreadable plan cache file {}: {}", path,
+                  e.what());
+    return;
+  }
+  const auto version = file.get_optional<unsigned>("version");
+  if (!version || *version != planCacheFormatVersion) {
+    logging::warn("Ignoring plan cache file {} with unsupported version", path);
+    return;
+  }
+  const auto fingerprint = getTargetFingerprint(target);
+  std::size_t numLoaded = 0;
+  const auto plans = file.get_child_optional("plans");
+  if (!plans) {
+    return;
+  }
+  for (const auto &child : *plans) {
+    const auto &entry = child.second;
+    if (entry.get<std::string>("target", "") != fingerprint) {
+      foreignEntries.push_back(entry);
+      continue;
+    }
+    try {
+      auto plan = planFromPtree(entry.get_child("plan"));
+      auto cost = costFromPtree(entry.get_child("cost"));
+      persistentPlans.emplace(
+          entry.get<std::string>("key"),
+          std::make_pair(std::move(plan), std::move(cost)));
+      ++numLoaded;
+    } catch (const std::exception &e) {
+      logging::warn("Ignoring invalid entry in plan cache file {}: {}", path,
+                    e.what());
+    }
+  }
+  logging::debug("Loaded {} plans from plan cache file {}", numLoaded, path);
+}
+
+void PlanningCacheImpl::save(const poplar::Target &target,
+                             const std::string &path) const {
+  const auto fingerprint = getTargetFingerprint(target);
+  const auto makeEntry = [&](const std::string &key,
+                             const std::pair<Plan, Cost> &value) {
+    ptree entry;
+    entry.put("target", fingerprint);
+    entry.put("key", key);
+    entry.add_child("plan", planToPtree(value.first));
+    entry.add_child("cost", costToPtree(value.second));
+    return entry;
+  };
+
+  ptree plans;
+  std::set<std::string> savedKeys;
+  for (const auto &entry : planCache) {
+    if (!isPersistable(entry.first)) {
+      continue;
+    }
+    auto key = serializeKey(entry.first);
+    plans.push_back(ptree::value_type("", makeEntry(key, entry.second)));
+    savedKeys.insert(std::move(key));
+  }
+  for (const auto &entry : persistentPlans) {
+    if (!savedKeys.count(entry.first)) {
+      plans.push_back(
+          ptree::value_type("", makeEntry(entry.first, entry.second)));
+    }
+  }
+  for (const auto &entry : foreignEntries) {
+    plans.push_back(ptree::value_type("", entry));
+  }
+
+  ptree file;
+  file.put("version", planCacheFormatVersion);
+  file.add_child("plans", plans);
+  boost::property_tree::write_json(path, file);
+  logging::debug("Saved {} plans to plan cache file {}", plans.size(), path);
+}
+
+// Version of the plan index file layout. Indices are also rejected if they
+// were written with a different planCacheFormatVersion.
+static constexpr std::uint32_t planIndexFormatVersion = 1;
+
+// A plan index file consists of a header, an open addressing hash table of
+// numBuckets buckets and the entries the buckets refer to. Each entry is the
+// length of the serialized key in bytes, the length of the payload in words,
+// the key padded to a multiple of 4 bytes and the payload produced by
+// encodePlanAndCost(). Values are stored in the byte order of the host.
+struct PlanIndexHeader {
+  char magic[8];
+  std::uint32_t formatVersion;
+  std::uint32_t planCacheVersion;
+  std::uint64_t targetHash;
+  std::uint32_t numBuckets;
+  std::uint32_t numEntries;
+};
+static_assert(sizeof(PlanIndexHeader) == 32, "Unexpected padding");
+
+struct PlanIndexBucket {
+  std::uint64_t keyHash;
+  // Offset of the entry from the start of the file, or 0 if empty.
+  std::uint64_t entryOffset;
+};
+static_assert(sizeof(PlanIndexBucket) == 16, "Unexpected padding");
+
+static const char planIndexMagic[8] = {'P', 'O', 'P', 'L', 'I', 'D', 'X', 0};
+
+static std::uint32_t paddedKeyBytes(std::uint32_t keyBytes) {
+  return (keyBytes + 3) & ~3u;
+}
+
+PlanIndex::PlanIndex(const std::string &path)
+    : file(path.c_str(), boost::interprocess::read_only),
+      region(file, boost::interprocess::read_only),
+      data(static_cast<const char *>(region.get_address())),
+      dataSize(region.get_size()) {
+  PlanIndexHeader header;
+  if (dataSize < sizeof(header)) {
+    throw poputil::poplibs_error("Plan index is too small");
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (std::memcmp(header.magic, planIndexMagic, sizeof(planIndexMagic)) != 0) {
+    throw poputil::poplibs_error("File is not a plan index");
+  }
+  if (header.formatVersion != planIndexFormatVersion ||
+      header.planCacheVersion != planCacheFormatVersion) {
+    throw poputil::poplibs_error("Plan index has an unsupported version");
+  }
+  if (header.numBuckets == 0 ||
+      (header.numBuckets & (header.numBuckets - 1)) != 0 ||
+      header.numEntries >= header.numBuckets ||
+      (dataSize - sizeof(header)) / sizeof(PlanIndexBucket) <
+          header.numBuckets) {
+    throw poputil::poplibs_error("Plan index has an invalid hash table");
+  }
+  targetHash = header.targetHash;
+  numBuckets = header.numBuckets;
+  numEntries = header.numEntries;
+}
+
+std::tuple<const char *, std::uint32_t, const std::uint32_t *, std::uint32_t>
+PlanIndex::readEntry(std::uint64_t offset) const {
+  std::uint32_t sizes[2];
+  if (offset % 4 != 0 || offset > dataSize ||
+      dataSize - offset < sizeof(sizes)) {
+    throw poputil::poplibs_error("Plan index has an invalid entry offset");
+  }
+  std::memcpy(sizes, data + offset, sizeof(sizes));
+  const auto keyOffset = offset + sizeof(sizes);
+  const auto payloadOffset = keyOffset + paddedKeyBytes(sizes[0]);
+  if (payloadOffset > dataSize ||
+      (dataSize - payloadOffset) / sizeof(std::uint32_t) < sizes[1]) {
+    throw poputil::poplibs_error("Plan index has a truncated entry");
+  }
+  return std::make_tuple(
+      data + keyOffset, sizes[0],
+      reinterpret_cast<const std::uint32_t *>(data + payloadOffset), sizes[1]);
+}
+
+boost::optional<std::pair<Plan, Cost>>
+PlanIndex::find(const std::string &key) const {
+  const auto keyHash = stableHash(key);
+  const auto *buckets = reinterpret_cast<const PlanIndexBucket *>(
+      data + sizeof(PlanIndexHeader));
+  auto i = keyHash & (numBuckets - 1);
+  for (std::uint32_t probe = 0; probe != numBuckets;
+       ++probe, i = (i + 1) & (numBuckets - 1)) {
+    const auto &bucket = buckets[i];
+    if (bucket.entryOffset == 0) {
+      break;
+    }
+    if (bucket.keyHash != keyHash) {
+      continue;
+    }
+    const char *entryKey;
+    std::uint32_t keyBytes, payloadWords;
+    const std::uint32_t *payload;
+    std::tie(entryKey, keyBytes, payload, payloadWords) =
+        readEntry(bucket.entryOffset);
+    if (keyBytes == key.size() &&
+        std::memcmp(entryKey, key.data(), keyBytes) == 0) {
+      return decodePlanAndCost(payload, payload + payloadWords);
+    }
+  }
+  return boost::none;
+}
+
+template <typename F> void PlanIndex::forEachEntry(F f) const {
+  const auto *buckets = reinterpret_cast<const PlanIndexBucket *>(
+      data + sizeof(PlanIndexHeader));
+  for (std::uint32_t i = 0; i != numBuckets; ++i) {
+    if (buckets[i].entryOffset == 0) {
+      continue;
+    }
+    const char *key;
+    std::uint32_t keyBytes, payloadWords;
+    const std::uint32_t *payload;
+    std::tie(key, keyBytes, payload, payloadWords) =
+        readEntry(buckets[i].entryOffset);
+    f(std::string(key, keyBytes), payload, payloadWords);
+  }
+}
+
+void PlanningCacheImpl::loadIndex(const poplar::Target &target,
+                                  const std::string &path) {
+  std::unique_ptr<PlanIndex> index;
+  try {
+    index = std::make_unique<PlanIndex>(path);
+  } catch (const std::exception &e) {
+    logging::warn("Ignoring unreadable plan index {}: {}", path, e.what());
+    return;
+  }
+  if (index->getTargetHash() != stableHash(getTargetFingerprint(target))) {
+    logging::warn("Ignoring plan index {} created for a different target",
+                  path);
+    return;
+  }
+  logging::debug("Mapped {} plans from plan index {}", index->size(), path);
+  planIndices.push_back(std::move(index));
+}
+
+void PlanningCacheImpl::mergeIntoIndex(const poplar::Target &target,
+                                       const std::string &path) const {
+  namespace ipc = boost::interprocess;
+  // Serialize merges from different processes. Processes that have mapped
+  // the old index are unaffected as the new index replaces it atomically.
+  // The lock file is left in place: removing it would let a process that is
+  // waiting on the old file and one that creates a new file merge at once.
+  const auto lockPath = path + ".lock";
+  std::ofstream(lockPath, std::ios::app);
+  ipc::file_lock fileLock(lockPath.c_str());
+  ipc::scoped_lock<ipc::file_lock> guard(fileLock);
+
+  const auto targetHash = stableHash(getTargetFingerprint(target));
+  // Ordered by key so the file doesn't depend on the order plans were found.
+  std::map<std::string, std::vector<std::uint32_t>> entries;
+  if (std::ifstream(path).good()) {
+    std::unique_ptr<PlanIndex> existing;
+    try {
+      existing = std::make_unique<PlanIndex>(path);
+      existing->forEachEntry([&](std::string key, const std::uint32_t *payload,
+                                 std::uint32_t payloadWords) {
+        entries.emplace(std::move(key), std::vector<std::uint32_t>(
+                                            payload, payload + payloadWords));
+      });
+    } catch (const std::exception &e) {
+      logging::warn("Replacing unreadable plan index {}: {}", path, e.what());
+      entries.clear();
+      existing.reset();
+    }
+    if (existing && existing->getTargetHash() != targetHash) {
+      throw poputil::poplibs_error("Plan index " + path +
+                                   " was created for a different target");
+    }
+  }
+  const auto numExisting = entries.size();
+  for (const auto &entry : planCache) {
+    if (isPersistable(entry.first)) {
+      entries.emplace(serializeKey(entry.first),
+                      encodePlanAndCost(entry.second.first,
+                                        entry.second.second));
+    }
+  }
+  for (const auto &entry : persistentPlans) {
+    entries.emplace(entry.first,
+                    encodePlanAndCost(entry.second.first, entry.second.second));
+  }
+
+  PlanIndexHeader header;
+  std::memcpy(header.magic, planIndexMagic, sizeof(planIndexMagic));
+  header.formatVersion = planIndexFormatVersion;
+  header.planCacheVersion = planCacheFormatVersion;
+  header.targetHash = targetHash;
+  header.numBuckets = 1;
+  while (header.numBuckets < 2 * entries.size()) {
+    header.numBuckets *= 2;
+  }
+  header.numEntries = entries.size();
+
+  std::vector<PlanIndexBucket> buckets(header.numBuckets,
+                                       PlanIndexBucket{0, 0});
+  std::string body;
+  const std::uint64_t bodyOffset =
+      sizeof(header) + buckets.size() * sizeof(PlanIndexBucket);
+  for (const auto &entry : entries) {
+    const auto &key = entry.first;
+    const auto &payload = entry.second;
+    const auto keyHash = stableHash(key);
+    auto i = keyHash & (header.numBuckets - 1);
+    while (buckets[i].entryOffset != 0) {
+      i = (i + 1) & (header.numBuckets - 1);
+    }
+    buckets[i] = {keyHash, bodyOffset + body.size()};
+    const std::uint32_t sizes[2] = {static_cast<std::uint32_t>(key.size()),
+                                    static_cast<std::uint32_t>(payload.size())};
+    body.append(reinterpret_cast<const char *>(sizes), sizeof(sizes));
+    body.append(key);
+    body.append(paddedKeyBytes(key.size()) - key.size(), '\0');
+    body.append(reinterpret_cast<const char *>(payload.data()),
+                payload.size() * sizeof(std::uint32_t));
+  }
+
+  const auto tempPath = path + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(buckets.data()),
+              buckets.size() * sizeof(PlanIndexBucket));
+    out.write(body.data(), body.size());
+    if (!out) {
+      throw poputil::poplibs_error("Failed to write plan index " + tempPath);
+    }
+  }
+  if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+    throw poputil::poplibs_error("Failed to replace plan index " + path);
+  }
+  logging::debug("Merged {} new plans into plan index {} ({} plans)",
+                 entries.size() - numExisting, path, entries.size());
+}
+
 class PlanningObjective {
 public:
   enum Type {
@@ -1458,6 +2487,18 @@ static popsolver::Variable addPartialCalcCycleEstimate(
     convUnitInputLoadElemsPerCycle /= 2;
   }
 
+  std::vector<unsigned> sortedTransformedDims(transformedDims.begin(),
+                                              transformedDims.end());
+  std::sort(sortedTransformedDims.begin(), sortedTransformedDims.end());
+  const auto memo = cache->getPartialCalcMemo(std::make_tuple(
+      method, fieldGrainSize, convGroupsPerGroup, inChansPerGroup,
+      outChansPerGroup, std::move(sortedTransformedDims), params,
+      floatPartials, slicWindowWidth, numConvUnitsRequired,
+      convUnitInputLoadElemsPerCycle, target.getNumWorkerContexts(),
+      target.getDataPathWidth(), target.getConvUnitCoeffLoadBytesPerCycle(),
+      target.getWeightsPerConvUnit(floatActivations),
+      getNumConvUnits(floatActivations, floatPartials, target)));
+
   const std::string debugName = "partialCalcCycleEstimate";
   switch (method) {
   default: {
@@ -1548,7 +2589,7 @@ static popsolver::Variable addPartialCalcCycleEstimate(
                      floatPartials) +
                  zeroCycles;
         },
-        debugName);
+        memo, debugName);
   }
   case Plan::Method::SLIC: {
     return m.call(
@@ -1611,7 +2652,8 @@ static popsolver::Variable addPartialCalcCycleEstimate(
               implicitZeroInnerLoopCycles, innerLoopCycles, weightLoadCycles,
               tileNumConvGroups, numWeightBlocks, numConvUnitsRequired,
               slicWindowWidth, floatActivations, floatPartials);
-        });
+        },
+        memo);
   }
   case Plan::Method::MAC: {
     const auto outputStrideX = transformedInputDilation.back();
@@ -1663,7 +2705,7 @@ static popsolver::Variable addPartialCalcCycleEstimate(
                      floatActivations) +
                  zeroCycles;
         },
-        debugName);
+        memo, debugName);
   } break;
   case Plan::Method::OUTER_PRODUCT: {
     assert(inChansPerGroup == 1);
@@ -1694,7 +2736,7 @@ static popsolver::Variable addPartialCalcCycleEstimate(
               dataPathWidth);
           return vertexRuntime * numContexts;
         },
-        debugName);
+        memo, debugName);
   } break;
   }
 }
@@ -4353,8 +5395,9 @@ static std::pair<Plan, Cost> choosePlan(
     unsigned startTileIdxForVirtualHierarchy,
     const boost::optional<Plan> &referencePlan,
     const boost::optional<Cost> &referenceCost,
-    PlanningCacheImpl::CycleEstimationImpl *cache, const ConvOptions &options) {
-  popsolver::Model m;
+    PlanningCacheImpl::CycleEstimationImpl *cache, const ConvOptions &options,
+    popsolver::SearchStats &searchStats) {
+  popsolver::Model m(options.plannerSearchStrategy);
   std::vector<PartitionVariables> partitionVars;
   Estimates<popsolver::Variable> e = constructModel(
       target, transforms, types, hierarchy, perLevelExchangeBytesPerCycle,
@@ -4379,6 +5422,7 @@ static std::pair<Plan, Cost> choosePlan(
     s = m.minimize({e.totalTiles, e.totalCycles});
     break;
   }
+  searchStats = m.getSearchStats();
 
   if (!s.validSolution()) {
     return {Plan(), highestCost};
@@ -5288,6 +6332,40 @@ static void logPlanBreakdown(logging::Level l, const Plan &plan,
   }
 }
 
+static void addSearchStats(PlanningStats &stats,
+                           const popsolver::SearchStats &searchStats,
+                           double solveSeconds) {
+  ++stats.candidates;
+  stats.solveSeconds += solveSeconds;
+  stats.nodes += searchStats.nodes;
+  stats.propagations += searchStats.propagations;
+  stats.constraintEvaluations += searchStats.constraintEvaluations;
+  stats.backtracks += searchStats.backtracks;
+  stats.prunes += searchStats.prunes;
+}
+
+static void logCandidateStats(std::size_t index,
+                              const ConvVertexType &convVertexType,
+                              const Cost &cost, const PlanningStats &stats) {
+  if (!logging::shouldLog(logging::Level::Trace)) {
+    return;
+  }
+  std::stringstream ss;
+  if (cost == highestCost) {
+    ss << "none";
+  } else {
+    ss << cost;
+  }
+  logging::trace("  candidate {}: method={}, inChansPerGroup={}, "
+                 "partialChansPerGroup={}, cost={}, time={:.3f}ms, nodes={}, "
+                 "propagations={}, constraintEvaluations={}, backtracks={}, "
+                 "prunes={}",
+                 index, convVertexType.method, convVertexType.inChansPerGroup,
+                 convVertexType.partialChansPerGroup, ss.str(),
+                 stats.solveSeconds * 1000, stats.nodes, stats.propagations,
+                 stats.constraintEvaluations, stats.backtracks, stats.prunes);
+}
+
 static std::vector<unsigned> getHierarchy(const ConvOptions &options) {
   return poplibs::getTileHierarchy(options.numIPUs, options.tilesPerIPU);
 }
@@ -5343,6 +6421,15 @@ createPlan(ConvParams params, const ConvOptions &options, bool isJointPlan,
   auto paramsWithDeferredDilation = calculateParamsWithDeferredDilation(
       paramsWithExtraDims, transforms[0].dilatePostConv);
 
+  // Enumerate every candidate transform and vertex type. Each candidate is
+  // then planned independently and the planner runs them concurrently.
+  struct Candidate {
+    std::vector<ConvTransform> transforms;
+    std::vector<ConvTypes> types;
+    std::vector<unsigned> fieldGrainSize;
+    ConvVertexType convVertexType;
+  };
+  std::vector<Candidate> candidates;
   for (bool swapOperands : getSwapOperandCandidates(paramsWithDeferredDilation,
                                                     options, isJointPlan)) {
     transforms[0].swapOperands = swapOperands;
@@ -5394,39 +6481,111 @@ createPlan(ConvParams params, const ConvOptions &options, bool isJointPlan,
               // layer.
               fieldGrainSize.back() = 2;
             }
-            Plan candidate;
-            Cost candidateCost;
             // Override the partials type at the tile level with that chosen
             // for the vertex type as we may choose a lower precision to
             // implement the operation if we know the vertex can effectively
             // maintain the accuracy implied by the requested partials type.
             auto newConvTypes = convTypes;
             newConvTypes.back().partialType = convVertexType.partialType;
-            std::tie(candidate, candidateCost) =
-                choosePlan(target, transforms, newConvTypes, hierarchy,
-                           perLevelExchangeBytesPerCycle, fieldGrainSize,
-                           convVertexType, params, isJointPlan, bestCost,
-                           objective, startTileIdxForVirtualHierarchy,
-                           referencePlan, referenceCost, cache, options);
-            if (candidateCost == highestCost) {
-              continue;
-            }
-
-            if (objective.lowerCost(candidateCost, bestCost)) {
-              bestPlan = candidate;
-              bestCost = candidateCost;
-
-              logging::debug("Found new best candidate plan using {}: {}",
-                             candidate.method, candidateCost);
-              logPlanBreakdown(logging::Level::Trace, bestPlan, bestCost,
-                               referenceCost);
-            }
+            candidates.push_back({transforms, std::move(newConvTypes),
+                                  std::move(fieldGrainSize), convVertexType});
           }
         }
       }
     }
   }
 
+  const auto planCandidate = [&](const Candidate &c, const Cost &bound,
+                                 PlanningStats &stats) {
+    popsolver::SearchStats searchStats;
+    const auto start = std::chrono::steady_clock::now();
+    auto result = choosePlan(
+        target, c.transforms, c.types, hierarchy, perLevelExchangeBytesPerCycle,
+        c.fieldGrainSize, c.convVertexType, params, isJointPlan, bound,
+        objective, startTileIdxForVirtualHierarchy, referencePlan,
+        referenceCost, cache, options, searchStats);
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    addSearchStats(stats, searchStats, elapsed.count());
+    return result;
+  };
+
+  // The lowest cost found so far is shared between the workers so that
+  // candidates that cannot beat it are pruned by the solver.
+  std::vector<std::pair<Plan, Cost>> results(candidates.size());
+  std::vector<Cost> bounds(candidates.size());
+  std::vector<PlanningStats> candidateStats(candidates.size());
+  std::mutex sharedBoundMutex;
+  Cost sharedBound = highestCost;
+  tbb::parallel_for(std::size_t(0), candidates.size(), [&](std::size_t i) {
+    {
+      std::lock_guard<std::mutex> lock(sharedBoundMutex);
+      bounds[i] = sharedBound;
+    }
+    results[i] = planCandidate(candidates[i], bounds[i], candidateStats[i]);
+    const auto &candidateCost = results[i].second;
+    if (candidateCost != highestCost) {
+      std::lock_guard<std::mutex> lock(sharedBoundMutex);
+      if (objective.lowerCost(candidateCost, sharedBound)) {
+        sharedBound = candidateCost;
+      }
+    }
+  });
+
+  PlanningStats totalStats;
+  for (std::size_t i = 0; i != candidates.size(); ++i) {
+    logCandidateStats(i, candidates[i].convVertexType, results[i].second,
+                      candidateStats[i]);
+    totalStats += candidateStats[i];
+  }
+
+  // Replay the candidates in enumeration order, with the bound the serial
+  // search would have solved each of them with, so that the plan doesn't
+  // depend on the order in which the workers ran. A candidate pruned by a
+  // lower shared bound than that is solved again, as it might have been the
+  // best one so far. The solver may pick a different plan among those of
+  // equal cost depending on its bound, so the best candidate is also solved
+  // again if its bound differs.
+  boost::optional<std::size_t> bestCandidate;
+  Cost bestCandidateBound = highestCost;
+  for (std::size_t i = 0; i != candidates.size(); ++i) {
+    if (results[i].second == highestCost && bounds[i] != bestCost &&
+        objective.lowerCost(bounds[i], bestCost)) {
+      bounds[i] = bestCost;
+      results[i] = planCandidate(candidates[i], bounds[i], totalStats);
+    }
+    const auto &candidateCost = results[i].second;
+    if (candidateCost == highestCost) {
+      continue;
+    }
+
+    if (objective.lowerCost(candidateCost, bestCost)) {
+      bestCandidate = i;
+      bestCandidateBound = bestCost;
+      bestPlan = results[i].first;
+      bestCost = candidateCost;
+
+      logging::debug("Found new best candidate plan using {}: {}",
+                     bestPlan.method, candidateCost);
+      logPlanBreakdown(logging::Level::Trace, bestPlan, bestCost,
+                       referenceCost);
+    }
+  }
+  if (bestCandidate && bounds[*bestCandidate] != bestCandidateBound) {
+    std::tie(bestPlan, bestCost) = planCandidate(
+        candidates[*bestCandidate], bestCandidateBound, totalStats);
+    assert(bestCost != highestCost);
+  }
+  logging::debug("Planner solved {} candidates in {:.3f}s: nodes={}, "
+                 "propagations={}, constraintEvaluations={}, backtracks={}, "
+                 "prunes={}",
+                 totalStats.candidates, totalStats.solveSeconds,
+                 totalStats.nodes, totalStats.propagations,
+                 totalStats.constraintEvaluations, totalStats.backtracks,
+                 totalStats.prunes);
+  cache->addPlanningStats(totalStats);
+  cache->logPartialCalcMemoStats();
+
   if (isJointPlan && bestCost != highestCost) {
     // If we created a plan with the assumption that inputType == outputType,
     // we now restore resultType to ensure bestPlan is valid.
@@ -5912,16 +7071,23 @@ void preplanConvolutionsImpl(const poplar::Target &target,
   tbb::parallel_for(0u, unsigned(paramSet.size()), [&](unsigned i) {
     const auto &params = jobs[i].input->first;
     const auto &options = jobs[i].input->second;
+    auto key =
+        PlanningCacheImpl::Key(jobs[i].input->first, jobs[i].input->second,
+                               boost::none, boost::none, false, boost::none, 0);
+    // Lookups can run in parallel: planCache supports concurrent lookups and
+    // insertions of the plans getPlan() finds in plan cache files and
+    // indices, which aren't modified while planning. The plans created here
+    // are only added once all the jobs have finished.
+    if (cache.impl->getPlan(key)) {
+      return;
+    }
     Plan plan;
     Cost cost;
     std::tie(plan, cost) = runPlanner(
         params, options, target, boost::none, boost::none, false, boost::none,
         0, &cache.impl->cycleEstimation, &jobs[i].output);
-    auto key =
-        PlanningCacheImpl::Key(jobs[i].input->first, jobs[i].input->second,
-                               boost::none, boost::none, false, boost::none, 0);
     jobs[i].output.emplace_back(
-        key, std::make_pair(std::move(plan), std::move(cost)));
+        std::move(key), std::make_pair(std::move(plan), std::move(cost)));
   });
   // sequential insert into the cache
   for (unsigned i = 0u; i != jobs.size(); ++i) {
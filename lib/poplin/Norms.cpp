@@ -1,18 +1,23 @@
 // Copyright (c) 2019 Graphcore Ltd. All rights reserved.
+#include "poplibs_support/Algorithm.hpp"
 #include "poplibs_support/logging.hpp"
 #include "poplin/ConvUtil.hpp"
 #include "poplin/Convolution.hpp"
+#include "popops/Cast.hpp"
 #include "popops/ElementWise.hpp"
 #include "popops/Rearrange.hpp"
 #include "popops/Reduce.hpp"
-#include "popops/ScaledAdd.hpp"
 #include "poputil/TileMapping.hpp"
 #include "poputil/Util.hpp"
+#include "poputil/VarStructure.hpp"
 #include "poputil/VertexTemplates.hpp"
 #include "poputil/exceptions.hpp"
+#include <algorithm>
 #include <boost/icl/interval_map.hpp>
+#include <boost/icl/interval_set.hpp>
 #include <cassert>
 #include <cmath>
+#include <numeric>
 #include <set>
 
 using namespace poplar;
@@ -115,6 +120,437 @@ static Tensor broadcastChannelToMatch(const Tensor &ref, const Tensor &t) {
   return t.flatten().expand(std::vector<std::size_t>(ref.rank() - 2, 1));
 }
 
+// View a tensor of shape [N][C][..F..] as [N][C/G][..F..][G], flattened.
+static Tensor groupChannels(const Tensor &t, unsigned groupSize) {
+  const auto t3D = t.rank() == 2 ? t.expand({2}) : t.flatten(2, t.rank());
+  return t3D.reshapePartial(1, 2, {t.dim(1) / groupSize, groupSize})
+      .dimRoll(2, 3)
+      .flatten();
+}
+
+// How per channel partials are computed on the tiles from activations of
+// shape [N][C][..F..]. The activations are viewed as [N][C/G][..F..][G],
+// where G channels are contiguous in memory so the regions on each tile are
+// long, or as [N][C] when there is no field. Each vertex computes a single
+// partial for each of the channels of its segments, so a channel has at most
+// one partial per worker on a tile. The elements of a segment cycle through
+// the channels of a group, starting from the partial at its offset.
+struct ChannelPartials {
+  unsigned groupSize;
+  // The tile and segments of each vertex, the offset into its partials of
+  // the first element of each segment and the channel of each partial.
+  struct VertexPartials {
+    unsigned tile;
+    std::vector<Interval> segments;
+    std::vector<unsigned> offsets;
+    std::vector<std::size_t> channels;
+  };
+  std::vector<VertexPartials> vertices;
+  // For each channel, the index of each of its partials in the order of the
+  // vertices.
+  std::vector<std::vector<std::size_t>> channelPartials;
+};
+
+// Add a segment of the grouped activations, split so that each part either
+// starts at the first channel of a group or doesn't wrap around the group.
+static void addGroupSegment(std::vector<Interval> &segments, std::size_t begin,
+                            std::size_t end, std::size_t groupSize) {
+  const auto groupEnd = (begin / groupSize + 1) * groupSize;
+  if (begin % groupSize != 0 && groupEnd < end) {
+    segments.emplace_back(begin, groupEnd);
+    begin = groupEnd;
+  }
+  segments.emplace_back(begin, end);
+}
+
+static ChannelPartials getChannelPartials(const Graph &graph,
+                                          const Tensor &acts) {
+  const auto &target = graph.getTarget();
+  const auto numWorkers = target.getNumWorkerContexts();
+  const auto numChannels = acts.dim(1);
+  const auto acts3D =
+      acts.rank() == 2 ? acts.expand({2}) : acts.flatten(2, acts.rank());
+  const auto fieldSize = acts3D.dim(2);
+  ChannelPartials result;
+  // Without a field each row of channels is a single group.
+  result.groupSize = fieldSize == 1
+                         ? numChannels
+                         : detectInnermostGrouping(graph, acts3D.dimRoll(1, 2));
+  if (numChannels % result.groupSize != 0) {
+    result.groupSize = 1;
+  }
+  const std::size_t groupSize = result.groupSize;
+  const auto numGroups = numChannels / groupSize;
+  const auto blockSize = fieldSize * groupSize;
+  // Pieces of the regions mustn't span blocks of different groups, and
+  // consecutive blocks are only in the same group when there is one group.
+  const auto pieceSize = numGroups == 1 ? acts.numElements() : blockSize;
+  const auto groupOf = [&](std::size_t i) {
+    return (i / blockSize) % numGroups;
+  };
+  const auto grouped = groupChannels(acts, groupSize);
+  const auto mapping = graph.getTileMapping(grouped);
+  result.channelPartials.resize(numChannels);
+  std::size_t numPartials = 0;
+  for (unsigned tile = 0; tile != mapping.size(); ++tile) {
+    const auto regions =
+        graph.getSortedContiguousRegions(grouped, mapping[tile]);
+    std::vector<Interval> pieces;
+    for (const auto &r : regions) {
+      for (const auto &i : r) {
+        for (auto begin = i.begin(); begin != i.end();) {
+          const auto end =
+              std::min(i.end(), (begin / pieceSize + 1) * pieceSize);
+          pieces.emplace_back(begin, end);
+          begin = end;
+        }
+      }
+    }
+    if (pieces.empty()) {
+      continue;
+    }
+
+    // Count the elements of each channel on the tile.
+    std::vector<std::size_t> channelElements(numChannels + 1);
+    std::size_t tileElements = 0;
+    for (const auto &p : pieces) {
+      const auto first = groupOf(p.begin()) * groupSize;
+      const auto last = first + groupSize;
+      const auto begin = first + p.begin() % groupSize;
+      const auto cycles = p.size() / groupSize;
+      const auto rem = p.size() % groupSize;
+      channelElements[first] += cycles;
+      channelElements[last] -= cycles;
+      ++channelElements[begin];
+      if (begin + rem <= last) {
+        --channelElements[begin + rem];
+      } else {
+        --channelElements[last];
+        ++channelElements[first];
+        --channelElements[begin + rem - groupSize];
+      }
+      tileElements += p.size();
+    }
+    std::partial_sum(channelElements.begin(), channelElements.end(),
+                     channelElements.begin());
+    std::size_t tileGroups = 0;
+    for (std::size_t g = 0; g != numGroups; ++g) {
+      tileGroups += std::any_of(channelElements.begin() + g * groupSize,
+                                channelElements.begin() + (g + 1) * groupSize,
+                                [](std::size_t n) { return n != 0; });
+    }
+    const auto workerElements = ceildiv(tileElements, numWorkers);
+    // Without a field splitting the channels gives a segment per row of each
+    // worker's channels, so only do it when the tile has enough channels for
+    // these segments to be long.
+    const std::size_t minSegmentSize = 8;
+    const auto tileChannels = static_cast<std::size_t>(
+        std::count_if(channelElements.begin(), channelElements.end() - 1,
+                      [](std::size_t n) { return n != 0; }));
+    const bool splitChannels = fieldSize == 1
+                                   ? tileChannels >= numWorkers * minSegmentSize
+                                   : tileGroups >= numWorkers;
+
+    std::vector<std::vector<Interval>> workerSegments;
+    if (splitChannels) {
+      // Split the channels on the tile between the workers, whole groups at a
+      // time when there is a field so that the segments are long.
+      const auto unitSize = fieldSize == 1 ? 1 : groupSize;
+      std::vector<std::pair<std::size_t, std::size_t>> ranges;
+      std::size_t rangeBegin = 0, rangeElements = 0;
+      for (std::size_t c = 0; c != numChannels; c += unitSize) {
+        rangeElements +=
+            std::accumulate(channelElements.begin() + c,
+                            channelElements.begin() + c + unitSize,
+                            std::size_t(0));
+        if (rangeElements >= workerElements || c + unitSize == numChannels) {
+          if (rangeElements != 0) {
+            ranges.emplace_back(rangeBegin, c + unitSize);
+          }
+          rangeBegin = c + unitSize;
+          rangeElements = 0;
+        }
+      }
+      for (const auto &range : ranges) {
+        workerSegments.emplace_back();
+        auto &segments = workerSegments.back();
+        for (const auto &p : pieces) {
+          const auto first = groupOf(p.begin()) * groupSize;
+          const auto last = first + groupSize;
+          if (range.first <= first && last <= range.second) {
+            addGroupSegment(segments, p.begin(), p.end(), groupSize);
+          } else if (range.first < last && first < range.second) {
+            // Only some of the channels of the group are in the range, so
+            // there is a segment for each row of the group's channels.
+            const auto lo = std::max(range.first, first) - first;
+            const auto hi = std::min(range.second, last) - first;
+            for (auto row = p.begin() / groupSize * groupSize; row < p.end();
+                 row += groupSize) {
+              const auto begin = std::max(p.begin(), row + lo);
+              const auto end = std::min(p.end(), row + hi);
+              if (begin < end) {
+                segments.emplace_back(begin, end);
+              }
+            }
+          }
+        }
+      }
+    } else {
+      // With few groups or channels on the tile split its elements between
+      // the workers, each of which has a partial for each channel of its
+      // groups.
+      std::size_t elements = workerElements;
+      for (const auto &p : pieces) {
+        for (auto begin = p.begin(); begin != p.end();) {
+          if (elements == workerElements) {
+            workerSegments.emplace_back();
+            elements = 0;
+          }
+          const auto end =
+              std::min(p.end(), begin + (workerElements - elements));
+          addGroupSegment(workerSegments.back(), begin, end, groupSize);
+          elements += end - begin;
+          begin = end;
+        }
+      }
+    }
+
+    for (auto &segments : workerSegments) {
+      boost::icl::interval_set<std::size_t> channelSet;
+      for (const auto &s : segments) {
+        const auto first = groupOf(s.begin()) * groupSize;
+        const auto begin = first + s.begin() % groupSize;
+        const auto end = std::min(begin + s.size(), first + groupSize);
+        channelSet += boost::icl::interval<std::size_t>::right_open(
+            s.size() >= groupSize ? first : begin, end);
+      }
+      ChannelPartials::VertexPartials v;
+      v.tile = tile;
+      for (const auto &i : channelSet) {
+        for (auto c = i.lower(); c != i.upper(); ++c) {
+          result.channelPartials[c].push_back(numPartials++);
+          v.channels.push_back(c);
+        }
+      }
+      for (const auto &s : segments) {
+        const auto c = groupOf(s.begin()) * groupSize + s.begin() % groupSize;
+        v.offsets.push_back(
+            std::lower_bound(v.channels.begin(), v.channels.end(), c) -
+            v.channels.begin());
+      }
+      v.segments = std::move(segments);
+      result.vertices.push_back(std::move(v));
+    }
+  }
+  return result;
+}
+
+// Arrange partials indexed as in channelPartials as [C][maxPartials],
+// padding channels with fewer partials with zeros.
+static Tensor
+padChannelPartials(Graph &graph,
+                   const std::vector<std::vector<std::size_t>> &channelPartials,
+                   const Tensor &partials, const std::string &debugPrefix) {
+  std::size_t maxPartials = 0;
+  for (const auto &p : channelPartials) {
+    maxPartials = std::max(maxPartials, p.size());
+  }
+  auto zero = graph.addConstant(partials.elementType(), {1}, 0.0f,
+                                debugPrefix + "/Zero");
+  graph.setTileMapping(zero, 0);
+  std::vector<Tensor> padded;
+  for (const auto &p : channelPartials) {
+    for (std::size_t i = 0; i != maxPartials; ++i) {
+      padded.push_back(i < p.size() ? partials.slice(p[i], p[i] + 1) : zero);
+    }
+  }
+  return concat(padded).reshape({channelPartials.size(), maxPartials});
+}
+
+// Mean and variance of each channel in a single pass over the activations.
+// The number of elements, mean and sum of squared differences from the mean
+// of each channel of the segments of a vertex are computed with Welford's
+// algorithm, and the partials of each channel are combined with Chan's
+// method by two small reductions.
+static std::pair<Tensor, Tensor>
+welfordStatistics(Graph &graph, const Tensor &acts, const Type &partialsType,
+                  Sequence &prog, const std::string &debugPrefix) {
+  const auto dType = acts.elementType();
+  const auto numElements = acts.numElements() / acts.dim(1);
+  const auto partials = getChannelPartials(graph, acts);
+  const auto groupSize = partials.groupSize;
+  const auto grouped = groupChannels(acts, groupSize);
+
+  const auto cs = graph.addComputeSet(debugPrefix + "/Partials");
+  const auto vertexClass = templateVertex("poplin::WelfordStatistics", dType);
+  std::vector<Tensor> vertexPartials;
+  for (const auto &v : partials.vertices) {
+    auto vPartials = graph.addVariable(FLOAT, {3, v.channels.size()},
+                                       debugPrefix + "/Partials");
+    auto vOffsets =
+        graph.addConstant(UNSIGNED_INT, {v.offsets.size()}, v.offsets.data(),
+                          debugPrefix + "/Offsets");
+    graph.setTileMapping(vPartials, v.tile);
+    graph.setTileMapping(vOffsets, v.tile);
+    auto vertex = graph.addVertex(cs, vertexClass,
+                                  {{"in", grouped.slices(v.segments)},
+                                   {"offsets", vOffsets},
+                                   {"count", vPartials[0]},
+                                   {"mean", vPartials[1]},
+                                   {"m2", vPartials[2]}});
+    graph.setInitialValue(vertex["groupSize"], groupSize);
+    graph.setTileMapping(vertex, v.tile);
+    vertexPartials.push_back(vPartials);
+  }
+  prog.add(Execute(cs));
+
+  // Partials padded with zeros have a count of zero so they don't contribute.
+  const auto allPartials = concat(vertexPartials, 1);
+  const auto count = padChannelPartials(graph, partials.channelPartials,
+                                        allPartials[0], debugPrefix);
+  const auto paddedMean = padChannelPartials(graph, partials.channelPartials,
+                                             allPartials[1], debugPrefix);
+  const auto paddedM2 = padChannelPartials(graph, partials.channelPartials,
+                                           allPartials[2], debugPrefix);
+  auto scale = graph.addConstant(FLOAT, {}, 1.0f / numElements,
+                                 debugPrefix + "/constantScale");
+  graph.setTileMapping(scale, 0);
+
+  using namespace popops::expr;
+  const auto meanFloat = popops::reduce(
+      graph,
+      popops::map(graph, _1 * _2, {count, paddedMean}, prog,
+                  debugPrefix + "/WeightMean"),
+      FLOAT, {1}, {popops::Operation::ADD, false, scale}, prog,
+      debugPrefix + "/Mean");
+  const auto m2Terms = popops::map(
+      graph, _1 + _2 * Square(_3 - _4),
+      {paddedM2, count, paddedMean,
+       meanFloat.expand({1}).broadcast(count.dim(1), 1)},
+      prog, debugPrefix + "/M2Terms");
+
+  auto mean = createBroadcastOperand(graph, acts, dType, 1, true,
+                                     debugPrefix + "/Mean");
+  auto power = graph.clone(partialsType, mean, debugPrefix + "/Variance");
+  popops::reduceWithOutput(graph, m2Terms, power, {1},
+                           {popops::Operation::ADD, false, scale}, prog,
+                           debugPrefix + "/Variance");
+  prog.add(popops::cast(graph, meanFloat, mean, debugPrefix + "/Mean"));
+  return std::make_pair(mean, power);
+}
+
+// Gradients through the norm statistics layer, multiplied by gamma if it is
+// given, with
+//   gradsOut = Br{a} .* (gradsIn - actsWhitened .* Br{b} - Br{d})
+// where a = invStdDev .* gamma, b = rScale * Re{actsWhitened .* gradsIn} and
+// d = rScale * Re{gradsIn}. Re{} reduces over all dimensions other than the
+// channels and Br{} broadcasts along them. One compute set computes partials
+// of both sums from segments of the activations on each tile, which are
+// combined by one small reduction, and a second one computes the gradients
+// from the same segments.
+static Tensor fusedNormGradients(Graph &graph, const Tensor &actsWhitened,
+                                 const Tensor &gradsIn,
+                                 const Tensor &invStdDev, const Tensor *gamma,
+                                 Sequence &prog,
+                                 const std::string &debugPrefix) {
+  const auto dType = actsWhitened.elementType();
+  if (gradsIn.elementType() != dType) {
+    throw poplibs_error("Norm gradients must be the same type as the "
+                        "whitened activations");
+  }
+  const auto numElements = actsWhitened.numElements() / actsWhitened.dim(1);
+  const float rScale = 1.0f / numElements;
+  const auto partials = getChannelPartials(graph, actsWhitened);
+  const auto groupSize = partials.groupSize;
+  const auto groupedActs = groupChannels(actsWhitened, groupSize);
+  const auto groupedGrads = groupChannels(gradsIn, groupSize);
+  auto gradsOut = graph.clone(actsWhitened, debugPrefix + "/gradsOut");
+  const auto groupedGradsOut = groupChannels(gradsOut, groupSize);
+
+  const auto sumsCS = graph.addComputeSet(debugPrefix + "/Partials");
+  const auto gradsCS = graph.addComputeSet(debugPrefix + "/Gradients");
+  const auto sumsVertexClass =
+      templateVertex("poplin::NormGradientPartials", dType);
+  const auto gradsVertexClass = templateVertex("poplin::NormGradients", dType);
+  std::vector<Tensor> partialSums, coeffs;
+  for (const auto &v : partials.vertices) {
+    const auto tile = v.tile;
+    const auto n = v.channels.size();
+    const auto vIn = groupedActs.slices(v.segments);
+    const auto vGrads = groupedGrads.slices(v.segments);
+    auto vOffsets =
+        graph.addConstant(UNSIGNED_INT, {v.offsets.size()}, v.offsets.data(),
+                          debugPrefix + "/Offsets");
+    auto vSums = graph.addVariable(FLOAT, {2, n}, debugPrefix + "/PartialSums");
+    auto vCoeffs = graph.addVariable(FLOAT, {n, 3}, debugPrefix + "/Coeffs");
+    graph.setTileMapping(vOffsets, tile);
+    graph.setTileMapping(vSums, tile);
+    graph.setTileMapping(vCoeffs, tile);
+    auto sumsV = graph.addVertex(sumsCS, sumsVertexClass,
+                                 {{"actsWhitened", vIn},
+                                  {"gradsIn", vGrads},
+                                  {"offsets", vOffsets},
+                                  {"sumGrads", vSums[0]},
+                                  {"sumGradsActs", vSums[1]}});
+    graph.setInitialValue(sumsV["groupSize"], groupSize);
+    graph.setTileMapping(sumsV, tile);
+    const auto vGradsOut = groupedGradsOut.slices(v.segments);
+    auto gradsV = graph.addVertex(gradsCS, gradsVertexClass,
+                                  {{"actsWhitened", vIn},
+                                   {"gradsIn", vGrads},
+                                   {"gradsOut", vGradsOut},
+                                   {"offsets", vOffsets},
+                                   {"coeffs", vCoeffs.flatten()}});
+    graph.setInitialValue(gradsV["groupSize"], groupSize);
+    graph.setTileMapping(gradsV, tile);
+    partialSums.push_back(vSums);
+    coeffs.push_back(vCoeffs);
+  }
+  prog.add(Execute(sumsCS));
+
+  // Combine the partials of each channel.
+  const auto sums = concat(partialSums, 1);
+  const auto paddedGrads = padChannelPartials(graph, partials.channelPartials,
+                                              sums[0], debugPrefix);
+  const auto paddedGradsActs = padChannelPartials(
+      graph, partials.channelPartials, sums[1], debugPrefix);
+  const auto padded =
+      concat(paddedGrads.expand({0}), paddedGradsActs.expand({0}));
+  const auto channelSums =
+      popops::reduce(graph, padded, FLOAT, {2}, popops::Operation::ADD, prog,
+                     debugPrefix + "/Sums");
+
+  // Form the coefficients of each channel and copy those of the channels of
+  // each vertex to its tile, a range of consecutive channels at a time.
+  using namespace popops::expr;
+  const auto scale =
+      gamma ? popops::map(graph, Cast(_1, FLOAT) * Cast(_2, FLOAT),
+                          {invStdDev.flatten(), gamma->flatten()}, prog,
+                          debugPrefix + "/Scale")
+            : popops::cast(graph, invStdDev.flatten(), FLOAT, prog,
+                           debugPrefix + "/Scale");
+  const auto scaledSums = popops::map(graph, _1 * rScale, {channelSums}, prog,
+                                      debugPrefix + "/ScaleSums");
+  const auto channelCoeffs =
+      concat({scale.expand({1}), scaledSums[1].expand({1}),
+              scaledSums[0].expand({1})},
+             1);
+  std::vector<Tensor> vertexCoeffs;
+  for (const auto &v : partials.vertices) {
+    const auto &channels = v.channels;
+    for (std::size_t begin = 0, end = 1; begin != channels.size(); ++end) {
+      if (end == channels.size() || channels[end] != channels[end - 1] + 1) {
+        vertexCoeffs.push_back(channelCoeffs.slice(channels[begin],
+                                                   channels[end - 1] + 1));
+        begin = end;
+      }
+    }
+  }
+  prog.add(Copy(concat(vertexCoeffs), concat(coeffs)));
+  prog.add(Execute(gradsCS));
+  return gradsOut;
+}
+
 std::pair<Tensor, Tensor>
 normStatistics(Graph &graph, const Tensor &acts, float eps, Sequence &prog,
                bool unbiasedVarEstimate, bool stableAlgo,
@@ -132,30 +568,29 @@ normStatistics(Graph &graph, const Tensor &acts, float eps, Sequence &prog,
   const auto powerOutputType = partialsType;
   const auto meanOutputType = acts.elementType();
 
+  if (stableAlgo) {
+    logging::info("Stable statistics estimator used");
+    Tensor mean, variance;
+    std::tie(mean, variance) = welfordStatistics(graph, acts, partialsType,
+                                                 prog, fnPrefix + "/welford");
+    auto iStdDev =
+        computeInvStdDev(graph, mean, variance, eps, scaleVar, prog,
+                         acts.elementType(), stableAlgo, debugPrefix);
+    return std::make_pair(mean, iStdDev);
+  }
+
   std::vector<ComputeSet> css;
   auto mean =
       normReduce(graph, acts, 1.0f / numElements, false, css, partialsType,
                  meanOutputType, nullptr, fnPrefix + "/mean");
 
-  auto maybeZeroMeanActs = acts;
-  if (stableAlgo) {
-    for (const auto &cs : css) {
-      prog.add(Execute(cs));
-    }
-    css.clear();
-    logging::info("Stable statistics estimator used");
-    using namespace popops::expr;
-    maybeZeroMeanActs = popops::map(graph, _1 - Cast(_2, acts.elementType()),
-                                    {acts, broadcastChannelToMatch(acts, mean)},
-                                    prog, fnPrefix + "/removeMean");
-  }
   // The actual output type for squared sum may be different as the dynamic
   // range is higher. The selection should be based on actual statistics
   // gathered from training experiments. For now keep it at reduced precision
   // to save memory
-  auto power =
-      normReduce(graph, maybeZeroMeanActs, 1.0f / numElements, true, css,
-                 partialsType, powerOutputType, &mean, fnPrefix + "/power");
+  auto power = normReduce(graph, acts, 1.0f / numElements, true, css,
+                          partialsType, powerOutputType, &mean,
+                          fnPrefix + "/power");
 
   for (const auto &cs : css) {
     prog.add(Execute(cs));
@@ -287,53 +722,27 @@ Tensor normStatisticsGradients(Graph &graph, const Tensor &actsWhitened,
                 actsWhitened.shape(), gradsIn.shape(), invStdDev.shape(),
                 fnPrefix);
 
-  const auto actsShape = actsWhitened.shape();
-  const auto numElements = actsWhitened.numElements() / actsWhitened.dim(1);
-  const float rScale = 1.0f / numElements;
-
   auto gradsInMaybeRegrouped = popops::rearrange::regroupIfBeneficial(
       graph, gradsIn, actsWhitened, prog, debugPrefix);
+  return fusedNormGradients(graph, actsWhitened, gradsInMaybeRegrouped,
+                            invStdDev, nullptr, prog, fnPrefix);
+}
 
-  // split rScale = rScale1 * rScale2;
-  // TODO: T12898 Research what the optimal split would be dependent on model
-  // and field size.
-  const auto scaleSplit = 3.0f / 4;
-  const float rScale1 = std::pow(rScale, scaleSplit);
-  const float rScale2 = rScale / rScale1;
-
-  Tensor varDelta, meanDelta;
-  // See Description of Re{} operator in normParamGradients
-  // varDelta = Re{actsWhitened .* gradsIn} * -rScale
-  //   Size of varDelta is the size of inverse standard deviation
-  // meanDelta = Re{gradsIn} * -rScale
-  std::tie(varDelta, meanDelta) =
-      normParamGradients(graph, actsWhitened, gradsInMaybeRegrouped, -rScale1,
-                         prog, partialsType, false, debugPrefix);
-
-  auto gradient = graph.clone(actsWhitened, fnPrefix + "/gradsIn");
-  prog.add(Copy(gradsInMaybeRegrouped, gradient));
-
-  // gradOut = gradsIn - rScale * actsWhitened .* Br{varDelta}
-  // where Br{x} broadcast x along all dimensions other than dim(1) of
-  // actsWhitened
-  // gradsOut = gradsIn - rScale * actsWhitened .* Br{varDelta} + Br{meanDelta}
-
-  auto varDeltaBroadcast = broadcastChannelToMatch(actsWhitened, varDelta);
-  auto varGrads =
-      mul(graph, actsWhitened, varDeltaBroadcast, prog, fnPrefix + "/varGrads");
-  mulInPlace(graph, meanDelta, rScale2, prog, fnPrefix + "/scaleMeanDelta");
-  auto meanDeltaBroadcast = broadcastChannelToMatch(gradient, meanDelta);
-  addInPlace(graph, gradient, meanDeltaBroadcast, prog,
-             fnPrefix + "/meanGrads");
-  // TODO: T12899 Once scaledAddTo is targeted efficiently in element-wise ops,
-  // this should become a mapInPlace() expression.
-  scaledAddTo(graph, gradient, varGrads, rScale2, prog, fnPrefix + "/addGrads");
-
-  // Br{invStdDev} .* (gradsIn - rScale * actsWhitened .* Br{varDelta}
-  //                   + Br{meanDelta})
-  auto invStdDevBroadcast = broadcastChannelToMatch(gradient, invStdDev);
-  mulInPlace(graph, gradient, invStdDevBroadcast, prog, fnPrefix);
-  return gradient;
+Tensor normStatisticsGradients(Graph &graph, const Tensor &actsWhitened,
+                               const Tensor &gradsIn, const Tensor &invStdDev,
+                               const Tensor &gamma, Sequence &prog,
+                               const Type &partialsType, // currently unused
+                               const std::string &debugPrefix) {
+  const auto fnPrefix = debugPrefix + "/Norm/gradients";
+  logging::info("normStatisticsGradients actsWhitened={}, gradsIn={}, "
+                "invStdDev={}, gamma={}, name={}",
+                actsWhitened.shape(), gradsIn.shape(), invStdDev.shape(),
+                gamma.shape(), fnPrefix);
+
+  auto gradsInMaybeRegrouped = popops::rearrange::regroupIfBeneficial(
+      graph, gradsIn, actsWhitened, prog, debugPrefix);
+  return fusedNormGradients(graph, actsWhitened, gradsInMaybeRegrouped,
+                            invStdDev, &gamma, prog, fnPrefix);
 }
 
 } // namespace poplin
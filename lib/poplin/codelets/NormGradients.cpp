@@ -0,0 +1,92 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#include "poplibs_support/ExternalCodelet.hpp"
+#include <poplar/HalfFloat.hpp>
+#include <poplar/Vertex.hpp>
+
+using namespace poplar;
+static constexpr auto ONE_PTR = poplar::VectorLayout::ONE_PTR;
+
+namespace poplin {
+
+// Sums over each channel of segments of the gradients and of the gradients
+// multiplied by the whitened activations. The elements of a segment cycle
+// through groupSize channels and element i of segment s is added to the sums
+// at offsets[s] + i % groupSize.
+template <typename FPType> class NormGradientPartials : public Vertex {
+public:
+  NormGradientPartials();
+
+  Vector<Input<Vector<FPType>>> actsWhitened;
+  Vector<Input<Vector<FPType, ONE_PTR>>, ONE_PTR> gradsIn;
+  Input<Vector<unsigned, ONE_PTR>> offsets;
+  Output<Vector<float>> sumGrads;
+  Output<Vector<float, ONE_PTR>> sumGradsActs;
+  const unsigned groupSize;
+
+  IS_EXTERNAL_CODELET(false);
+  bool compute() {
+    for (unsigned p = 0; p != sumGrads.size(); ++p) {
+      sumGrads[p] = 0.0f;
+      sumGradsActs[p] = 0.0f;
+    }
+    for (unsigned s = 0; s != actsWhitened.size(); ++s) {
+      const unsigned size = actsWhitened[s].size();
+      for (unsigned k = 0; k != groupSize && k != size; ++k) {
+        const unsigned p = offsets[s] + k;
+        float sum = sumGrads[p];
+        float sumActs = sumGradsActs[p];
+        for (unsigned i = k; i < size; i += groupSize) {
+          const float grad = float(gradsIn[s][i]);
+          sum += grad;
+          sumActs += grad * float(actsWhitened[s][i]);
+        }
+        sumGrads[p] = sum;
+        sumGradsActs[p] = sumActs;
+      }
+    }
+    return true;
+  }
+};
+
+template class NormGradientPartials<float>;
+template class NormGradientPartials<half>;
+
+// Gradients with respect to the input of a normalisation from the gradients
+// of its output. The channels of the elements of the segments are found as
+// for NormGradientPartials, and coeffs holds the scale a followed by the
+// coefficients b and d of each of them. The gradient is
+// a * (gradsIn - b * actsWhitened - d).
+template <typename FPType> class NormGradients : public Vertex {
+public:
+  NormGradients();
+
+  Vector<Input<Vector<FPType>>> actsWhitened;
+  Vector<Input<Vector<FPType, ONE_PTR>>, ONE_PTR> gradsIn;
+  Vector<Output<Vector<FPType, ONE_PTR>>, ONE_PTR> gradsOut;
+  Input<Vector<unsigned, ONE_PTR>> offsets;
+  Input<Vector<float, ONE_PTR>> coeffs;
+  const unsigned groupSize;
+
+  IS_EXTERNAL_CODELET(false);
+  bool compute() {
+    for (unsigned s = 0; s != actsWhitened.size(); ++s) {
+      const unsigned size = actsWhitened[s].size();
+      for (unsigned k = 0; k != groupSize && k != size; ++k) {
+        const unsigned p = offsets[s] + k;
+        const float a = coeffs[3 * p];
+        const float b = coeffs[3 * p + 1];
+        const float d = coeffs[3 * p + 2];
+        for (unsigned i = k; i < size; i += groupSize) {
+          const float x = float(actsWhitened[s][i]);
+          gradsOut[s][i] = FPType(a * (float(gradsIn[s][i]) - b * x - d));
+        }
+      }
+    }
+    return true;
+  }
+};
+
+template class NormGradients<float>;
+template class NormGradients<half>;
+
+} // end namespace poplin
@@ -0,0 +1,60 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#include "poplibs_support/ExternalCodelet.hpp"
+#include <poplar/HalfFloat.hpp>
+#include <poplar/Vertex.hpp>
+
+using namespace poplar;
+static constexpr auto ONE_PTR = poplar::VectorLayout::ONE_PTR;
+
+namespace poplin {
+
+// Number of elements, mean and sum of squared differences from the mean of
+// each channel in segments of activations, using Welford's algorithm. The
+// elements of a segment cycle through groupSize channels and element i of
+// segment s is accumulated into the partials at offsets[s] + i % groupSize,
+// so the partials of a channel combine all of its elements in the segments.
+template <typename FPType> class WelfordStatistics : public Vertex {
+public:
+  WelfordStatistics();
+
+  Vector<Input<Vector<FPType>>> in;
+  Input<Vector<unsigned, ONE_PTR>> offsets;
+  Output<Vector<float>> count;
+  Output<Vector<float, ONE_PTR>> mean;
+  Output<Vector<float, ONE_PTR>> m2;
+  const unsigned groupSize;
+
+  IS_EXTERNAL_CODELET(false);
+  bool compute() {
+    for (unsigned p = 0; p != count.size(); ++p) {
+      count[p] = 0.0f;
+      mean[p] = 0.0f;
+      m2[p] = 0.0f;
+    }
+    for (unsigned s = 0; s != in.size(); ++s) {
+      const unsigned size = in[s].size();
+      for (unsigned k = 0; k != groupSize && k != size; ++k) {
+        const unsigned p = offsets[s] + k;
+        float runningCount = count[p];
+        float runningMean = mean[p];
+        float runningM2 = m2[p];
+        for (unsigned i = k; i < size; i += groupSize) {
+          const float x = float(in[s][i]);
+          runningCount += 1.0f;
+          const float delta = x - runningMean;
+          runningMean += delta / runningCount;
+          runningM2 += delta * (x - runningMean);
+        }
+        count[p] = runningCount;
+        mean[p] = runningMean;
+        m2[p] = runningM2;
+      }
+    }
+    return true;
+  }
+};
+
+template class WelfordStatistics<float>;
+template class WelfordStatistics<half>;
+
+} // end namespace poplin
@@ -384,6 +384,56 @@ std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(InverseStdDeviation)(
   return cycles;
 }
 
+std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(NormGradientPartials)(
+    const VertexIntrospector &vertex, const Target &target, const Type &type) {
+  CODELET_FIELD(actsWhitened);
+  CODELET_FIELD(sumGrads);
+  const auto groupSize =
+      vertex.getFieldInfo("groupSize").getInitialValue<unsigned>(target);
+  // The sums are zeroed first.
+  uint64_t cycles = 5 + sumGrads.size() * 2;
+  for (unsigned s = 0; s < actsWhitened.size(); ++s) {
+    // Two loads and two accumulations per element of a strided pass, which
+    // loads and stores its sums.
+    const auto passes =
+        std::min<std::size_t>(groupSize, actsWhitened[s].size());
+    cycles += 5 + passes * 8 + actsWhitened[s].size() * 4;
+  }
+  return cycles;
+}
+
+std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(NormGradients)(
+    const VertexIntrospector &vertex, const Target &target, const Type &type) {
+  CODELET_FIELD(actsWhitened);
+  const auto groupSize =
+      vertex.getFieldInfo("groupSize").getInitialValue<unsigned>(target);
+  uint64_t cycles = 5;
+  for (unsigned s = 0; s < actsWhitened.size(); ++s) {
+    // Coefficients are loaded once per strided pass.
+    const auto passes =
+        std::min<std::size_t>(groupSize, actsWhitened[s].size());
+    cycles += 5 + passes * 8 + actsWhitened[s].size() * 5;
+  }
+  return cycles;
+}
+
+std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(WelfordStatistics)(
+    const VertexIntrospector &vertex, const Target &target, const Type &type) {
+  CODELET_FIELD(in);
+  CODELET_FIELD(count);
+  const auto groupSize =
+      vertex.getFieldInfo("groupSize").getInitialValue<unsigned>(target);
+  // The partials are zeroed first.
+  uint64_t cycles = 5 + count.size() * 3;
+  for (unsigned s = 0; s < in.size(); ++s) {
+    // Each channel of the group is a strided pass over the segment with a
+    // divide per element, which loads and stores its partials.
+    const auto passes = std::min<std::size_t>(groupSize, in[s].size());
+    cycles += 5 + passes * 12 + in[s].size() * 12;
+  }
+  return cycles;
+}
+
 std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(OuterProduct)(
     const VertexIntrospector &vertex, const Target &target, const Type &type) {
   CODELET_FIELD(in);
@@ -440,6 +490,14 @@ poplibs::CycleEstimatorTable makeCyclesFunctionTable() {
       CYCLE_ESTIMATOR_ENTRY(poplin, InverseStdDeviation, HALF, HALF, HALF,
                             false),
 
+      CYCLE_ESTIMATOR_ENTRY(poplin, NormGradientPartials, FLOAT),
+      CYCLE_ESTIMATOR_ENTRY(poplin, NormGradientPartials, HALF),
+      CYCLE_ESTIMATOR_ENTRY(poplin, NormGradients, FLOAT),
+      CYCLE_ESTIMATOR_ENTRY(poplin, NormGradients, HALF),
+
+      CYCLE_ESTIMATOR_ENTRY(poplin, WelfordStatistics, FLOAT),
+      CYCLE_ESTIMATOR_ENTRY(poplin, WelfordStatistics, HALF),
+
       CYCLE_ESTIMATOR_ENTRY(poplin, WgdConvComplete, FLOAT),
       CYCLE_ESTIMATOR_ENTRY(poplin, WgdConvComplete, HALF),
 
@@ -108,10 +108,9 @@ Tensor batchNormGradients(Graph &graph, const Tensor &actsWhitened_,
   checkTensorShape(gradsIn_);
   auto actsWhitened = preProcessNormActs(actsWhitened_);
   auto gradsIn = preProcessNormActs(gradsIn_);
-  auto gradsNorm =
-      poplin::normGradients(graph, gradsIn, gamma, prog, debugPrefix);
-  auto gradsOut = poplin::normStatisticsGradients(
-      graph, actsWhitened, gradsNorm, iStdDev, prog, partialsType, debugPrefix);
+  auto gradsOut =
+      poplin::normStatisticsGradients(graph, actsWhitened, gradsIn, iStdDev,
+                                      gamma, prog, partialsType, debugPrefix);
   return postProcessNormActs(gradsOut, rank);
 }
 
@@ -1,5 +1,6 @@
 // Copyright (c) 2016 Graphcore Ltd. All rights reserved.
 #include "popnn/Loss.hpp"
+#include "NonLinearityInternal.hpp"
 
 #include "poplar/Graph.hpp"
 #include "poplibs_support/Algorithm.hpp"
@@ -114,6 +115,199 @@ Tensor onTileTransform(Graph &graph, const Tensor &modelOutputs,
   return transformed;
 }
 
+// Softmax followed by cross entropy loss, computed from logits without
+// materialising the probabilities. A first compute set finds the maximum of
+// each segment of a row on a tile, the sum of the exponentials relative to it
+// and the logit of the label. These partials are combined for each row and
+// a second compute set writes the deltas from the maximum and the sum of
+// each row. All the statistics are kept in float.
+Program softmaxCrossEntropyLoss(Graph &graph, const Tensor &logits,
+                                const Tensor &labels, const Tensor &loss,
+                                const Tensor &deltas,
+                                const boost::optional<Tensor> &deltasScale,
+                                const std::string &debugPrefix) {
+  const auto &target = graph.getTarget();
+  const auto dType = logits.elementType();
+  const auto labelType = labels.elementType();
+  if (dType != FLOAT && dType != HALF) {
+    throw poplibs_error("calcLoss: softmax cross entropy loss is only "
+                        "supported for float and half model outputs");
+  }
+  if (labelType != UNSIGNED_INT && labelType != INT) {
+    throw poplibs_error("calcLoss: softmax cross entropy loss is only "
+                        "supported for unsigned int and int labels");
+  }
+  const auto batchSize = logits.dim(0);
+  const auto numClasses = logits.dim(1);
+  if (batchSize == 0 || numClasses == 0) {
+    throw poplibs_error("calcLoss: softmax cross entropy loss requires "
+                        "at least one row and one class");
+  }
+
+  Sequence prog;
+  const auto logitsFlat = logits.flatten();
+  const auto deltasFlat = deltas.flatten();
+  const auto mapping = graph.getTileMapping(logits);
+
+  // Find the segments of the rows computed by each vertex.
+  struct VertexSegments {
+    unsigned tile;
+    std::vector<RowSegment> segments;
+  };
+  std::vector<VertexSegments> vertices;
+  std::vector<RowSegment> segments;
+  for (unsigned tile = 0; tile != mapping.size(); ++tile) {
+    const auto regions =
+        graph.getSortedContiguousRegions(logitsFlat, mapping[tile]);
+    for (auto &s : getWorkerRowSegments(target, regions, numClasses)) {
+      segments.insert(segments.end(), s.begin(), s.end());
+      vertices.push_back({tile, std::move(s)});
+    }
+  }
+  const auto numSegments = segments.size();
+  logging::debug("Softmax cross entropy loss of {} rows split into {} "
+                 "segments on {} vertices",
+                 batchSize, numSegments, vertices.size());
+
+  // The label, partial statistics and row statistics of each segment live on
+  // the tile of the vertex which uses it.
+  auto segLabels = graph.addVariable(labelType, {numSegments},
+                                     debugPrefix + "/SegmentLabels");
+  auto segStats =
+      graph.addVariable(FLOAT, {numSegments, 3}, debugPrefix + "/SegmentStats");
+  auto segRowStats = graph.addVariable(FLOAT, {numSegments, 3},
+                                       debugPrefix + "/SegmentRowStats");
+  auto statsCS = graph.addComputeSet(debugPrefix + "/SegmentStats");
+  auto gradCS = graph.addComputeSet(debugPrefix + "/Deltas");
+  const auto statsVertexClass =
+      templateVertex("popnn::SoftMaxCrossEntropyStats", dType, labelType);
+  const auto gradVertexClass =
+      templateVertex("popnn::SoftMaxCrossEntropyGrad", dType, labelType);
+  std::size_t first = 0;
+  for (const auto &v : vertices) {
+    const auto n = v.segments.size();
+    std::vector<Tensor> vLogits, vDeltas;
+    std::vector<unsigned> colOffsets;
+    for (const auto &s : v.segments) {
+      vLogits.push_back(logitsFlat.slice(s.begin, s.end));
+      vDeltas.push_back(deltasFlat.slice(s.begin, s.end));
+      colOffsets.push_back(s.begin - s.row * numClasses);
+    }
+    auto vColOffsets = graph.addConstant(UNSIGNED_INT, {n}, colOffsets.data(),
+                                         debugPrefix + "/ColOffsets");
+    const auto vLabels = segLabels.slice(first, first + n);
+    const auto vStats = segStats.slice(first, first + n).flatten();
+    const auto vRowStats = segRowStats.slice(first, first + n).flatten();
+    graph.setTileMapping(vColOffsets, v.tile);
+    graph.setTileMapping(vLabels, v.tile);
+    graph.setTileMapping(vStats, v.tile);
+    graph.setTileMapping(vRowStats, v.tile);
+
+    auto statsV = graph.addVertex(statsCS, statsVertexClass,
+                                  {{"logits", vLogits},
+                                   {"labels", vLabels},
+                                   {"colOffsets", vColOffsets},
+                                   {"stats", vStats}});
+    graph.setTileMapping(statsV, v.tile);
+    auto gradV = graph.addVertex(gradCS, gradVertexClass,
+                                 {{"logits", vLogits},
+                                  {"deltas", vDeltas},
+                                  {"labels", vLabels},
+                                  {"colOffsets", vColOffsets},
+                                  {"rowStats", vRowStats}});
+    graph.setTileMapping(gradV, v.tile);
+    for (const auto &d : vDeltas) {
+      graph.setTileMapping(d, v.tile);
+    }
+    first += n;
+  }
+
+  std::vector<Tensor> labelPerSegment;
+  std::vector<std::vector<unsigned>> rowSegments(batchSize);
+  for (unsigned s = 0; s != numSegments; ++s) {
+    labelPerSegment.push_back(labels.slice(segments[s].row,
+                                           segments[s].row + 1));
+    rowSegments[segments[s].row].push_back(s);
+  }
+  prog.add(Copy(concat(labelPerSegment), segLabels));
+  prog.add(Execute(statsCS));
+
+  // Arrange the partials as [batchSize][maxSegments], padding rows with
+  // fewer segments with partials which don't change the results.
+  std::size_t maxSegments = 0;
+  for (const auto &r : rowSegments) {
+    maxSegments = std::max(maxSegments, r.size());
+  }
+  auto negInf = graph.addConstant(FLOAT, {1, 1},
+                                  -std::numeric_limits<float>::infinity(),
+                                  debugPrefix + "/NegInf");
+  auto zero = graph.addConstant(FLOAT, {1, 2}, 0.0f, debugPrefix + "/Zero");
+  graph.setTileMapping(negInf, 0);
+  graph.setTileMapping(zero, 0);
+  std::vector<Tensor> padded;
+  for (const auto &r : rowSegments) {
+    for (const auto s : r) {
+      padded.push_back(segStats.slice(s, s + 1));
+    }
+    for (auto i = r.size(); i != maxSegments; ++i) {
+      padded.push_back(concat(negInf, zero, 1));
+    }
+  }
+  const auto partials = concat(padded).reshape({batchSize, maxSegments, 3});
+  const auto segMax = partials.slice(0, 1, 2).squeeze({2});
+  const auto segSum = partials.slice(1, 2, 2).squeeze({2});
+  const auto segLabelLogit = partials.slice(2, 3, 2).squeeze({2});
+
+  using namespace popops::expr;
+  const auto rowMax =
+      popops::reduce(graph, segMax, FLOAT, {1}, popops::Operation::MAX, prog,
+                     debugPrefix + "/RowMax");
+  const auto segRowMax = rowMax.expand({1}).broadcast(maxSegments, 1);
+  // Segments of only -infinity, including the padding, have a sum of 0 and
+  // are excluded so a maximum of -infinity doesn't give NaN.
+  const auto rescaledSum = popops::map(
+      graph, Select(_1 * Exp(_2 - _3), Const(0.0f), _1 != Const(0.0f)),
+      {segSum, segMax, segRowMax}, prog, debugPrefix + "/RescaleSums");
+  const auto rowSums = popops::reduce(
+      graph, concat(rescaledSum.expand({0}), segLabelLogit.expand({0})), FLOAT,
+      {2}, popops::Operation::ADD, prog, debugPrefix + "/RowSums");
+  const auto rowSum = rowSums[0];
+  const auto rowLabelLogit = rowSums[1];
+
+  auto maskedLabelCode =
+      graph.addConstant(labelType, {}, MASKED_LABEL_CODE,
+                        debugPrefix + "/MaskedLabelCode");
+  graph.setTileMapping(maskedLabelCode, 0);
+  const auto nonMasked = popops::cast(
+      graph, popops::neq(graph, labels, maskedLabelCode, prog, debugPrefix),
+      FLOAT, prog, debugPrefix);
+
+  // -log(softmax(x)[label]) = log(sum(exp(x - max))) + max - x[label]
+  const auto rowLoss = popops::map(
+      graph, Cast((Log(_1) + _2 - _3) * _4, loss.elementType()),
+      {rowSum, rowMax, rowLabelLogit, nonMasked}, prog, debugPrefix + "/Loss");
+  prog.add(Copy(rowLoss, loss));
+
+  Tensor scale = nonMasked;
+  if (deltasScale) {
+    scale = popops::map(
+        graph, _1 * Cast(_2, FLOAT),
+        {nonMasked, deltasScale->reshape({1}).broadcast(batchSize, 0)}, prog,
+        debugPrefix + "/DeltasScale");
+  }
+  const auto invSum =
+      popops::map(graph, Inv(_1), {rowSum}, prog, debugPrefix + "/InvSum");
+  const auto rowStats =
+      concat({rowMax.expand({1}), invSum.expand({1}), scale.expand({1})}, 1);
+  std::vector<Tensor> rowStatsPerSegment;
+  for (const auto &s : segments) {
+    rowStatsPerSegment.push_back(rowStats.slice(s.row, s.row + 1));
+  }
+  prog.add(Copy(concat(rowStatsPerSegment), segRowStats));
+  prog.add(Execute(gradCS));
+  return std::move(prog);
+}
+
 // Parameters needed to create one ReduceXxxClassGather vertex, for the first
 // stage reduction in argMinOrMax().
 struct ClassGatherVertexInfo {
@@ -287,6 +481,10 @@ Program calcLoss(Graph &graph, const Tensor &modelOutputs,
   }
 
   switch (lossType) {
+  case LossType::SOFTMAX_CROSS_ENTROPY_LOSS:
+    return softmaxCrossEntropyLoss(graph, modelOutputs, expected, loss, deltas,
+                                   deltasScale,
+                                   layerPrefix + "/LossSoftmaxCrossEntropy");
   case LossType::SUM_SQUARED_LOSS:
     layerPrefix += "/LossSumSquared";
     transformVertexClass = "popnn::LossSumSquaredTransform";
@@ -506,158 +704,211 @@ static Tensor argMinOrMax(Graph &graph, const Tensor &input,
   return concat(indexPartials);
 }
 
+// The top elements of part of a row of the input, and the tile they are
+// mapped to. There are k of them unless the part has fewer than k elements.
+struct TopKCandidates {
+  Tensor values;
+  Tensor indices;
+  unsigned tile;
+};
+
+// Find the top k elements of each row of the input in stages, each of which
+// reduces sets of candidates to at most k candidates with a heap per vertex.
+// The first stage concatenates the intervals of a row on each tile and splits
+// them between the workers of the tile, with a heap per worker. Each later
+// stage merges groups of the candidates of the previous stage until one set of
+// k candidates remains for each row. The candidates of a row are ordered by
+// tile so groups are formed from nearby tiles, on the same IPU, first. Each
+// vertex keeps every candidate that could be in the top k so the result is
+// exact, and a vertex with fewer than k elements keeps them all rather than
+// padding its output.
 static Tensor TopKImpl(Graph &graph, const poplar::Tensor &input,
                        poplar::Tensor &indices, const std::size_t k, bool sort,
-                       const Type &argminType, Sequence &prog,
-                       unsigned numCorrectTile,
-                       const std::string &debugPrefix) {
+                       Sequence &prog, const std::string &debugPrefix) {
   const auto layerPrefix = debugPrefix + "/topk";
   const auto &target = graph.getTarget();
-  const auto tilesPerIPU = target.getTilesPerIPU();
+  const auto numTiles = target.getNumTiles();
+  const auto numWorkers = target.getNumWorkerContexts();
   const auto batchSize = input.dim(0);
+  const auto type = input.elementType();
+
+  const auto reduceGatherVertexClass =
+      templateVertex("popnn::ReduceMaxNClassGather", type, sort);
+  const auto reduceSparseVertexClass =
+      templateVertex("popnn::ReduceMaxNClassSparse", type, sort);
+
+  // The minimum number of elements each vertex reduces to k candidates, so
+  // each stage at least halves the number of candidates.
+  const std::size_t minVertexElems = std::max<std::size_t>(k * 2, 32);
+
+  // The elements of a row that a first stage vertex reduces, and the regions
+  // of contiguous elements of the row they are made of.
+  struct Split {
+    Tensor activations;
+    std::vector<unsigned> regions;
+    unsigned tile;
+  };
 
-  std::string reduceGatherVertexClass =
-      templateVertex("popnn::ReduceMaxNClassGather", input.elementType(), sort);
-
-  std::string reduceSparseVertexClass =
-      templateVertex("popnn::ReduceMaxNClassSparse", input.elementType(), sort);
-
-  const auto numWorkers = target.getNumWorkerContexts();
-  std::vector<ComputeSet> reductionCS;
-  Tensor lastValuePartials = input;
-  Tensor lastIndexPartials;
-  std::size_t lastBatchPartials = lastValuePartials.numElements() / batchSize;
-
-  std::size_t reduceIndex = 0;
-  unsigned nextTile = 0;
-  while (lastBatchPartials > 1) {
-    bool isFirstReduce = (reduceIndex == 0);
-
-    std::size_t numGatherThreads =
-        target.getNumTiles() * target.getNumWorkerContexts();
-    std::size_t numSparseThreads = target.getNumTiles();
-    std::size_t partialsFactor = 0;
-
-    const std::size_t minFactor = std::max<std::size_t>(k * 2, 32);
-    if (isFirstReduce) {
-      partialsFactor =
-          std::max(minFactor, (lastBatchPartials + numGatherThreads - 1) /
-                                  numGatherThreads);
-    } else {
+  std::vector<std::vector<TopKCandidates>> candidates(batchSize);
+  auto cs = graph.addComputeSet(layerPrefix + "/ReduceNMaxClass[0]");
+  for (std::size_t b = 0; b < batchSize; ++b) {
+    const auto row = input[b];
+    const auto tileMapping = graph.getTileMapping(row);
+    std::vector<Split> splits;
+    for (unsigned tile = 0; tile < tileMapping.size(); ++tile) {
+      const auto &intervals = tileMapping[tile];
+      if (intervals.empty()) {
+        continue;
+      }
+      const auto tileActivations = concat(row.slices(intervals));
+      const auto tileElems = tileActivations.numElements();
+      const std::size_t splitSize = std::max<std::size_t>(
+          minVertexElems, quotCeiling(tileElems, numWorkers));
+      auto interval = intervals.begin();
+      std::size_t intervalBegin = 0;
+      for (std::size_t begin = 0; begin < tileElems; begin += splitSize) {
+        const auto end = std::min(begin + splitSize, tileElems);
+        Split split{tileActivations.slice(begin, end), {}, tile};
+        // For each region, the position in the split at which it starts and
+        // the index in the row of its first element.
+        for (auto pos = begin; pos != end;) {
+          while (pos >= intervalBegin + interval->size()) {
+            intervalBegin += interval->size();
+            ++interval;
+          }
+          split.regions.push_back(pos - begin);
+          split.regions.push_back(interval->begin() + (pos - intervalBegin));
+          pos = std::min(end, intervalBegin + interval->size());
+        }
+        splits.push_back(std::move(split));
+      }
+    }
 
-      partialsFactor =
-          std::max(minFactor, (lastBatchPartials + numSparseThreads - 1) /
-                                  numSparseThreads);
+    const bool isLastReduce = splits.size() == 1;
+    std::size_t numOutputs = 0;
+    for (const auto &split : splits) {
+      numOutputs += std::min(k, split.activations.numElements());
+    }
+    const auto suffix = "[0][" + std::to_string(b) + "]";
+    auto values = graph.addVariable(
+        type, {numOutputs}, layerPrefix + "/NMaxValuePartials" + suffix);
+    auto rowIndices =
+        graph.addVariable(UNSIGNED_INT, {numOutputs},
+                          layerPrefix + "/NMaxIndexPartials" + suffix);
+    std::size_t outBegin = 0;
+    for (const auto &split : splits) {
+      const auto size = split.activations.numElements();
+      const auto numK = std::min(k, size);
+      const auto splitValues = values.slice(outBegin, outBegin + numK);
+      const auto splitIndices = rowIndices.slice(outBegin, outBegin + numK);
+      outBegin += numK;
+      const auto v = graph.addVertex(cs, reduceGatherVertexClass);
+      // A single output covers all the elements of the vertex.
+      graph.setInitialValue(v["regions"], split.regions);
+      graph.setInitialValue(v["size"], size);
+      graph.setInitialValue(v["numK"], numK);
+      graph.setInitialValue(v["divisorLog2"], poplibs_support::ceilLog2(size));
+      graph.setInitialValue(v["shouldSort"], sort && isLastReduce);
+      graph.connect(v["activations"], split.activations);
+      graph.connect(v["maxValues"], splitValues);
+      graph.connect(v["maxValuesIndices"], splitIndices);
+      graph.setTileMapping(splitValues, split.tile);
+      graph.setTileMapping(splitIndices, split.tile);
+      graph.setTileMapping(v, split.tile);
+      candidates[b].push_back({splitValues, splitIndices, split.tile});
     }
+  }
+  prog.add(Execute(cs));
 
-    const auto divisorLog2 = poplibs_support::ceilLog2(partialsFactor);
-    const auto divisor = (1u << divisorLog2);
-
-    const auto batchPartials = (lastBatchPartials + divisor - 1) / divisor;
-
-    bool isLastReduce = (batchPartials == 1);
-    std::string vertexClass =
-        isFirstReduce ? reduceGatherVertexClass : reduceSparseVertexClass;
-    reductionCS.push_back(graph.addComputeSet(
-        layerPrefix + "/ReduceNMaxClass[" + std::to_string(reduceIndex) + "]"));
-    const auto &cs = reductionCS.back();
-
-    poplar::Tensor valuePartials =
-        graph.addVariable(input.elementType(), {batchSize, batchPartials, k},
-                          layerPrefix + "/NMaxValuePartials[" +
-                              std::to_string(reduceIndex) + "]");
-    poplar::Tensor indexPartials =
-        graph.addVariable(UNSIGNED_INT, {batchSize, batchPartials, k},
-                          layerPrefix + "/NMaxIndexPartials[" +
-                              std::to_string(reduceIndex) + "]");
+  for (unsigned stage = 1;; ++stage) {
+    std::size_t numCandidates = 0;
+    for (const auto &rowCandidates : candidates) {
+      if (rowCandidates.size() > 1) {
+        numCandidates += rowCandidates.size();
+      }
+    }
+    if (numCandidates == 0) {
+      break;
+    }
+    // Merge enough candidates in each vertex to reduce at least
+    // minVertexElems elements, and so there are about as many groups as
+    // tiles.
+    const std::size_t groupSize = std::max<std::size_t>(
+        {2, quotCeiling(minVertexElems, k),
+         quotCeiling(numCandidates, numTiles)});
+    std::size_t numGroups = 0;
+    for (const auto &rowCandidates : candidates) {
+      if (rowCandidates.size() > 1) {
+        numGroups += quotCeiling(rowCandidates.size(), groupSize);
+      }
+    }
+    // Each group is merged on the tile of its first candidates unless that
+    // tile already has its share of the stage's vertices, in which case it
+    // goes to the next tile that doesn't. No tile has more than
+    // maxTileGroups vertices.
+    const auto maxTileGroups = quotCeiling(numGroups, numTiles);
+    std::vector<std::size_t> tileGroups(numTiles);
+    const auto stageStr = "[" + std::to_string(stage) + "]";
+    cs = graph.addComputeSet(layerPrefix + "/ReduceNMaxClass" + stageStr);
     for (std::size_t b = 0; b < batchSize; ++b) {
-      std::size_t batchOffset = 0;
-      std::size_t partialsIndex = 0;
-      while (batchOffset != lastBatchPartials) {
-        // If this is the last reduction, put the reduction on the tile where
-        // the final accuracy will be calculated.
-        const auto tile = isLastReduce ? numCorrectTile : nextTile;
-
-        const auto v = graph.addVertex(cs, vertexClass);
-
-        // If this is the last reduction and the user specified they wanted the
-        // output to be sorted.
-        graph.setInitialValue(v["shouldSort"], sort && isLastReduce);
-
-        if (isFirstReduce) {
-          // This first reduction uses a supervisor vertex, so try and give it
-          // a grain of splits per-worker each time.
-          const auto supervisorPartials = divisor * numWorkers;
-          const auto partialsThisSplit = std::min<size_t>(
-              lastBatchPartials - batchOffset, supervisorPartials);
-
-          const auto nOutputs = (partialsThisSplit + divisor - 1) / divisor;
-
-          auto splitValuePartials = lastValuePartials[b].slice(
-              batchOffset, batchOffset + partialsThisSplit);
-
-          // Split the partials into a series of
-          poplar::Tensor splitMaxValue =
-              valuePartials[b].slice(partialsIndex, partialsIndex + nOutputs);
-          splitMaxValue = splitMaxValue.flatten();
-
-          poplar::Tensor splitMinIndex =
-              indexPartials[b].slice(partialsIndex, partialsIndex + nOutputs);
-          splitMinIndex = splitMinIndex.flatten();
-
-          graph.setInitialValue(v["index"], batchOffset);
-          graph.connect(v["activations"], splitValuePartials);
-          graph.connect(v["maxValues"], splitMaxValue);
-          graph.connect(v["maxValuesIndices"], splitMinIndex);
-          graph.setInitialValue(v["size"], partialsThisSplit);
-          graph.setInitialValue(v["numK"], k);
-          graph.setInitialValue(v["divisorLog2"], divisorLog2);
-          graph.setTileMapping(splitMaxValue, tile);
-          graph.setTileMapping(splitMinIndex, tile);
-          partialsIndex += nOutputs;
-          batchOffset += partialsThisSplit;
-        } else {
-          const auto partialsThisSplit =
-              std::min<size_t>(lastBatchPartials - batchOffset, divisor);
-
-          // Turn the previous output into this input.
-          poplar::Tensor splitValuePartials = lastValuePartials[b].slice(
-              batchOffset, batchOffset + partialsThisSplit);
-
-          poplar::Tensor splitIndexPartials = lastIndexPartials[b].slice(
-              batchOffset, batchOffset + partialsThisSplit);
-
-          splitIndexPartials = splitIndexPartials.flatten();
-          splitValuePartials = splitValuePartials.flatten();
-          graph.connect(v["labels"], splitIndexPartials);
-          graph.connect(v["activations"], splitValuePartials);
-          graph.connect(v["maxValues"], valuePartials[b][partialsIndex]);
-          graph.connect(v["maxValuesIndices"], indexPartials[b][partialsIndex]);
-          graph.setInitialValue(v["numK"], k);
-
-          graph.setTileMapping(valuePartials[b][partialsIndex], tile);
-          graph.setTileMapping(indexPartials[b][partialsIndex], tile);
-          ++partialsIndex;
-          batchOffset += partialsThisSplit;
+      auto &rowCandidates = candidates[b];
+      if (rowCandidates.size() <= 1) {
+        continue;
+      }
+      const bool isLastReduce = rowCandidates.size() <= groupSize;
+      std::vector<TopKCandidates> nextCandidates;
+      for (std::size_t begin = 0; begin < rowCandidates.size();
+           begin += groupSize) {
+        const auto end = std::min(begin + groupSize, rowCandidates.size());
+        if (end - begin == 1) {
+          // Pass a single set of candidates on to the next stage.
+          nextCandidates.push_back(rowCandidates[begin]);
+          continue;
         }
+        std::vector<Tensor> groupValues, groupIndices;
+        for (auto i = begin; i != end; ++i) {
+          groupValues.push_back(rowCandidates[i].values);
+          groupIndices.push_back(rowCandidates[i].indices);
+        }
+        const auto groupActivations = concat(groupValues);
+        const auto numK = std::min(k, groupActivations.numElements());
+        auto tile = rowCandidates[begin].tile;
+        while (tileGroups[tile] == maxTileGroups) {
+          tile = (tile + 1) % numTiles;
+        }
+        ++tileGroups[tile];
+        const auto suffix = stageStr + "[" + std::to_string(b) + "][" +
+                            std::to_string(nextCandidates.size()) + "]";
+        auto values = graph.addVariable(
+            type, {numK}, layerPrefix + "/NMaxValuePartials" + suffix);
+        auto groupMaxIndices = graph.addVariable(
+            UNSIGNED_INT, {numK}, layerPrefix + "/NMaxIndexPartials" + suffix);
+        const auto v = graph.addVertex(cs, reduceSparseVertexClass);
+        graph.setInitialValue(v["numK"], numK);
+        graph.setInitialValue(v["shouldSort"], sort && isLastReduce);
+        graph.connect(v["activations"], groupActivations);
+        graph.connect(v["labels"], concat(groupIndices));
+        graph.connect(v["maxValues"], values);
+        graph.connect(v["maxValuesIndices"], groupMaxIndices);
+        graph.setTileMapping(values, tile);
+        graph.setTileMapping(groupMaxIndices, tile);
         graph.setTileMapping(v, tile);
-        nextTile = (nextTile + 1) % tilesPerIPU;
-        assert(batchOffset <= lastBatchPartials);
+        nextCandidates.push_back({values, groupMaxIndices, tile});
       }
+      rowCandidates = std::move(nextCandidates);
     }
-
-    lastValuePartials = valuePartials;
-    lastIndexPartials = indexPartials;
-    lastBatchPartials = batchPartials;
-    ++reduceIndex;
-  }
-
-  for (const auto &cs : reductionCS) {
     prog.add(Execute(cs));
   }
 
-  indices = lastIndexPartials;
-  return lastValuePartials;
+  // Every row has at least k elements, so its final set has k candidates.
+  std::vector<Tensor> values, rowIndices;
+  for (const auto &rowCandidates : candidates) {
+    assert(rowCandidates[0].values.numElements() == k);
+    values.push_back(rowCandidates[0].values.expand({0}));
+    rowIndices.push_back(rowCandidates[0].indices.expand({0}));
+  }
+  indices = concat(rowIndices);
+  return concat(values);
 }
 
 Tensor topK(Graph &graph, const Tensor &input, Tensor &indices, unsigned K,
@@ -679,11 +930,11 @@ Tensor topK(Graph &graph, const Tensor &input, Tensor &indices, unsigned K,
                         "dimensions which the TopK is being calculated for.");
   }
 
-  // TODO: T12906 Map the output tensor.
-  unsigned numCorrectTile = 0;
-  auto output = TopKImpl(graph, input, indices, K, sort, UNSIGNED_INT, prog,
-                         numCorrectTile, debugPrefix);
-  return output;
+  if (K == 0) {
+    throw poplibs_error("K must be greater than zero");
+  }
+
+  return TopKImpl(graph, input, indices, K, sort, prog, debugPrefix);
 }
 
 Tensor argMax(Graph &graph, const Tensor &input, Sequence &prog,
@@ -4,8 +4,11 @@
 #include <popops/Cast.hpp>
 
 #include "RnnUtil.hpp"
+#include "poplibs_support/Algorithm.hpp"
 #include "poplin/FullyConnected.hpp"
 
+#include <cmath>
+
 using namespace poplar;
 using namespace poplar::program;
 
@@ -113,6 +116,7 @@ struct LstmOpts {
   poplar::Type partialsType;
   poplar::Type accumulatorsType;
   LstmRecomputationMode recomputationMode;
+  unsigned recomputationCheckpointInterval;
   boost::optional<double> availableMemoryProportion;
 };
 
@@ -145,6 +149,7 @@ static LstmOpts parseOptions(const OptionFlags &options,
   lstmOpts.accumulatorsType =
       defaultAccType; // this will default to float in future
   lstmOpts.recomputationMode = LstmRecomputationMode::None;
+  lstmOpts.recomputationCheckpointInterval = 0;
   using poplibs::OptionHandler;
   using poplibs::OptionSpec;
   const OptionSpec lstmSpec{
@@ -159,6 +164,9 @@ static LstmOpts parseOptions(const OptionFlags &options,
       {"recomputationMode",
        OptionHandler::createWithEnum(lstmOpts.recomputationMode,
                                      recomputationModeMap)},
+      {"recomputationCheckpointInterval",
+       OptionHandler::createWithInteger(
+           lstmOpts.recomputationCheckpointInterval)},
       {"availableMemoryProportion",
        OptionHandler::createWithDouble(lstmOpts.availableMemoryProportion)},
   };
@@ -597,6 +605,9 @@ static Tensor getFwdIntermediatesToSave(const LstmState &state,
   Tensor intermediates;
   switch (options.recomputationMode) {
   case LstmRecomputationMode::None:
+  // With full recomputation these are the intermediates recomputed for each
+  // step in the backward pass rather than saved by the forward pass.
+  case LstmRecomputationMode::Full:
     intermediates = concat({internalState.forgetGate.expand({0}),
                             internalState.inputGate.expand({0}),
                             internalState.candidate.expand({0}),
@@ -610,7 +621,6 @@ static Tensor getFwdIntermediatesToSave(const LstmState &state,
                             internalState.candidate.expand({0}),
                             internalState.outputGate.expand({0})});
     break;
-  case LstmRecomputationMode::Full:
   default:
     throw poputil::poplibs_error("Unhandled recomputation type");
   }
@@ -631,20 +641,14 @@ static Tensor getSavedFwdIntermediate(const Tensor &fwdIntermediates,
                                       FwdIntermediates intermediate) {
   auto recompType = options.recomputationMode;
   int index = intermediate;
+  // With full recomputation the intermediates of each step are recomputed in
+  // the same layout as with no recomputation.
   if (intermediate >= LSTM_FWD_INTERMEDIATE_OUTPUT &&
-      (recompType == LstmRecomputationMode::CellAndTanh ||
-       recompType == LstmRecomputationMode::Full)) {
+      recompType == LstmRecomputationMode::CellAndTanh) {
     assert(index >=
            (LSTM_FWD_INTERMEDIATE_OUTPUT - LSTM_FWD_INTERMEDIATE_OUTPUT_TANH));
     index -= (LSTM_FWD_INTERMEDIATE_OUTPUT - LSTM_FWD_INTERMEDIATE_OUTPUT_TANH);
   }
-  if (intermediate >= LSTM_FWD_INTERMEDIATE_OUTPUT_TANH &&
-      recompType == LstmRecomputationMode::Full) {
-    assert(index >= (LSTM_FWD_INTERMEDIATE_OUTPUT_TANH -
-                     LSTM_FWD_INTERMEDIATE_FORGET_GATE));
-    index -=
-        (LSTM_FWD_INTERMEDIATE_OUTPUT_TANH - LSTM_FWD_INTERMEDIATE_FORGET_GATE);
-  }
   assert(index < int(fwdIntermediates.dim(0)));
   return fwdIntermediates[index];
 }
@@ -655,6 +659,8 @@ static Tensor reconstructIntermediatesFromRecomputed(
   switch (options.recomputationMode) {
   case LstmRecomputationMode::None:
     return savedIntermediates;
+  case LstmRecomputationMode::Full:
+    return recomputedIntermediates;
   case LstmRecomputationMode::CellAndTanh: {
     auto intermediates =
         concat(savedIntermediates.slice(LSTM_FWD_INTERMEDIATE_FORGET_GATE,
@@ -667,7 +673,6 @@ static Tensor reconstructIntermediatesFromRecomputed(
     }
     return intermediates;
   }
-  case LstmRecomputationMode::Full:
   default:
     throw poputil::poplibs_error("Unhandled recomputation type");
   }
@@ -675,6 +680,34 @@ static Tensor reconstructIntermediatesFromRecomputed(
   POPLIB_UNREACHABLE();
 }
 
+// The number of steps between the states saved by the forward pass with full
+// recomputation. The backward pass recomputes the intermediates of all the
+// steps between two saved states at once.
+static unsigned getCheckpointInterval(const LstmParams &params,
+                                      const LstmOpts &options) {
+  const unsigned seqSize = params.timeSteps;
+  if (options.recomputationCheckpointInterval != 0) {
+    return std::min(options.recomputationCheckpointInterval, seqSize);
+  }
+  // Saving a state every sqrt(seqSize) steps about minimises the memory for
+  // the saved states plus the recomputed intermediates.
+  return std::max(1u, static_cast<unsigned>(std::ceil(std::sqrt(seqSize))));
+}
+
+// Input weighted by the input weights is used in place of the input when the
+// layer doesn't do the input weight calculation, but it isn't passed in.
+static Tensor createDummyWeightedIn(Graph &graph, const LstmParams &params) {
+  auto weightedIn = graph.addVariable(
+      params.dataType,
+      {params.timeSteps, BASIC_LSTM_CELL_NUM_UNITS, params.batchSize,
+       params.layerSizes[1]},
+      "dummyWeightedIn");
+  for (unsigned s = 0; s < params.timeSteps; ++s) {
+    mapTensorLinearly(graph, weightedIn[s]);
+  }
+  return weightedIn;
+}
+
 Tensor getFwdInput(Graph &graph, const Tensor &weightedIn,
                    const Tensor prevLayerActs, const Tensor seqIdx,
                    Sequence &loop, const std::string &debugPrefix,
@@ -698,13 +731,7 @@ lstmFwd(Graph &graph, const LstmParams &params, const LstmState &fwdStateInit,
 
   Tensor weightedIn;
   if (!params.doInputWeightCalc) {
-    weightedIn = graph.addVariable(params.dataType,
-                                   {params.timeSteps, BASIC_LSTM_CELL_NUM_UNITS,
-                                    params.batchSize, params.layerSizes[1]},
-                                   "dummyWeightedIn");
-    for (unsigned s = 0; s < params.timeSteps; ++s) {
-      mapTensorLinearly(graph, weightedIn[s]);
-    }
+    weightedIn = createDummyWeightedIn(graph, params);
   } else if (opt.preCalcWeights) {
     weightedIn = calcSequenceWeightedInputs(
         graph, prevLayerActs, weights.inputWeights, fwdProg, opt,
@@ -738,7 +765,10 @@ lstmFwd(Graph &graph, const LstmParams &params, const LstmState &fwdStateInit,
                                 loop, debugPrefix, useWeightedIn);
   const Tensor *inputWeightsPtr =
       useWeightedIn ? nullptr : &weights.inputWeights;
-  if (intermediatesSeq) {
+  const bool saveCheckpoints =
+      intermediatesSeq &&
+      opt.recomputationMode == LstmRecomputationMode::Full;
+  if (intermediatesSeq && !saveCheckpoints) {
     LstmState newState;
     LstmInternalState internalState;
     std::tie(newState, internalState) =
@@ -780,7 +810,49 @@ lstmFwd(Graph &graph, const LstmParams &params, const LstmState &fwdStateInit,
                           {0}, {1}, loop, debugPrefix + "/updateOutputSeq");
   }
   addInPlace(graph, seqIdx, one, loop, debugPrefix + "/seqIdxIncr");
-  fwdProg.add(Repeat(seqSize, loop));
+  if (saveCheckpoints) {
+    // Only save the state at the start of every segment of checkpointInterval
+    // steps. The backward pass recomputes the intermediates of a segment from
+    // the state saved at its start.
+    const auto checkpointInterval = getCheckpointInterval(params, opt);
+    const auto numCheckpoints = ceildiv(seqSize, checkpointInterval);
+    const auto numStates = state.getAsTensor().dim(0);
+    *intermediatesSeq =
+        createOutputTensor(graph, params, numCheckpoints * numStates,
+                           debugPrefix + "/fwdCheckpoints")
+            .reshapePartial(0, 1, {numCheckpoints, numStates});
+    auto checkpointRearranged = createOutputTensor(
+        graph, params, numStates, debugPrefix + "/fwdCheckpointRearranged");
+    auto checkpointIdx =
+        graph.addVariable(UNSIGNED_INT, {1}, debugPrefix + "/checkpointIdx");
+    graph.setTileMapping(checkpointIdx, 0);
+    popops::zero(graph, checkpointIdx, fwdProg,
+                 debugPrefix + "/initCheckpointIdx");
+    fwdProg.add(WriteUndef(*intermediatesSeq));
+
+    auto saveCheckpoint = Sequence();
+    saveCheckpoint.add(Copy(state.getAsTensor(), checkpointRearranged));
+    popops::dynamicUpdate(graph, *intermediatesSeq,
+                          checkpointRearranged.expand({0}), checkpointIdx, {0},
+                          {1}, saveCheckpoint,
+                          debugPrefix + "/lstmSaveCheckpoint");
+    addInPlace(graph, checkpointIdx, one, saveCheckpoint,
+               debugPrefix + "/checkpointIdxIncr");
+
+    const auto numFullSegments = seqSize / checkpointInterval;
+    if (numFullSegments) {
+      fwdProg.add(Repeat(numFullSegments,
+                         Sequence(saveCheckpoint,
+                                  Repeat(checkpointInterval, loop))));
+    }
+    const auto lastSegmentSize = seqSize % checkpointInterval;
+    if (lastSegmentSize) {
+      fwdProg.add(saveCheckpoint);
+      fwdProg.add(Repeat(lastSegmentSize, loop));
+    }
+  } else {
+    fwdProg.add(Repeat(seqSize, loop));
+  }
   return {params.outputFullSequence ? outputSeq : state.output,
           state.cellState};
 }
@@ -1127,12 +1199,120 @@ static Tensor recomputeCellAndTanhImpl(Graph &graph, const LstmParams &params,
   return recomputedIntermediatesSeq;
 }
 
+// Recompute the intermediates of the forward pass from the states saved at the
+// start of every segment of steps. The intermediates of a segment are
+// recomputed into a buffer which holds one segment when the step at its end is
+// sliced, so the last segment is recomputed by recomputeProg and the others by
+// sliceProg. Returns the intermediates of step sliceIdx, sliced by sliceProg.
+static Tensor recomputeFullImpl(Graph &graph, const LstmParams &params,
+                                const LstmOpts &options,
+                                const LstmState &fwdStateInit,
+                                const Tensor &fwdCheckpointsSeq,
+                                const LstmWeights &weights,
+                                const Tensor &fwdInputSeq,
+                                program::Sequence &recomputeProg,
+                                const std::string &recomputePrefix,
+                                program::Sequence &sliceProg,
+                                const Tensor &sliceIdx,
+                                const std::string &slicePrefix,
+                                matmul::PlanningCache *cache) {
+  using namespace popops::expr;
+  const unsigned seqSize = params.timeSteps;
+  const auto checkpointInterval = getCheckpointInterval(params, options);
+  const auto numCheckpoints = ceildiv(seqSize, checkpointInterval);
+  const auto lastSegmentSize =
+      seqSize - (numCheckpoints - 1) * checkpointInterval;
+
+  // Restore the state saved at the start of the segment of step sliceIdx.
+  auto restoreCheckpoint = Sequence();
+  auto checkpointIdx =
+      popops::map(graph, _1 / checkpointInterval, {sliceIdx},
+                  restoreCheckpoint, recomputePrefix + "/checkpointIdx");
+  auto stepIdx =
+      popops::map(graph, _1 * checkpointInterval, {checkpointIdx},
+                  restoreCheckpoint, recomputePrefix + "/initStepIdx");
+  auto checkpoint =
+      dynamicSlice(graph, fwdCheckpointsSeq, checkpointIdx, {0}, {1},
+                   restoreCheckpoint, recomputePrefix + "/getCheckpoint")
+          .squeeze({0});
+  LstmState state = {
+      graph.clone(fwdStateInit.output, recomputePrefix + "/outputState"),
+      graph.clone(fwdStateInit.cellState, recomputePrefix + "/cellState")};
+  restoreCheckpoint.add(Copy(checkpoint, state.getAsTensor()));
+
+  // Recompute one step of the segment.
+  auto step = Sequence();
+  Tensor weightedIn;
+  if (!params.doInputWeightCalc) {
+    weightedIn = createDummyWeightedIn(graph, params);
+  }
+  // The input is sliced in place rather than copied so that full
+  // recomputation doesn't need memory for another copy of it.
+  Tensor fwdInput =
+      getFwdInput(graph, weightedIn, fwdInputSeq, stepIdx, step,
+                  recomputePrefix, !params.doInputWeightCalc);
+  const Tensor *inputWeightsPtr =
+      params.doInputWeightCalc ? &weights.inputWeights : nullptr;
+  LstmState newState;
+  LstmInternalState internalState;
+  std::tie(newState, internalState) = basicLstmCellForwardPass(
+      graph, fwdInput, weights.biases, state, inputWeightsPtr,
+      weights.outputWeights, step, options, false, recomputePrefix, cache);
+  auto intermediates = getFwdIntermediatesToSave(
+      state, newState, internalState, options, params);
+  const auto numIntermediates = intermediates.dim(0);
+  auto segmentIntermediatesSeq =
+      createOutputTensor(graph, params, checkpointInterval * numIntermediates,
+                         recomputePrefix + "/segmentIntermediates")
+          .reshapePartial(0, 1, {checkpointInterval, numIntermediates});
+  auto intermediatesRearranged = createOutputTensor(
+      graph, params, numIntermediates,
+      recomputePrefix + "/recomputedIntermediatesRearranged");
+  step.add(Copy(intermediates, intermediatesRearranged));
+  auto segmentStepIdx =
+      popops::map(graph, _1 % checkpointInterval, {stepIdx}, step,
+                  recomputePrefix + "/segmentStepIdx");
+  dynamicUpdate(graph, segmentIntermediatesSeq,
+                intermediatesRearranged.expand({0}), segmentStepIdx, {0}, {1},
+                step, recomputePrefix + "/storeRecomputed");
+  auto stateTensor = state.getAsTensor();
+  auto newStateTensor = newState.getAsTensor();
+  graph.setTileMapping(stateTensor, graph.getTileMapping(newStateTensor));
+  step.add(Copy(newStateTensor, stateTensor));
+  auto one = graph.addConstant(UNSIGNED_INT, {1}, 1, recomputePrefix + "/one");
+  graph.setTileMapping(one, 0);
+  addInPlace(graph, stepIdx, one, step, recomputePrefix + "/stepIdxIncr");
+
+  const auto recomputeSegment = [&](unsigned numSteps) {
+    return Sequence(restoreCheckpoint, Repeat(numSteps, step));
+  };
+  recomputeProg.add(WriteUndef(segmentIntermediatesSeq));
+  if (lastSegmentSize != checkpointInterval) {
+    recomputeProg.add(recomputeSegment(lastSegmentSize));
+  }
+  // Every other segment is recomputed when the backward pass reaches the
+  // step at its end.
+  auto isSegmentEnd = popops::map(
+      graph, _1 % checkpointInterval == checkpointInterval - 1,
+      {sliceIdx.reshape({})}, sliceProg, slicePrefix + "/isSegmentEnd");
+  sliceProg.add(If(isSegmentEnd, recomputeSegment(checkpointInterval),
+                   Sequence()));
+  auto sliceSegmentIdx =
+      popops::map(graph, _1 % checkpointInterval, {sliceIdx}, sliceProg,
+                  slicePrefix + "/segmentStepIdx");
+  return dynamicSlice(graph, segmentIntermediatesSeq, sliceSegmentIdx, {0}, {1},
+                      sliceProg, slicePrefix)
+      .squeeze({0});
+}
+
 static Tensor recomputeAndGetFwdIntermediates(
     Graph &graph, const LstmState &fwdStateInit,
-    const Tensor &fwdIntermediatesSeq, const LstmParams &params,
+    const Tensor &fwdIntermediatesSeq, const LstmWeights &weights,
+    const Tensor &fwdInputSeq, const LstmParams &params,
     const LstmOpts &options, program::Sequence &recomputeProg,
     const std::string &recomputePrefix, program::Sequence &sliceProg,
-    const Tensor &sliceIdx, const std::string &slicePrefix) {
+    const Tensor &sliceIdx, const std::string &slicePrefix,
+    matmul::PlanningCache *cache) {
   Tensor savedSlice;
   Tensor recomputedSlice;
   switch (options.recomputationMode) {
@@ -1156,9 +1336,13 @@ static Tensor recomputeAndGetFwdIntermediates(
                           .squeeze({0});
     break;
   }
-  case LstmRecomputationMode::Full:
-    // TODO: T12911 Implement this case.
-    // fallthrough
+  case LstmRecomputationMode::Full: {
+    recomputedSlice = recomputeFullImpl(
+        graph, params, options, fwdStateInit, fwdIntermediatesSeq, weights,
+        fwdInputSeq, recomputeProg, recomputePrefix, sliceProg, sliceIdx,
+        slicePrefix, cache);
+    break;
+  }
   default:
     throw poplibs_error("Unhandled recomputation type");
   }
@@ -1222,9 +1406,9 @@ lstmBwdImpl(Graph &graph, const LstmParams &params, program::Sequence &prog,
   auto sliceOutput = Sequence();
 
   Tensor fwdIntermediates = recomputeAndGetFwdIntermediates(
-      graph, fwdStateInit, fwdIntermediatesSeq, params, options, prog,
-      debugPrefix + "/recomputeFwdIntermediates", sliceIntermediates, seqIdx,
-      debugPrefix + "/getFwdIntermediates");
+      graph, fwdStateInit, fwdIntermediatesSeq, weights, fwdInputSeq, params,
+      options, prog, debugPrefix + "/recomputeFwdIntermediates",
+      sliceIntermediates, seqIdx, debugPrefix + "/getFwdIntermediates", cache);
 
   Tensor prevStepOut;
   if (weightsGrad) {
@@ -1381,6 +1565,13 @@ lstmWUImpl(Graph &graph, const LstmParams &params, program::Sequence &prog,
            const Tensor &input, const Tensor &output,
            const std::string &debugPrefix, const LstmOpts &options,
            poplin::matmul::PlanningCache *planningCache) {
+  if (options.recomputationMode == LstmRecomputationMode::Full &&
+      !params.outputFullSequence) {
+    throw poplibs_error("The weight update pass can't be done separately from "
+                        "the backward pass with full recomputation unless "
+                        "params.outputFullSequence is set");
+  }
+
   LstmWeights weightGrads = createWeightAccumulators(
       graph, weights, bwdIntermediatesSeq[0], options, debugPrefix);
   zeroWeightAccumulators(graph, prog, weightGrads, options, debugPrefix);
@@ -1402,9 +1593,6 @@ lstmWUImpl(Graph &graph, const LstmParams &params, program::Sequence &prog,
                                debugPrefix + "/getPrevStepOut")
                       .squeeze({0});
   } else {
-    // TODO: T12908 If for full recomputation we also want to recompute the
-    // output, we must account for that here as this information will not be
-    // part of the intermediates.
     auto prevFwdIntermediates =
         dynamicSlice(graph, fwdIntermediatesSeq, seqIdx, {0}, {1}, sliceOutput,
                      debugPrefix + "/getFwdIntermediates")
@@ -1483,7 +1671,13 @@ LstmState lstmBwdWithWU(
                         (inputGrad ? "true" : "false"));
   }
 
-  bool interleaveWU = interleavedWUIsBeneficial(params);
+  // With full recomputation the outputs of the steps aren't saved by the
+  // forward pass unless they are part of its output, so they are only
+  // available to the weight update during the backward pass.
+  bool interleaveWU = interleavedWUIsBeneficial(params) ||
+                      (options.recomputationMode ==
+                           LstmRecomputationMode::Full &&
+                       !params.outputFullSequence);
   Tensor bwdIntermediates;
 
   // Perform the backward pass. If interleaving the weight update with the
@@ -1,6 +1,7 @@
 // Copyright (c) 2016 Graphcore Ltd. All rights reserved.
 #include "popnn/NonLinearity.hpp"
 #include "NonLinearityInternal.hpp"
+#include "poplibs_support/Algorithm.hpp"
 #include "poplibs_support/logging.hpp"
 #include "poplin/MatMul.hpp"
 #include "popnn/NonLinearityDef.hpp"
@@ -14,13 +15,16 @@
 #include "poputil/Util.hpp"
 #include "poputil/VertexTemplates.hpp"
 #include "poputil/exceptions.hpp"
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
 
 using namespace poplar;
 using namespace poplar::program;
 using namespace popops;
 using namespace poputil;
+using poplibs_support::ceildiv;
 
 namespace logging = poplibs_support::logging;
 
@@ -31,20 +35,14 @@ float getNonLinearityScaling(popnn::NonLinearityType nonLinearityType) {
              : 1.0f;
 }
 
-// computes softmax along the innermost dimension
+// computes softmax along the innermost dimension with a separate pass over
+// the tensor for each operation
 // This is not an optimal implementation in terms of precision and order of
 // operations
-Tensor softmaxImpl(Graph &graph, Tensor t, bool stableAlgo, bool inPlace,
-                   bool scaled, Sequence &prog,
-                   const std::string &debugStr = "") {
-  const auto fnStr = debugStr + "/SoftMax";
+Tensor softmaxMultiPass(Graph &graph, Tensor t, bool stableAlgo, bool inPlace,
+                        bool scaled, Sequence &prog,
+                        const std::string &fnStr) {
   const auto dType = t.elementType();
-  logging::info("softmax t={}, name={}", t.shape(), fnStr);
-  if (t.rank() < 1) {
-    throw poplibs_error("input tensor to softmax non-linearity must have "
-                        "at least 1 dimension");
-  }
-
   const bool expandDimension = t.rank() == 1;
   if (expandDimension) {
     t = t.expand({0});
@@ -112,6 +110,265 @@ Tensor softmaxImpl(Graph &graph, Tensor t, bool stableAlgo, bool inPlace,
   return expandDimension ? tRet.squeeze({0}) : tRet;
 }
 
+// The tile each row of a 2D tensor is mapped to, or the number of tiles if
+// the row is split between tiles.
+std::vector<unsigned> getRowTiles(const Graph &graph, const Tensor &t) {
+  const auto numTiles = graph.getTarget().getNumTiles();
+  const auto rowSize = t.dim(1);
+  std::vector<unsigned> rowTiles(t.dim(0), numTiles);
+  const auto mapping = graph.getTileMapping(t);
+  for (unsigned tile = 0; tile != numTiles; ++tile) {
+    auto intervals = mapping[tile];
+    std::sort(intervals.begin(), intervals.end(),
+              [](const Interval &a, const Interval &b) {
+                return a.begin() < b.begin();
+              });
+    for (auto it = intervals.begin(); it != intervals.end();) {
+      // Merge adjacent intervals so that rows split between them are found.
+      auto begin = it->begin();
+      auto end = it->end();
+      for (++it; it != intervals.end() && it->begin() == end; ++it) {
+        end = it->end();
+      }
+      for (auto row = ceildiv(begin, rowSize); row < end / rowSize; ++row) {
+        rowTiles[row] = tile;
+      }
+    }
+  }
+  return rowTiles;
+}
+
+// computes softmax along the rows of a 2D tensor by splitting them into
+// segments between the workers of the tiles they are mapped to. The vertices
+// added to cs find the maximum of each segment and the sum of its
+// exponentials relative to it. These partials are combined for each row and
+// a second compute set normalises the segments. out has the same tile mapping
+// as in and is the same tensor if inPlace is set.
+void softmaxSegments(Graph &graph, const Tensor &in, const Tensor &out,
+                     bool stableAlgo, bool inPlace, bool scaled,
+                     const ComputeSet &cs, Sequence &prog,
+                     const std::string &fnStr) {
+  const auto &target = graph.getTarget();
+  const auto dType = in.elementType();
+  const auto numRows = in.dim(0);
+  const auto rowSize = in.dim(1);
+  const auto inFlat = in.flatten();
+  const auto outFlat = out.flatten();
+  const auto mapping = graph.getTileMapping(in);
+
+  // Find the segments of the rows computed by each vertex.
+  struct VertexSegments {
+    unsigned tile;
+    std::vector<popnn::RowSegment> segments;
+  };
+  std::vector<VertexSegments> vertices;
+  std::vector<popnn::RowSegment> segments;
+  for (unsigned tile = 0; tile != mapping.size(); ++tile) {
+    const auto regions =
+        graph.getSortedContiguousRegions(inFlat, mapping[tile]);
+    for (auto &s : popnn::getWorkerRowSegments(target, regions, rowSize)) {
+      segments.insert(segments.end(), s.begin(), s.end());
+      vertices.push_back({tile, std::move(s)});
+    }
+  }
+  const auto numSegments = segments.size();
+  logging::debug("softmax: {} rows split into {} segments on {} vertices, "
+                 "name={}",
+                 numRows, numSegments, vertices.size(), fnStr);
+
+  // The partial statistics and row statistics of each segment live on the
+  // tile of the vertex which uses them.
+  auto segStats =
+      graph.addVariable(FLOAT, {numSegments, 2}, fnStr + "/SegmentStats");
+  auto segRowStats =
+      graph.addVariable(FLOAT, {numSegments, 2}, fnStr + "/SegmentRowStats");
+  auto normaliseCS = graph.addComputeSet(fnStr + "/Normalise");
+  const auto statsVertexClass =
+      templateVertex("popnn::SoftMaxStats", dType, stableAlgo);
+  const auto normaliseVertexClass = templateVertex(
+      inPlace ? "popnn::SoftMaxNormaliseInPlace" : "popnn::SoftMaxNormalise",
+      dType);
+  std::size_t first = 0;
+  for (const auto &v : vertices) {
+    const auto n = v.segments.size();
+    std::vector<Tensor> vIn, vOut;
+    for (const auto &s : v.segments) {
+      vIn.push_back(inFlat.slice(s.begin, s.end));
+      vOut.push_back(outFlat.slice(s.begin, s.end));
+    }
+    const auto vStats = segStats.slice(first, first + n).flatten();
+    const auto vRowStats = segRowStats.slice(first, first + n).flatten();
+    graph.setTileMapping(vStats, v.tile);
+    graph.setTileMapping(vRowStats, v.tile);
+
+    auto statsV =
+        graph.addVertex(cs, statsVertexClass, {{"in", vIn}, {"stats", vStats}});
+    graph.setTileMapping(statsV, v.tile);
+    auto normaliseV = graph.addVertex(normaliseCS, normaliseVertexClass,
+                                      {{"rowStats", vRowStats}});
+    if (inPlace) {
+      graph.connect(normaliseV["data"], vIn);
+    } else {
+      graph.connect(normaliseV["in"], vIn);
+      graph.connect(normaliseV["out"], vOut);
+    }
+    graph.setTileMapping(normaliseV, v.tile);
+    first += n;
+  }
+  prog.add(Execute(cs));
+
+  // Arrange the partials as [numRows][maxSegments], padding rows with fewer
+  // segments with partials which don't change the results.
+  std::vector<std::vector<unsigned>> rowSegments(numRows);
+  for (unsigned s = 0; s != numSegments; ++s) {
+    rowSegments[segments[s].row].push_back(s);
+  }
+  std::size_t maxSegments = 0;
+  for (const auto &r : rowSegments) {
+    maxSegments = std::max(maxSegments, r.size());
+  }
+  auto negInf =
+      graph.addConstant(FLOAT, {1, 1}, -std::numeric_limits<float>::infinity(),
+                        fnStr + "/NegInf");
+  auto zero = graph.addConstant(FLOAT, {1, 1}, 0.0f, fnStr + "/Zero");
+  graph.setTileMapping(negInf, 0);
+  graph.setTileMapping(zero, 0);
+  std::vector<Tensor> padded;
+  for (const auto &r : rowSegments) {
+    for (const auto s : r) {
+      padded.push_back(segStats.slice(s, s + 1));
+    }
+    for (auto i = r.size(); i != maxSegments; ++i) {
+      padded.push_back(concat(negInf, zero, 1));
+    }
+  }
+  const auto partials = concat(padded).reshape({numRows, maxSegments, 2});
+  const auto segMax = partials.slice(0, 1, 2).squeeze({2});
+  const auto segSum = partials.slice(1, 2, 2).squeeze({2});
+
+  using namespace popops::expr;
+  const auto rowMax =
+      popops::reduce(graph, segMax, FLOAT, {1}, popops::Operation::MAX, prog,
+                     fnStr + "/RowMax");
+  const auto segRowMax = rowMax.expand({1}).broadcast(maxSegments, 1);
+  // Segments of only -infinity, including the padding, have a sum of 0 and
+  // are excluded so a maximum of -infinity doesn't give NaN.
+  const auto rescaledSum = popops::map(
+      graph, Select(_1 * Exp(_2 - _3), Const(0.0f), _1 != Const(0.0f)),
+      {segSum, segMax, segRowMax}, prog, fnStr + "/RescaleSums");
+  const auto rowSum =
+      popops::reduce(graph, rescaledSum, FLOAT, {1}, popops::Operation::ADD,
+                     prog, fnStr + "/RowSum");
+  const auto factor = popops::map(
+      graph, Const(scaled ? SOFTMAX_SCALING : 1.0f) / _1, {rowSum}, prog,
+      fnStr + "/Factor");
+  const auto rowStats = concat(rowMax.expand({1}), factor.expand({1}), 1);
+  std::vector<Tensor> rowStatsPerSegment;
+  for (const auto &s : segments) {
+    rowStatsPerSegment.push_back(rowStats.slice(s.row, s.row + 1));
+  }
+  prog.add(Copy(concat(rowStatsPerSegment), segRowStats));
+  prog.add(Execute(normaliseCS));
+}
+
+// computes softmax along the innermost dimension
+// Each row which is in a single contiguous region of a tile with at least as
+// many such rows as workers is computed by a vertex on that tile which reads
+// the row once to find its maximum and the sum of its exponentials and once
+// more to normalise it. Any other rows, such as long rows or rows split
+// between tiles, are split into segments between the workers of their tiles
+// whose partial maxima and sums are combined for each row before the
+// segments are normalised.
+Tensor softmaxImpl(Graph &graph, Tensor t, bool stableAlgo, bool inPlace,
+                   bool scaled, Sequence &prog,
+                   const std::string &debugStr = "") {
+  const auto fnStr = debugStr + "/SoftMax";
+  const auto dType = t.elementType();
+  logging::info("softmax t={}, name={}", t.shape(), fnStr);
+  if (t.rank() < 1) {
+    throw poplibs_error("input tensor to softmax non-linearity must have "
+                        "at least 1 dimension");
+  }
+  if (t.numElements() == 0 || (dType != FLOAT && dType != HALF)) {
+    return softmaxMultiPass(graph, t, stableAlgo, inPlace, scaled, prog,
+                            fnStr);
+  }
+
+  const auto rowSize = t.dim(t.rank() - 1);
+  const auto t2D = t.reshape({t.numElements() / rowSize, rowSize});
+  const auto numRows = t2D.dim(0);
+  const auto numTiles = graph.getTarget().getNumTiles();
+  const auto numWorkers = graph.getTarget().getNumWorkerContexts();
+  const auto inRowTiles = getRowTiles(graph, t2D);
+  std::vector<std::size_t> tileNumRows(numTiles + 1);
+  for (std::size_t row = 0; row != numRows; ++row) {
+    if (t2D[row].isContiguous()) {
+      ++tileNumRows[inRowTiles[row]];
+    }
+  }
+  const auto canFuse = [&](std::size_t row) {
+    return inRowTiles[row] != numTiles && t2D[row].isContiguous() &&
+           tileNumRows[inRowTiles[row]] >= numWorkers;
+  };
+
+  const auto out2D = inPlace ? t2D : graph.clone(t2D, fnStr + "/out");
+  const auto outRowTiles = inPlace ? inRowTiles : getRowTiles(graph, out2D);
+  std::vector<std::vector<std::size_t>> tileRows(numTiles);
+  std::vector<Interval> otherRows;
+  std::size_t numOtherRows = 0;
+  for (std::size_t row = 0; row != numRows; ++row) {
+    if (canFuse(row) && outRowTiles[row] == inRowTiles[row] &&
+        (inPlace || out2D[row].isContiguous())) {
+      tileRows[inRowTiles[row]].push_back(row);
+    } else {
+      if (!otherRows.empty() && otherRows.back().end() == row) {
+        otherRows.back() = Interval(otherRows.back().begin(), row + 1);
+      } else {
+        otherRows.emplace_back(row, row + 1);
+      }
+      ++numOtherRows;
+    }
+  }
+
+  const auto vertexName =
+      templateVertex(inPlace ? "popnn::SoftMax2DInPlace" : "popnn::SoftMax2D",
+                     dType, stableAlgo);
+  auto cs = graph.addComputeSet(fnStr + "/Fused");
+  for (unsigned tile = 0; tile != numTiles; ++tile) {
+    const auto &rows = tileRows[tile];
+    const auto rowsPerWorker = ceildiv(rows.size(), numWorkers);
+    for (std::size_t begin = 0; begin < rows.size(); begin += rowsPerWorker) {
+      const auto end = std::min(begin + rowsPerWorker, rows.size());
+      std::vector<Tensor> in, out;
+      for (auto i = begin; i != end; ++i) {
+        in.push_back(t2D[rows[i]]);
+        out.push_back(out2D[rows[i]]);
+      }
+      auto v = graph.addVertex(cs, vertexName);
+      if (inPlace) {
+        graph.connect(v["data"], in);
+      } else {
+        graph.connect(v["in"], in);
+        graph.connect(v["out"], out);
+      }
+      graph.setInitialValue(v["scale"], scaled ? SOFTMAX_SCALING : 1.0f);
+      graph.setTileMapping(v, tile);
+    }
+  }
+
+  if (otherRows.empty()) {
+    prog.add(Execute(cs));
+  } else {
+    logging::debug("softmax: {} of {} rows are split between workers, name={}",
+                   numOtherRows, numRows, fnStr);
+    const auto otherIn = concat(t2D.slices(otherRows));
+    const auto otherOut = inPlace ? otherIn : concat(out2D.slices(otherRows));
+    softmaxSegments(graph, otherIn, otherOut, stableAlgo, inPlace, scaled, cs,
+                    prog, fnStr);
+  }
+  return out2D.reshape(t.shape());
+}
+
 // computes the gradient of softmax along the innermost dimension
 Tensor softmaxInputGradientImpl(Graph &graph, const Tensor &out,
                                 const Tensor &outGradient, Sequence &prog,
@@ -150,6 +407,43 @@ Tensor softmaxInputGradientImpl(Graph &graph, const Tensor &out,
 
 namespace popnn {
 
+std::vector<std::vector<RowSegment>>
+getWorkerRowSegments(const Target &target,
+                     const std::vector<std::vector<Interval>> &regions,
+                     std::size_t rowSize) {
+  std::size_t tileElements = 0;
+  for (const auto &r : regions) {
+    for (const auto &i : r) {
+      tileElements += i.size();
+    }
+  }
+  if (tileElements == 0) {
+    return {};
+  }
+  const auto numWorkers = target.getNumWorkerContexts();
+  const auto workerElements = ceildiv(tileElements, numWorkers);
+  std::vector<std::vector<RowSegment>> workerSegments(1);
+  std::size_t elements = 0;
+  for (const auto &r : regions) {
+    for (const auto &i : r) {
+      for (auto begin = i.begin(); begin != i.end();) {
+        const auto row = begin / rowSize;
+        const auto end =
+            std::min({i.end(), (row + 1) * rowSize, begin + workerElements});
+        if (elements >= workerElements) {
+          workerSegments.emplace_back();
+          elements = 0;
+        }
+        workerSegments.back().push_back(
+            {static_cast<unsigned>(row), begin, end});
+        elements += end - begin;
+        begin = end;
+      }
+    }
+  }
+  return workerSegments;
+}
+
 bool isSoftMax(NonLinearityType nl) {
   return (nl == NonLinearityType::SOFTMAX ||
           nl == NonLinearityType::SOFTMAX_STABLE ||
@@ -2,6 +2,10 @@
 #ifndef popnn_NonLinearityInternal_hpp
 #define popnn_NonLinearityInternal_hpp
 
+#include <poplar/Interval.hpp>
+#include <poplar/Target.hpp>
+#include <vector>
+
 // One hot / softmax scaling to improve accuracy
 // Choosing scaling of (62000) means that accuracy is
 // greatly improved compared to the default scaling of 1.0.
@@ -10,4 +14,25 @@
 // could result in the number overflowing.
 #define SOFTMAX_SCALING (62000.0F)
 
+namespace popnn {
+
+// A part of a row of a 2D tensor which is contiguous on a tile. begin and end
+// are indices into the flattened tensor.
+struct RowSegment {
+  unsigned row;
+  std::size_t begin;
+  std::size_t end;
+};
+
+// Split the regions of a flattened 2D tensor mapped to a tile into segments
+// which don't cross rows and group them into one vector per worker. Long
+// segments are split so the elements on the tile are balanced between the
+// workers.
+std::vector<std::vector<RowSegment>>
+getWorkerRowSegments(const poplar::Target &target,
+                     const std::vector<std::vector<poplar::Interval>> &regions,
+                     std::size_t rowSize);
+
+} // end namespace popnn
+
 #endif // popnn_NonLinearityInternal_hpp
@@ -12,7 +12,11 @@ namespace popnn {
 /*
   See the description of ReduceMaxNClassSparse for the general algorithm for
   calculating the top |numK| from the given |activations|. This version is only
-  different in that it works on multiple batches of input at a time.
+  different in that it works on multiple batches of input at a time, each of
+  which must have at least |numK| elements, and that the |activations| may be
+  made of several regions of the row. |regions| holds the position in
+  |activations| at which each region starts, which must be 0 for the first
+  one, followed by the index in the row of its first element.
 */
 template <typename FPType, bool Sort = false>
 class ReduceMaxNClassGather : public Vertex {
@@ -20,7 +24,7 @@ public:
   ReduceMaxNClassGather();
 
   Input<Vector<FPType, ONE_PTR>> activations;
-  const unsigned index;
+  Vector<unsigned> regions;
 
   Output<Vector<FPType, ONE_PTR>> maxValues;
 
@@ -73,35 +77,23 @@ public:
         }
       }
 
-      // If this gather is uneven I.E the NumOuput*topK is greater than the size
-      // we have to adjust the numK so we don't sort the bit at the end as well.
-      // How much remains in the last iteration.
-      unsigned remainder = end - offset;
-
-      // If there is more numK than remaining elements
-      unsigned adjustedNumK = numK > remainder ? remainder : numK;
-
-      // If the remainder is smaller than numK is larger than topK we have to
-      // fill the remaining numK slots with the smallest possible value for that
-      // type.
-      if (adjustedNumK != numK) {
-        for (int k = adjustedNumK; k < numK; ++k) {
-          currentPartialBucketData[k] = std::numeric_limits<FPType>::lowest();
-          currentPartialBucket[k] = std::numeric_limits<unsigned>::max();
-        }
-      }
       // Sort if template parameter Sort is true and the runtime flag is set. If
       // the runtime flag will never be set (I.E compile time Sort=false) this
       // should be trivially eliminated by DCE.
       if (Sort && shouldSort) {
-        heapView.Sort(adjustedNumK);
+        heapView.Sort(numK);
       }
 
-      for (int k = 0; k < adjustedNumK; ++k) {
-        currentPartialBucketData[k] = activations[currentPartialBucket[k]];
+      for (int k = 0; k < numK; ++k) {
+        const auto pos = currentPartialBucket[k];
+        currentPartialBucketData[k] = activations[pos];
 
-        // Add the index base to get the actual index.
-        currentPartialBucket[k] += index;
+        // Find the region the element is in to get the actual index.
+        unsigned r = 2;
+        while (r != regions.size() && regions[r] <= pos) {
+          r += 2;
+        }
+        currentPartialBucket[k] = regions[r - 1] + (pos - regions[r - 2]);
       }
     }
     return true;
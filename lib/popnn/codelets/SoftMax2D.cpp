@@ -0,0 +1,166 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#include "poplibs_support/ExternalCodelet.hpp"
+#include <cmath>
+#include <limits>
+#include <poplar/HalfFloat.hpp>
+#include <poplar/Vertex.hpp>
+
+using namespace poplar;
+static constexpr auto ONE_PTR = poplar::VectorLayout::ONE_PTR;
+
+namespace popnn {
+
+// Find the maximum of a row and the sum of the exponentials of the row
+// relative to it in one pass, keeping a running maximum and rescaling the sum
+// whenever it increases. Elements of -infinity add nothing to the sum.
+// Without the stable algorithm the maximum isn't tracked and is 0.
+template <bool stable, typename InRow>
+static void getRowStats(const InRow &in, unsigned size, float &max,
+                        float &sum) {
+  max = stable ? -std::numeric_limits<float>::infinity() : 0.0f;
+  sum = 0.0f;
+  for (unsigned i = 0; i != size; ++i) {
+    const float x = float(in[i]);
+    if (stable && x > max) {
+      sum = sum * std::exp(max - x) + 1.0f;
+      max = x;
+    } else if (x != -std::numeric_limits<float>::infinity()) {
+      sum += std::exp(x - max);
+    }
+  }
+}
+
+// Write the exponentials of a row relative to max multiplied by factor.
+template <typename FPType, typename InRow, typename OutRow>
+static void normaliseRow(const InRow &in, OutRow &out, unsigned size,
+                         float max, float factor) {
+  for (unsigned i = 0; i != size; ++i) {
+    out[i] = FPType(std::exp(float(in[i]) - max) * factor);
+  }
+}
+
+// Softmax of one row, scaled by scale, in two passes over it. The first pass
+// finds the maximum of the row and the sum of its exponentials and the
+// second pass writes the normalised exponentials. Elements of -infinity give
+// 0. Without the stable algorithm the exponentials aren't shifted.
+template <typename FPType, bool stable, typename InRow, typename OutRow>
+static void softMaxRow(const InRow &in, OutRow &out, unsigned size,
+                       float scale) {
+  float max, sum;
+  getRowStats<stable>(in, size, max, sum);
+  normaliseRow<FPType>(in, out, size, max, scale / sum);
+}
+
+template <typename FPType, bool stable> class SoftMax2D : public Vertex {
+public:
+  SoftMax2D();
+
+  Vector<Input<Vector<FPType>>> in;
+  Vector<Output<Vector<FPType, ONE_PTR>>, ONE_PTR> out;
+  const float scale;
+
+  IS_EXTERNAL_CODELET(false);
+  bool compute() {
+    for (unsigned r = 0; r != in.size(); ++r) {
+      softMaxRow<FPType, stable>(in[r], out[r], in[r].size(), scale);
+    }
+    return true;
+  }
+};
+
+template class SoftMax2D<float, false>;
+template class SoftMax2D<float, true>;
+template class SoftMax2D<half, false>;
+template class SoftMax2D<half, true>;
+
+template <typename FPType, bool stable> class SoftMax2DInPlace : public Vertex {
+public:
+  SoftMax2DInPlace();
+
+  Vector<InOut<Vector<FPType>>> data;
+  const float scale;
+
+  IS_EXTERNAL_CODELET(false);
+  bool compute() {
+    for (unsigned r = 0; r != data.size(); ++r) {
+      softMaxRow<FPType, stable>(data[r], data[r], data[r].size(), scale);
+    }
+    return true;
+  }
+};
+
+template class SoftMax2DInPlace<float, false>;
+template class SoftMax2DInPlace<float, true>;
+template class SoftMax2DInPlace<half, false>;
+template class SoftMax2DInPlace<half, true>;
+
+// The statistics of segments of rows which are combined to compute the
+// softmax of rows split between workers. For each segment the maximum and
+// the sum of the exponentials relative to it are written to stats. A segment
+// of only -infinity has a maximum of -infinity and a sum of 0.
+template <typename FPType, bool stable> class SoftMaxStats : public Vertex {
+public:
+  SoftMaxStats();
+
+  Vector<Input<Vector<FPType>>> in;
+  Output<Vector<float, ONE_PTR>> stats;
+
+  IS_EXTERNAL_CODELET(false);
+  bool compute() {
+    for (unsigned s = 0; s != in.size(); ++s) {
+      getRowStats<stable>(in[s], in[s].size(), stats[2 * s], stats[2 * s + 1]);
+    }
+    return true;
+  }
+};
+
+template class SoftMaxStats<float, false>;
+template class SoftMaxStats<float, true>;
+template class SoftMaxStats<half, false>;
+template class SoftMaxStats<half, true>;
+
+// Normalise segments of rows given the maximum of the row of each segment and
+// the factor to multiply the exponentials relative to it by, which are in
+// rowStats.
+template <typename FPType> class SoftMaxNormalise : public Vertex {
+public:
+  SoftMaxNormalise();
+
+  Vector<Input<Vector<FPType>>> in;
+  Vector<Output<Vector<FPType, ONE_PTR>>, ONE_PTR> out;
+  Input<Vector<float, ONE_PTR>> rowStats;
+
+  IS_EXTERNAL_CODELET(false);
+  bool compute() {
+    for (unsigned s = 0; s != in.size(); ++s) {
+      normaliseRow<FPType>(in[s], out[s], in[s].size(), rowStats[2 * s],
+                           rowStats[2 * s + 1]);
+    }
+    return true;
+  }
+};
+
+template class SoftMaxNormalise<float>;
+template class SoftMaxNormalise<half>;
+
+template <typename FPType> class SoftMaxNormaliseInPlace : public Vertex {
+public:
+  SoftMaxNormaliseInPlace();
+
+  Vector<InOut<Vector<FPType>>> data;
+  Input<Vector<float, ONE_PTR>> rowStats;
+
+  IS_EXTERNAL_CODELET(false);
+  bool compute() {
+    for (unsigned s = 0; s != data.size(); ++s) {
+      normaliseRow<FPType>(data[s], data[s], data[s].size(), rowStats[2 * s],
+                           rowStats[2 * s + 1]);
+    }
+    return true;
+  }
+};
+
+template class SoftMaxNormaliseInPlace<float>;
+template class SoftMaxNormaliseInPlace<half>;
+
+} // namespace popnn
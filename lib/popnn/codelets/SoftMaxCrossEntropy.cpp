@@ -0,0 +1,99 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#include "poplibs_support/ExternalCodelet.hpp"
+#include <cmath>
+#include <limits>
+#include <poplar/HalfFloat.hpp>
+#include <poplar/Vertex.hpp>
+
+using namespace poplar;
+static constexpr auto ONE_PTR = poplar::VectorLayout::ONE_PTR;
+
+namespace popnn {
+
+// Partials of the softmax cross entropy loss for segments of rows of logits.
+// For each segment the maximum, the sum of the exponentials relative to the
+// maximum and the logit of the label, or 0 if the label isn't in the segment,
+// are written to stats. colOffsets is the column of the start of each segment
+// in its row. Logits of -infinity are skipped, so a segment of them has a
+// maximum of -infinity and a sum of 0.
+template <typename FPType, typename LabelType>
+class SoftMaxCrossEntropyStats : public Vertex {
+public:
+  SoftMaxCrossEntropyStats();
+
+  Vector<Input<Vector<FPType>>> logits;
+  Input<Vector<LabelType, ONE_PTR>> labels;
+  Input<Vector<unsigned, ONE_PTR>> colOffsets;
+  Output<Vector<float, ONE_PTR>> stats;
+
+  IS_EXTERNAL_CODELET(false);
+  bool compute() {
+    for (unsigned s = 0; s != logits.size(); ++s) {
+      // Masked labels are never in a segment.
+      const unsigned labelIndex = unsigned(labels[s]) - colOffsets[s];
+      float max = -std::numeric_limits<float>::infinity();
+      float sum = 0.0f;
+      float labelLogit = 0.0f;
+      for (unsigned i = 0; i != logits[s].size(); ++i) {
+        const float x = float(logits[s][i]);
+        if (x > max) {
+          sum = sum * std::exp(max - x) + 1.0f;
+          max = x;
+        } else if (x != -std::numeric_limits<float>::infinity()) {
+          sum += std::exp(x - max);
+        }
+        if (i == labelIndex) {
+          labelLogit = x;
+        }
+      }
+      stats[3 * s] = max;
+      stats[3 * s + 1] = sum;
+      stats[3 * s + 2] = labelLogit;
+    }
+    return true;
+  }
+};
+
+template class SoftMaxCrossEntropyStats<float, unsigned int>;
+template class SoftMaxCrossEntropyStats<float, int>;
+template class SoftMaxCrossEntropyStats<half, unsigned int>;
+template class SoftMaxCrossEntropyStats<half, int>;
+
+// Gradient of the softmax cross entropy loss with respect to segments of rows
+// of logits. rowStats holds the maximum of the row, the reciprocal of the sum
+// of the exponentials of the row relative to it and the scale of the gradient
+// for each segment.
+template <typename FPType, typename LabelType>
+class SoftMaxCrossEntropyGrad : public Vertex {
+public:
+  SoftMaxCrossEntropyGrad();
+
+  Vector<Input<Vector<FPType>>> logits;
+  Vector<Output<Vector<FPType, ONE_PTR>>, ONE_PTR> deltas;
+  Input<Vector<LabelType, ONE_PTR>> labels;
+  Input<Vector<unsigned, ONE_PTR>> colOffsets;
+  Input<Vector<float, ONE_PTR>> rowStats;
+
+  IS_EXTERNAL_CODELET(false);
+  bool compute() {
+    for (unsigned s = 0; s != logits.size(); ++s) {
+      const unsigned labelIndex = unsigned(labels[s]) - colOffsets[s];
+      const float max = rowStats[3 * s];
+      const float invSum = rowStats[3 * s + 1];
+      const float scale = rowStats[3 * s + 2];
+      for (unsigned i = 0; i != logits[s].size(); ++i) {
+        const float prob = std::exp(float(logits[s][i]) - max) * invSum;
+        const float expected = i == labelIndex ? 1.0f : 0.0f;
+        deltas[s][i] = FPType((prob - expected) * scale);
+      }
+    }
+    return true;
+  }
+};
+
+template class SoftMaxCrossEntropyGrad<float, unsigned int>;
+template class SoftMaxCrossEntropyGrad<float, int>;
+template class SoftMaxCrossEntropyGrad<half, unsigned int>;
+template class SoftMaxCrossEntropyGrad<half, int>;
+
+} // namespace popnn
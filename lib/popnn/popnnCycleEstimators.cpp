@@ -475,6 +475,7 @@ std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(ReduceMaxNClassGather)(
     const VertexIntrospector &vertex, const Target &target, const Type &fpType,
     const bool sorted) {
   CODELET_FIELD(activations);
+  CODELET_FIELD(regions);
   CODELET_SCALAR_VAL(divisorLog2, unsigned short);
   CODELET_SCALAR_VAL(numK, unsigned short);
 
@@ -507,8 +508,9 @@ std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(ReduceMaxNClassGather)(
     cycles += (activations.size() - numK) * (13 + std::log(numK) * 20);
 
     // As we are working on the indices we do a bit at the end to store the
-    // actual values as well and transform the indices.
-    cycles += 8 * numK;
+    // actual values as well and transform the indices, searching the regions
+    // for each of them.
+    cycles += (8 + 4 * regions.size() / 2) * numK;
 
     if (sorted) {
       for (int i = numK; i >= 1; --i) {
@@ -670,6 +672,110 @@ MAKE_CYCLE_ESTIMATOR_NAME(CalcAccuracy)(const VertexIntrospector &vertex,
   return cycles;
 }
 
+// Cycles of the compiled softmax vertices for rows of the given sizes.
+static std::uint64_t getSoftMax2DCycles(const std::vector<std::size_t> &rows,
+                                        bool stable) {
+  std::uint64_t cycles = 5; // Vertex overhead
+  for (const auto size : rows) {
+    cycles += 10 +                    // Row pointers and loop overhead
+              size * (stable ? 8 : 6) // Running max and sum, exp
+              + 10 +                  // Reciprocal of the sum
+              size * 7;               // Normalise and store
+  }
+  return cycles;
+}
+
+std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(SoftMax2D)(
+    const VertexIntrospector &vertex, const Target &target, const Type &type,
+    const bool stable) {
+  CODELET_FIELD(in);
+  std::vector<std::size_t> rows;
+  for (unsigned r = 0; r != in.size(); ++r) {
+    rows.push_back(in[r].size());
+  }
+  return getSoftMax2DCycles(rows, stable);
+}
+
+std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(SoftMax2DInPlace)(
+    const VertexIntrospector &vertex, const Target &target, const Type &type,
+    const bool stable) {
+  CODELET_FIELD(data);
+  std::vector<std::size_t> rows;
+  for (unsigned r = 0; r != data.size(); ++r) {
+    rows.push_back(data[r].size());
+  }
+  return getSoftMax2DCycles(rows, stable);
+}
+
+std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(SoftMaxStats)(
+    const VertexIntrospector &vertex, const Target &target, const Type &type,
+    const bool stable) {
+  CODELET_FIELD(in);
+  std::uint64_t cycles = 5; // Vertex overhead
+  for (unsigned s = 0; s != in.size(); ++s) {
+    cycles += 10 +                              // Pointers and loop overhead
+              in[s].size() * (stable ? 8 : 6) + // Running max and sum, exp
+              4;                                // Store stats
+  }
+  return cycles;
+}
+
+// Cycles of the compiled normalise vertices for segments of the given sizes.
+static std::uint64_t
+getSoftMaxNormaliseCycles(const std::vector<std::size_t> &segments) {
+  std::uint64_t cycles = 5; // Vertex overhead
+  for (const auto size : segments) {
+    cycles += 10 +      // Pointers, row stats and loop overhead
+              size * 7; // Normalise and store
+  }
+  return cycles;
+}
+
+std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(SoftMaxNormalise)(
+    const VertexIntrospector &vertex, const Target &target, const Type &type) {
+  CODELET_FIELD(in);
+  std::vector<std::size_t> segments;
+  for (unsigned s = 0; s != in.size(); ++s) {
+    segments.push_back(in[s].size());
+  }
+  return getSoftMaxNormaliseCycles(segments);
+}
+
+std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(SoftMaxNormaliseInPlace)(
+    const VertexIntrospector &vertex, const Target &target, const Type &type) {
+  CODELET_FIELD(data);
+  std::vector<std::size_t> segments;
+  for (unsigned s = 0; s != data.size(); ++s) {
+    segments.push_back(data[s].size());
+  }
+  return getSoftMaxNormaliseCycles(segments);
+}
+
+std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(SoftMaxCrossEntropyStats)(
+    const VertexIntrospector &vertex, const Target &target, const Type &fpType,
+    const Type &labelType) {
+  CODELET_FIELD(logits);
+  std::uint64_t cycles = 5; // Vertex overhead
+  for (unsigned s = 0; s != logits.size(); ++s) {
+    cycles += 15 +                     // Label index and pointers
+              logits[s].size() * 10 +  // Running max and sum, exp, label
+              6;                       // Store partials
+  }
+  return cycles;
+}
+
+std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(SoftMaxCrossEntropyGrad)(
+    const VertexIntrospector &vertex, const Target &target, const Type &fpType,
+    const Type &labelType) {
+  CODELET_FIELD(logits);
+  std::uint64_t cycles = 5; // Vertex overhead
+  for (unsigned s = 0; s != logits.size(); ++s) {
+    cycles += 15 +                   // Label index, row stats and pointers
+              logits[s].size() * 9;  // exp, subtract expected, scale, store
+  }
+  return cycles;
+}
+
 poplibs::CycleEstimatorTable makeCyclesFunctionTable() {
   return {
       CYCLE_ESTIMATOR_ENTRY(popnn, LossSumSquaredTransform, FLOAT),
@@ -756,6 +862,35 @@ poplibs::CycleEstimatorTable makeCyclesFunctionTable() {
       CYCLE_ESTIMATOR_ENTRY(popnn, SelectiveScaling, FLOAT),
       CYCLE_ESTIMATOR_ENTRY(popnn, SelectiveScaling, HALF),
 
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMax2D, FLOAT, false),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMax2D, FLOAT, true),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMax2D, HALF, false),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMax2D, HALF, true),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMax2DInPlace, FLOAT, false),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMax2DInPlace, FLOAT, true),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMax2DInPlace, HALF, false),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMax2DInPlace, HALF, true),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxStats, FLOAT, false),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxStats, FLOAT, true),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxStats, HALF, false),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxStats, HALF, true),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxNormalise, FLOAT),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxNormalise, HALF),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxNormaliseInPlace, FLOAT),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxNormaliseInPlace, HALF),
+
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxCrossEntropyStats, FLOAT,
+                            UNSIGNED_INT),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxCrossEntropyStats, FLOAT, INT),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxCrossEntropyStats, HALF,
+                            UNSIGNED_INT),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxCrossEntropyStats, HALF, INT),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxCrossEntropyGrad, FLOAT,
+                            UNSIGNED_INT),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxCrossEntropyGrad, FLOAT, INT),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxCrossEntropyGrad, HALF, UNSIGNED_INT),
+      CYCLE_ESTIMATOR_ENTRY(popnn, SoftMaxCrossEntropyGrad, HALF, INT),
+
       INSTANTIATE_NL_CYCLE_ESTIMATOR(NonLinearityGradSupervisor),
       INSTANTIATE_NL_CYCLE_ESTIMATOR(NonLinearitySupervisor),
       INSTANTIATE_NL_CYCLE_ESTIMATOR(NonLinearityGrad2D),
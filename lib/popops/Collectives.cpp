@@ -47,6 +47,7 @@ enum class CollectiveMethod {
 static CollectiveMethod
 parseCollectiveOptions(const poplar::OptionFlags &options) {
   CollectiveMethod method = CollectiveMethod::AUTO;
+  Type exchangeType = FLOAT;
   using poplibs::OptionHandler;
   using poplibs::OptionSpec;
   const OptionSpec spec{
@@ -58,10 +59,17 @@ parseCollectiveOptions(const poplar::OptionFlags &options) {
             {"anticlockwise_ring", CollectiveMethod::ANTICLOCKWISE_RING},
             {"bidirectional_ring_pair",
              CollectiveMethod::BIDIRECTIONAL_RING_PAIR},
-            {"meet_in_middle_ring", CollectiveMethod::MEET_IN_MIDDLE_RING}})}};
+            {"meet_in_middle_ring", CollectiveMethod::MEET_IN_MIDDLE_RING}})},
+      {"exchangeType",
+       OptionHandler::createWithEnum(exchangeType,
+                                     {{"float", FLOAT}, {"half", HALF}})}};
   for (const auto &entry : options) {
     spec.parse(entry.first, entry.second);
   }
+  if (exchangeType != FLOAT) {
+    logging::warn("The exchangeType option is only supported by the "
+                  "replicated implementation, ignoring it");
+  }
   return method;
 }
 
@@ -5,9 +5,11 @@
 #include <boost/optional.hpp>
 #include <boost/variant.hpp>
 #include <cassert>
+#include <map>
 #include <poplar/Graph.hpp>
 #include <poplar/Program.hpp>
 #include <poplibs_support/Visitor.hpp>
+#include <popops/Cast.hpp>
 #include <popops/ElementWise.hpp>
 #include <poputil/exceptions.hpp>
 
@@ -166,19 +168,33 @@ struct ReduceProg {
   poplar::Tensor B;
   popops::Operation op;
   std::string debugPrefix;
+  // If the data is exchanged in a smaller type than it is reduced in, B has
+  // the exchange type and A is cast into this buffer after the reduction so
+  // that it is ready to be sent in the next step.
+  boost::optional<poplar::Tensor> compressed;
   ReduceProg(poplar::Tensor A, poplar::Tensor B, popops::Operation op,
-             std::string prefix)
-      : A(A), B(B), op(op), debugPrefix(prefix) {}
+             std::string prefix,
+             boost::optional<poplar::Tensor> compressed = boost::none)
+      : A(A), B(B), op(op), debugPrefix(prefix), compressed(compressed) {}
 
   ReduceProg operator+(const ReduceProg &other) const {
     assert(op == other.op);
-    return ReduceProg(concat(A, other.A), concat(B, other.B), op, debugPrefix);
+    assert(static_cast<bool>(compressed) ==
+           static_cast<bool>(other.compressed));
+    boost::optional<poplar::Tensor> combinedCompressed;
+    if (compressed) {
+      combinedCompressed = concat(compressed.get(), other.compressed.get());
+    }
+    return ReduceProg(concat(A, other.A), concat(B, other.B), op, debugPrefix,
+                      combinedCompressed);
   }
 };
 
 struct CollectivesProgram {
   unsigned repeatCounter = 0;
-  poplar::Tensor undefTensor; // These will be undeffed in the sequence
+  // These will be undeffed in the sequence. The buffers exchanged in a
+  // smaller type have a different type to the others.
+  std::vector<poplar::Tensor> undefTensors;
   // The src buffer that the slice program will slice into
   // The reduce scatter step returns this buffer, all gather doesn't set this
   boost::optional<poplar::Tensor> srcBuffer;
@@ -197,10 +213,55 @@ struct CollectivesProgram {
   CollectivesProgram(SliceCopy sliceCopy) : sliceFragments(sliceCopy) {}
 };
 
+// Write undef to tensors which may have different types.
+static poplar::program::Sequence
+writeUndef(const std::vector<poplar::Tensor> &tensors) {
+  std::map<poplar::Type, std::vector<poplar::Tensor>> tensorsByType;
+  for (const auto &t : tensors) {
+    tensorsByType[t.elementType()].push_back(t.flatten());
+  }
+  poplar::program::Sequence prog;
+  for (const auto &entry : tensorsByType) {
+    prog.add(poplar::program::WriteUndef(concat(entry.second)));
+  }
+  return prog;
+}
+
+// Reduce b, which was received in a smaller type than a, into a.
+static void opInPlaceWithCast(poplar::Graph &graph, popops::Operation op,
+                              const poplar::Tensor &a, const poplar::Tensor &b,
+                              poplar::program::Sequence &prog,
+                              const std::string &debugPrefix) {
+  using namespace popops::expr;
+  const auto castB = Cast(_2, a.elementType());
+  switch (op) {
+  case Operation::ADD:
+    mapInPlace(graph, Add(_1, castB), {a, b}, prog, debugPrefix);
+    break;
+  case Operation::MUL:
+    mapInPlace(graph, Mul(_1, castB), {a, b}, prog, debugPrefix);
+    break;
+  case Operation::MIN:
+    mapInPlace(graph, Min(_1, castB), {a, b}, prog, debugPrefix);
+    break;
+  case Operation::MAX:
+    mapInPlace(graph, Max(_1, castB), {a, b}, prog, debugPrefix);
+    break;
+  default:
+    throw poputil::poplibs_error("Collective reduction with a smaller "
+                                 "exchange type is only supported for the "
+                                 "ADD, MUL, MIN and MAX operations");
+  }
+}
+
 static void opInPlace(poplar::Graph &graph, popops::Operation op,
                       const poplar::Tensor &a, const poplar::Tensor &b,
                       poplar::program::Sequence &prog,
                       const std::string &debugPrefix) {
+  if (a.elementType() != b.elementType()) {
+    opInPlaceWithCast(graph, op, a, b, prog, debugPrefix);
+    return;
+  }
   switch (op) {
   case Operation::ADD:
     addInPlace(graph, a, b, prog, debugPrefix);
@@ -226,6 +287,18 @@ static void opInPlace(poplar::Graph &graph, popops::Operation op,
   }
 }
 
+// Create a program that casts the reduced data into the buffer it is sent
+// from if it is exchanged in a smaller type.
+static poplar::program::Sequence
+compress(poplar::Graph &graph, const boost::optional<ReduceProg> &reduceProg) {
+  poplar::program::Sequence prog;
+  if (reduceProg && reduceProg->compressed) {
+    prog.add(popops::cast(graph, reduceProg->A, reduceProg->compressed.get(),
+                          reduceProg->debugPrefix + "/Compress"));
+  }
+  return prog;
+}
+
 static poplar::program::Sequence
 opInPlace(poplar::Graph &graph, const boost::optional<ReduceProg> &reduceProg) {
   poplar::program::Sequence prog;
@@ -234,9 +307,18 @@ opInPlace(poplar::Graph &graph, const boost::optional<ReduceProg> &reduceProg) {
   }
   opInPlace(graph, reduceProg->op, reduceProg->A, reduceProg->B, prog,
             reduceProg->debugPrefix);
+  prog.add(compress(graph, reduceProg));
   return prog;
 }
 
+static poplar::program::Sequence writeUndef(const CollectivesProgram &a,
+                                            const CollectivesProgram &b) {
+  auto undefTensors = a.undefTensors;
+  undefTensors.insert(undefTensors.end(), b.undefTensors.begin(),
+                      b.undefTensors.end());
+  return writeUndef(undefTensors);
+}
+
 poplar::program::Sequence unidirectionalSequence(CollectivesProgram &program,
                                                  poplar::Graph &graph) {
   using namespace poplar::program;
@@ -246,8 +328,10 @@ poplar::program::Sequence unidirectionalSequence(CollectivesProgram &program,
                     program.exchangeProg.createProgram(),
                     std::move(program.allgatherCopy), Call(sliceFunction),
                     opInPlace(graph, program.reduceProg));
-  return Sequence(WriteUndef(program.undefTensor), std::move(program.initIndex),
+  return Sequence(writeUndef(program.undefTensors),
+                  std::move(program.initIndex),
                   std::move(program.firstGatherCopy), Call(sliceFunction),
+                  compress(graph, program.reduceProg),
                   Repeat(program.repeatCounter, std::move(loopBody)));
 }
 // Create a program that does a clockwise and anticlockwise collective
@@ -274,12 +358,13 @@ bidirectionalSequence(CollectivesProgram &clockwise,
                     std::move(clockwise.allgatherCopy),
                     std::move(anticlockwise.allgatherCopy), Call(sliceFunction),
                     opInPlace(graph, combinedReduceProg));
-  return Sequence(
-      WriteUndef(concat(clockwise.undefTensor, anticlockwise.undefTensor)),
-      std::move(clockwise.initIndex), std::move(anticlockwise.initIndex),
-      std::move(clockwise.firstGatherCopy),
-      std::move(anticlockwise.firstGatherCopy), Call(sliceFunction),
-      Repeat(clockwise.repeatCounter, std::move(loopBody)));
+  return Sequence(writeUndef(clockwise, anticlockwise),
+                  std::move(clockwise.initIndex),
+                  std::move(anticlockwise.initIndex),
+                  std::move(clockwise.firstGatherCopy),
+                  std::move(anticlockwise.firstGatherCopy), Call(sliceFunction),
+                  compress(graph, combinedReduceProg),
+                  Repeat(clockwise.repeatCounter, std::move(loopBody)));
 }
 
 // Create the sequence needed for the meet in the middle collective
@@ -338,13 +423,15 @@ poplar::program::Sequence meetInMiddleReduceScatterSequence(
                               opInPlace(subGraph, anticlockwise.reduceProg))))),
       std::move(anticlockwise.incrementIndex), std::move(incrementLoopCounter));
   return Sequence(
-      WriteUndef(concat(clockwise.undefTensor, anticlockwise.undefTensor)),
+      writeUndef(clockwise, anticlockwise),
       Copy(std::move(trueConst), isFirstStep), Copy(falseConst, isLastStep),
       Copy(std::move(zeroConst), std::move(loopCounter)),
       std::move(clockwise.initIndex), std::move(anticlockwise.initIndex),
       Call(clockwiseSliceFunction),
+      compress(subGraph, clockwise.reduceProg),
       // TODO: T12922 Put this in first iteration of repeat loop.
       Call(anticlockwiseSliceFunction),
+      compress(subGraph, anticlockwise.reduceProg),
       Repeat(clockwise.repeatCounter, std::move(loopBody)));
 }
 
@@ -405,7 +492,7 @@ meetInMiddleAllGatherSequence(CollectivesProgram &clockwise,
       If(isLastStep, Sequence(), Sequence(Call(anticlockwiseSliceFunction))),
       std::move(incrementLoopCounter));
   return Sequence(
-      WriteUndef(concat(clockwise.undefTensor, anticlockwise.undefTensor)),
+      writeUndef(clockwise, anticlockwise),
       Copy(std::move(trueConst), std::move(isFirstStep)),
       Copy(std::move(falseConst), std::move(isLastStep)),
       Copy(std::move(zeroConst), std::move(loopCounter)),
@@ -8,6 +8,7 @@
 #include "popops/Cast.hpp"
 #include "popops/ElementWiseUtil.hpp"
 #include "popops/NaN.hpp"
+#include "popops/Reduce.hpp"
 #include "poputil/Broadcast.hpp"
 #include "poputil/OptionParsing.hpp"
 #include "poputil/TileMapping.hpp"
@@ -24,11 +25,14 @@
 #include <cassert>
 
 #include <cstdio>
+#include <cstdlib>
 #include <fstream>
 #include <queue>
 #include <stack>
 
+#include "ExprSimplify.hpp"
 #include "ExpressionGenerator.hpp"
+#include "FusedCodeletCache.hpp"
 
 using namespace poputil;
 using namespace poplar;
@@ -2102,6 +2106,54 @@ inferTile(const Graph &graph, const expr::Expr &expr,
   POPLIB_UNREACHABLE();
 }
 
+// The results of sub-expressions which have been added to the graph, by the
+// name of the sub-expression.
+using SubExprResults = std::unordered_map<std::string, Tensor>;
+
+std::pair<Tensor, bool>
+mapExpr(Graph &graph, const expr::Expr &expr, const std::vector<Tensor> &ts,
+        program::Sequence &prog, const std::string &debugPrefix,
+        const std::unordered_map<const expr::Expr *, Type> &constTypes,
+        const std::unordered_map<const expr::Expr *, unsigned> &constTiles,
+        bool topLevel, bool constructGraph, bool inPlace,
+        const expr::Expr *&inPlaceExpr, const MapOptions &options,
+        SubExprResults &subExprs);
+
+// Add the operations of the expression to the graph, reusing the result of an
+// identical sub-expression that was added earlier rather than adding its
+// operations again. Only results that weren't computed in place are reused,
+// so they can't be overwritten by a later in-place operation.
+std::pair<Tensor, bool>
+map(Graph &graph, const expr::Expr &expr, const std::vector<Tensor> &ts,
+    program::Sequence &prog, const std::string &debugPrefix,
+    const std::unordered_map<const expr::Expr *, Type> &constTypes,
+    const std::unordered_map<const expr::Expr *, unsigned> &constTiles,
+    bool topLevel, bool constructGraph, bool inPlace,
+    const expr::Expr *&inPlaceExpr, const MapOptions &options,
+    SubExprResults &subExprs) {
+  const bool isOperation = expr.isA<expr::UnaryOp>() ||
+                           expr.isA<expr::BinaryOp>() ||
+                           expr.isA<expr::TernaryOp>();
+  if (!constructGraph || !isOperation || !dependsOnPlaceholder(expr)) {
+    return mapExpr(graph, expr, ts, prog, debugPrefix, constTypes, constTiles,
+                   topLevel, constructGraph, inPlace, inPlaceExpr, options,
+                   subExprs);
+  }
+  const auto name = expr.name(ts);
+  const auto match = subExprs.find(name);
+  if (match != subExprs.end()) {
+    return {match->second, false};
+  }
+  auto result =
+      mapExpr(graph, expr, ts, prog, debugPrefix, constTypes, constTiles,
+              topLevel, constructGraph, inPlace, inPlaceExpr, options,
+              subExprs);
+  if (!result.second) {
+    subExprs.emplace(name, result.first);
+  }
+  return result;
+}
+
 // Recursively walk up the expression tree and do inPlace operations if
 // conditions are met
 // topLevel :
@@ -2116,15 +2168,19 @@ inferTile(const Graph &graph, const expr::Expr &expr,
 //   operation succeeds if placeholder with index 1 is on the leftmost traversal
 //   path
 //
+// subExprs :
+//   The results of the sub-expressions already added to the graph, see map().
+//
 // Further in-place optimisations are possible by traversing the tree and
 // transforming the operations.
 std::pair<Tensor, bool>
-map(Graph &graph, const expr::Expr &expr, const std::vector<Tensor> &ts,
-    program::Sequence &prog, const std::string &debugPrefix,
-    const std::unordered_map<const expr::Expr *, Type> constTypes,
-    const std::unordered_map<const expr::Expr *, unsigned> constTiles,
-    bool topLevel, bool constructGraph, bool inPlace,
-    const expr::Expr *&inPlaceExpr, const MapOptions &options) {
+mapExpr(Graph &graph, const expr::Expr &expr, const std::vector<Tensor> &ts,
+        program::Sequence &prog, const std::string &debugPrefix,
+        const std::unordered_map<const expr::Expr *, Type> &constTypes,
+        const std::unordered_map<const expr::Expr *, unsigned> &constTiles,
+        bool topLevel, bool constructGraph, bool inPlace,
+        const expr::Expr *&inPlaceExpr, const MapOptions &options,
+        SubExprResults &subExprs) {
 
   if (!constructGraph)
     assert(!inPlace);
@@ -2164,7 +2220,7 @@ map(Graph &graph, const expr::Expr &expr, const std::vector<Tensor> &ts,
   } else if (const expr::Cast *c = expr.getAs<expr::Cast>()) {
     auto t =
         map(graph, c->getLHS(), ts, prog, debugPrefix, constTypes, constTiles,
-            false, constructGraph, inPlace, inPlaceExpr, options);
+            false, constructGraph, inPlace, inPlaceExpr, options, subExprs);
     if (constructGraph) {
       return {cast(graph, t.first, c->getRHSType(), prog, debugPrefix),
               t.second};
@@ -2175,7 +2231,7 @@ map(Graph &graph, const expr::Expr &expr, const std::vector<Tensor> &ts,
     auto opType = u->getOpType();
     auto t =
         map(graph, u->getArg(), ts, prog, debugPrefix, constTypes, constTiles,
-            false, constructGraph, inPlace, inPlaceExpr, options);
+            false, constructGraph, inPlace, inPlaceExpr, options, subExprs);
     if (constructGraph) {
       return {unaryOp(graph, t.first, prog, opType, t.second, debugPrefix),
               t.second};
@@ -2186,10 +2242,10 @@ map(Graph &graph, const expr::Expr &expr, const std::vector<Tensor> &ts,
     auto opType = b->getOpType();
     auto lhs =
         map(graph, b->getLHS(), ts, prog, debugPrefix, constTypes, constTiles,
-            false, constructGraph, inPlace, inPlaceExpr, options);
+            false, constructGraph, inPlace, inPlaceExpr, options, subExprs);
     auto rhs =
         map(graph, b->getRHS(), ts, prog, debugPrefix, constTypes, constTiles,
-            false, constructGraph, false, inPlaceExpr, options);
+            false, constructGraph, false, inPlaceExpr, options, subExprs);
     if (constructGraph) {
       return {binaryOp(graph, lhs.first, rhs.first, prog, opType, lhs.second,
                        options, debugPrefix),
@@ -2202,13 +2258,16 @@ map(Graph &graph, const expr::Expr &expr, const std::vector<Tensor> &ts,
     if (opType == TernaryOpType::SELECT) {
       auto lhs =
           map(graph, t->getArg0(), ts, prog, debugPrefix, constTypes,
-              constTiles, false, constructGraph, inPlace, inPlaceExpr, options);
+              constTiles, false, constructGraph, inPlace, inPlaceExpr,
+              options, subExprs);
       auto rhs =
           map(graph, t->getArg1(), ts, prog, debugPrefix, constTypes,
-              constTiles, false, constructGraph, false, inPlaceExpr, options);
+              constTiles, false, constructGraph, false, inPlaceExpr,
+              options, subExprs);
       auto pred =
           map(graph, t->getArg2(), ts, prog, debugPrefix, constTypes,
-              constTiles, false, constructGraph, false, inPlaceExpr, options);
+              constTiles, false, constructGraph, false, inPlaceExpr,
+              options, subExprs);
       if (constructGraph) {
         return {ternaryOp(graph, lhs.first, rhs.first, pred.first, prog, opType,
                           lhs.second, debugPrefix),
@@ -2220,13 +2279,16 @@ map(Graph &graph, const expr::Expr &expr, const std::vector<Tensor> &ts,
       assert(opType == TernaryOpType::CLAMP);
       auto in =
           map(graph, t->getArg0(), ts, prog, debugPrefix, constTypes,
-              constTiles, false, constructGraph, inPlace, inPlaceExpr, options);
+              constTiles, false, constructGraph, inPlace, inPlaceExpr,
+              options, subExprs);
       auto lower =
           map(graph, t->getArg1(), ts, prog, debugPrefix, constTypes,
-              constTiles, false, constructGraph, false, inPlaceExpr, options);
+              constTiles, false, constructGraph, false, inPlaceExpr,
+              options, subExprs);
       auto upper =
           map(graph, t->getArg2(), ts, prog, debugPrefix, constTypes,
-              constTiles, false, constructGraph, false, inPlaceExpr, options);
+              constTiles, false, constructGraph, false, inPlaceExpr,
+              options, subExprs);
       if (constructGraph) {
         return {ternaryOp(graph, in.first, lower.first, upper.first, prog,
                           opType, in.second, debugPrefix),
@@ -2251,6 +2313,17 @@ getConstType(const expr::Expr &expr, const std::vector<Tensor> &ts) {
   return constTypes;
 }
 
+Type getExprType(const expr::Expr &expr, const std::vector<Tensor> &ts) {
+  std::unordered_map<const expr::Expr *, Type> constTypes;
+  std::vector<const expr::Expr *> unknown;
+  auto type = inferType(expr, ts, constTypes, unknown);
+
+  if (!type || !unknown.empty()) {
+    throw poplibs_error("Cannot infer type of expression");
+  }
+  return *type;
+}
+
 std::unordered_map<const expr::Expr *, unsigned>
 getConstTile(const Graph &graph, const expr::Expr &expr,
              const std::vector<Tensor> &ts) {
@@ -2267,22 +2340,24 @@ Tensor map(Graph &graph, const expr::Expr &expr, const std::vector<Tensor> &ts,
            const OptionFlags &options) {
   auto opts = parseOptionFlags(options);
 
-  auto constTypes = getConstType(expr, ts);
+  const auto simplified = simplifyExpr(expr, getConstType(expr, ts));
+  auto constTypes = getConstType(*simplified, ts);
   // If the user hasn't overridden 'enableGenerateCodelet' to be false and all
   // of the inputs don't alias and are the same size we can generate a codelet
   // to execute this map.
   const auto canGenerateCodelet =
-      analyseExpr(expr, ts, opts.forceGenerateCodelet);
+      analyseExpr(*simplified, ts, opts.forceGenerateCodelet);
   if (opts.enableGenerateCodelet && canGenerateCodelet.isSupported) {
     return generateAndExecuteMappedOperations(
-        graph, expr, ts, constTypes, prog, false,
+        graph, *simplified, ts, constTypes, prog, false,
         canGenerateCodelet.allInputsScalar, debugPrefix);
   }
 
-  auto constTiles = getConstTile(graph, expr, ts);
+  auto constTiles = getConstTile(graph, *simplified, ts);
   const expr::Expr *inplaceExpr = nullptr;
-  return map(graph, expr, ts, prog, debugPrefix, constTypes, constTiles, true,
-             true, false, inplaceExpr, opts)
+  SubExprResults subExprs;
+  return map(graph, *simplified, ts, prog, debugPrefix, constTypes, constTiles,
+             true, true, false, inplaceExpr, opts, subExprs)
       .first;
 }
 
@@ -2290,30 +2365,32 @@ void mapInPlace(Graph &graph, const expr::Expr &expr,
                 const std::vector<Tensor> &ts, program::Sequence &prog,
                 const std::string &debugPrefix, const OptionFlags &options) {
   auto opts = parseOptionFlags(options);
-  auto constTypes = getConstType(expr, ts);
+  const auto simplified = simplifyExpr(expr, getConstType(expr, ts));
+  auto constTypes = getConstType(*simplified, ts);
   // If the user hasn't overridden 'enableGenerateCodelet' to be false and all
   // of the inputs don't alias and are the same size we can generate a codelet
   // to execute this map.
   const auto canGenerateCodelet =
-      analyseExpr(expr, ts, opts.forceGenerateCodelet);
+      analyseExpr(*simplified, ts, opts.forceGenerateCodelet);
   if (opts.enableGenerateCodelet && canGenerateCodelet.isSupported) {
-    generateAndExecuteMappedOperations(graph, expr, ts, constTypes, prog, true,
-                                       canGenerateCodelet.allInputsScalar,
+    generateAndExecuteMappedOperations(graph, *simplified, ts, constTypes, prog,
+                                       true, canGenerateCodelet.allInputsScalar,
                                        debugPrefix);
     return;
   }
 
-  auto constTiles = getConstTile(graph, expr, ts);
+  auto constTiles = getConstTile(graph, *simplified, ts);
   const expr::Expr *inPlaceExpr = nullptr;
+  SubExprResults subExprs;
   const bool doInPlace = !ts[0].containsAliases() && !ts[0].containsConstant();
   if (doInPlace) {
     // As the tree is traversed, find the last expression which uses the
     // tensor used for in-place operation as a placeholder
-    map(graph, expr, ts, prog, debugPrefix, constTypes, constTiles, true, false,
-        false, inPlaceExpr, opts);
+    map(graph, *simplified, ts, prog, debugPrefix, constTypes, constTiles, true,
+        false, false, inPlaceExpr, opts, subExprs);
   }
-  auto t = map(graph, expr, ts, prog, debugPrefix, constTypes, constTiles, true,
-               true, doInPlace, inPlaceExpr, opts);
+  auto t = map(graph, *simplified, ts, prog, debugPrefix, constTypes,
+               constTiles, true, true, doInPlace, inPlaceExpr, opts, subExprs);
   // If in-place operations were not performed, then copy the final result
   // into the tensor supplied.
   // TODO T12943 Optimisation: If placeholder _1 is not used, a copy may be done
@@ -2327,4 +2404,112 @@ void mapInPlace(Graph &graph, const expr::Expr &expr,
   }
 }
 
+std::vector<Tensor> mapMultiple(Graph &graph,
+                                const std::vector<const expr::Expr *> &exprs,
+                                const std::vector<MapReduction> &reductions,
+                                const std::vector<Tensor> &ts,
+                                program::Sequence &prog,
+                                const std::string &debugPrefix,
+                                const OptionFlags &options) {
+  if (exprs.empty()) {
+    throw poplibs_error("mapMultiple requires at least one expression");
+  }
+  auto opts = parseOptionFlags(options);
+
+  // Computing several results or reductions in one pass saves passes over
+  // the tensors even if each expression is a single operation.
+  const bool isForcedOn = opts.forceGenerateCodelet || exprs.size() > 1 ||
+                          !reductions.empty();
+  bool canGenerateCodelet = opts.enableGenerateCodelet;
+  bool allInputsScalar = true;
+  std::vector<std::unique_ptr<expr::Expr>> simplified;
+  std::vector<const expr::Expr *> simplifiedExprs;
+  std::unordered_map<const expr::Expr *, Type> constTypes;
+  for (const auto *expr : exprs) {
+    simplified.push_back(simplifyExpr(*expr, getConstType(*expr, ts)));
+    simplifiedExprs.push_back(simplified.back().get());
+    const auto exprConstTypes = getConstType(*simplified.back(), ts);
+    constTypes.insert(exprConstTypes.begin(), exprConstTypes.end());
+    const auto info = analyseExpr(*simplified.back(), ts, isForcedOn);
+    canGenerateCodelet &= info.isSupported;
+    allInputsScalar &= info.allInputsScalar;
+  }
+  std::vector<FusedReduction> fusedReductions;
+  for (const auto &reduction : reductions) {
+    if (reduction.output >= exprs.size()) {
+      throw poplibs_error("mapMultiple reduction of output " +
+                          std::to_string(reduction.output) + " but only " +
+                          std::to_string(exprs.size()) +
+                          " expressions were given");
+    }
+    const auto type = getExprType(*exprs[reduction.output], ts);
+    canGenerateCodelet &= isSupportedFusedReduction(reduction.op, type);
+    fusedReductions.push_back(
+        {reduction.output, reduction.op,
+         getFusedReductionPartialType(reduction.op, type)});
+  }
+  // Vertices of empty tensors would have no partials to reduce.
+  canGenerateCodelet &= std::all_of(ts.begin(), ts.end(), [](const Tensor &t) {
+    return t.numElements() != 0;
+  });
+
+  if (canGenerateCodelet) {
+    return generateAndExecuteMultiMappedOperations(
+        graph, simplifiedExprs, fusedReductions, ts, constTypes, prog, false,
+        allInputsScalar, debugPrefix);
+  }
+
+  logging::debug("mapMultiple can't be fused, mapping each expression and "
+                 "reducing the results separately");
+  std::vector<Tensor> outs;
+  for (const auto *expr : exprs) {
+    outs.push_back(map(graph, *expr, ts, prog, debugPrefix, options));
+  }
+  std::vector<ComputeSet> css;
+  for (const auto &reduction : reductions) {
+    const auto &out = outs[reduction.output];
+    outs.push_back(reduce(graph, out.flatten(), out.elementType(), {0},
+                          reduction.op, css, debugPrefix + "/Reduce"));
+  }
+  for (const auto &cs : css) {
+    prog.add(Execute(cs));
+  }
+  return outs;
+}
+
+void warmFusedCodeletCache(const Target &target,
+                           const std::vector<FusedMapSignature> &signatures) {
+  const auto dir = std::getenv(fusedCodeletCacheEnvVar);
+  if (!dir || !*dir) {
+    logging::warn("Not warming the fused codelet cache as {} is not set",
+                  fusedCodeletCacheEnvVar);
+    return;
+  }
+  Graph graph(target);
+  for (const auto &signature : signatures) {
+    if (signature.types.size() != signature.isScalar.size()) {
+      throw poplibs_error("The number of types and scalar flags in a fused "
+                          "map signature must match");
+    }
+    std::vector<Tensor> ts;
+    for (unsigned i = 0; i != signature.types.size(); ++i) {
+      const std::size_t numElements = signature.isScalar[i] ? 1 : 2;
+      ts.push_back(graph.addVariable(signature.types[i], {numElements}));
+    }
+    // The codelets are generated for the simplified expression, as they are
+    // by map().
+    const auto simplified =
+        simplifyExpr(*signature.expr, getConstType(*signature.expr, ts));
+    auto constTypes = getConstType(*simplified, ts);
+    const auto info = analyseExpr(*simplified, ts, true);
+    if (!info.isSupported) {
+      logging::debug("Skipping a fused map signature that can't be generated");
+      continue;
+    }
+    GenerateCodeletFromMapExpr generate{signature.inPlace, ts};
+    generate.traverseExpressionTree(*simplified, constTypes);
+    generate.generateCodelet(graph, info.allInputsScalar, *simplified);
+  }
+}
+
 } // namespace popops
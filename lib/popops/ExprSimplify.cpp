@@ -0,0 +1,262 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#include "ExprSimplify.hpp"
+#include "poplibs_support/Compiler.hpp"
+
+#include <boost/optional.hpp>
+
+#include <cmath>
+#include <cstring>
+
+using namespace poplar;
+
+namespace popops {
+
+using expr::BinaryOpType;
+using expr::UnaryOpType;
+
+namespace {
+
+using ConstTypes = std::unordered_map<const expr::Expr *, Type>;
+
+// A simplified expression and, if it is a constant, the type it is evaluated
+// in.
+struct Simplified {
+  std::unique_ptr<expr::Expr> expr;
+  boost::optional<Type> constType;
+};
+
+template <typename T> T readConst(const char *data) {
+  T value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+boost::optional<double> getConstValue(const expr::Expr &expr) {
+  const auto *c = expr.getAs<expr::Const>();
+  if (!c) {
+    return boost::none;
+  }
+  const auto &type = c->getType();
+  const auto size = c->getTypeTraits().size;
+  const char *data = c->getData();
+  if ((type == FLOAT || type == HALF) && size == sizeof(float)) {
+    return readConst<float>(data);
+  } else if (type == FLOAT && size == sizeof(double)) {
+    return readConst<double>(data);
+  } else if (type == INT && size == sizeof(int)) {
+    return readConst<int>(data);
+  } else if (type == UNSIGNED_INT && size == sizeof(unsigned)) {
+    return readConst<unsigned>(data);
+  }
+  return boost::none;
+}
+
+bool isConstEqualTo(const Simplified &s, double value) {
+  const auto constValue = getConstValue(*s.expr);
+  return constValue && *constValue == value;
+}
+
+bool isFloatConst(const Simplified &s) {
+  return s.constType && *s.constType == FLOAT && getConstValue(*s.expr);
+}
+
+Simplified makeConst(float value, Type type) {
+  if (type == HALF) {
+    return {expr::ConstHalf(value).clone(), type};
+  }
+  return {expr::Const(value).clone(), type};
+}
+
+// Whether value and its reciprocal are both powers of 2 which can be
+// represented exactly as normal numbers of the type.
+bool hasExactReciprocal(double value, Type type) {
+  int exponent;
+  if (std::fabs(std::frexp(value, &exponent)) != 0.5) {
+    return false;
+  }
+  // value is +/-2^(exponent - 1) and its reciprocal +/-2^(1 - exponent).
+  const int maxExponent = type == FLOAT ? 127 : 15;
+  const int minExponent = 1 - maxExponent;
+  return (type == FLOAT || type == HALF) && exponent - 1 >= minExponent &&
+         exponent - 1 <= maxExponent && 1 - exponent >= minExponent &&
+         1 - exponent <= maxExponent;
+}
+
+boost::optional<float> foldUnary(UnaryOpType op, float x) {
+  switch (op) {
+  case UnaryOpType::NEGATE:
+    return -x;
+  case UnaryOpType::ABSOLUTE:
+    return std::fabs(x);
+  case UnaryOpType::SQUARE:
+    return x * x;
+  default:
+    return boost::none;
+  }
+}
+
+boost::optional<float> foldBinary(BinaryOpType op, float x, float y) {
+  switch (op) {
+  case BinaryOpType::ADD:
+    return x + y;
+  case BinaryOpType::SUBTRACT:
+    return x - y;
+  case BinaryOpType::MULTIPLY:
+    return x * y;
+  case BinaryOpType::DIVIDE:
+    return x / y;
+  default:
+    return boost::none;
+  }
+}
+
+Simplified simplify(const expr::Expr &expr, const ConstTypes &constTypes);
+
+Simplified simplifyUnary(const expr::UnaryOp &u, const ConstTypes &constTypes) {
+  const auto op = u.getOpType();
+  auto arg = simplify(u.getArg(), constTypes);
+
+  if (isFloatConst(arg)) {
+    const auto folded = foldUnary(op, *getConstValue(*arg.expr));
+    if (folded && std::isfinite(*folded)) {
+      return makeConst(*folded, FLOAT);
+    }
+  }
+  if (op == UnaryOpType::NEGATE) {
+    if (const auto *inner = arg.expr->getAs<expr::UnaryOp>()) {
+      if (inner->getOpType() == UnaryOpType::NEGATE) {
+        return {inner->getArg().clone(), boost::none};
+      }
+    }
+  }
+  return {std::unique_ptr<expr::Expr>(new expr::UnaryOp(op, *arg.expr)),
+          boost::none};
+}
+
+Simplified simplifyBinary(const expr::BinaryOp &b,
+                          const ConstTypes &constTypes) {
+  const auto op = b.getOpType();
+  auto lhs = simplify(b.getLHS(), constTypes);
+  auto rhs = simplify(b.getRHS(), constTypes);
+
+  if (isFloatConst(lhs) && isFloatConst(rhs)) {
+    const auto folded = foldBinary(op, *getConstValue(*lhs.expr),
+                                   *getConstValue(*rhs.expr));
+    if (folded && std::isfinite(*folded)) {
+      return makeConst(*folded, FLOAT);
+    }
+  }
+
+  // Adding 0 and subtracting -0 aren't removed as -0 + 0 and -0 - -0 are +0,
+  // and raising to the power of 2 isn't turned into Square as the result of
+  // Pow may be rounded differently.
+  switch (op) {
+  case BinaryOpType::SUBTRACT:
+    if (isConstEqualTo(rhs, 0) && !std::signbit(*getConstValue(*rhs.expr))) {
+      return lhs;
+    }
+    break;
+  case BinaryOpType::MULTIPLY: {
+    if (isConstEqualTo(rhs, 1)) {
+      return lhs;
+    }
+    if (isConstEqualTo(lhs, 1)) {
+      return rhs;
+    }
+    // Negation is only supported for signed types.
+    const auto isSigned = [](const Simplified &s) {
+      return s.constType &&
+             (*s.constType == FLOAT || *s.constType == HALF ||
+              *s.constType == INT);
+    };
+    if (isConstEqualTo(rhs, -1) && isSigned(rhs)) {
+      return {std::unique_ptr<expr::Expr>(new expr::Neg(*lhs.expr)),
+              boost::none};
+    }
+    if (isConstEqualTo(lhs, -1) && isSigned(lhs)) {
+      return {std::unique_ptr<expr::Expr>(new expr::Neg(*rhs.expr)),
+              boost::none};
+    }
+    break;
+  }
+  case BinaryOpType::DIVIDE: {
+    if (isConstEqualTo(rhs, 1)) {
+      return lhs;
+    }
+    const auto divisor = getConstValue(*rhs.expr);
+    if (divisor && rhs.constType &&
+        hasExactReciprocal(*divisor, *rhs.constType)) {
+      const auto reciprocal = makeConst(1 / *divisor, *rhs.constType);
+      return {std::unique_ptr<expr::Expr>(
+                  new expr::Mul(*lhs.expr, *reciprocal.expr)),
+              boost::none};
+    }
+    break;
+  }
+  case BinaryOpType::POWER:
+    if (isConstEqualTo(rhs, 1)) {
+      return lhs;
+    }
+    break;
+  default:
+    break;
+  }
+  return {std::unique_ptr<expr::Expr>(
+              new expr::BinaryOp(op, *lhs.expr, *rhs.expr)),
+          boost::none};
+}
+
+Simplified simplify(const expr::Expr &expr, const ConstTypes &constTypes) {
+  if (expr.isA<expr::Const>()) {
+    const auto match = constTypes.find(&expr);
+    return {expr.clone(), match == constTypes.end()
+                              ? boost::optional<Type>()
+                              : boost::optional<Type>(match->second)};
+  } else if (expr.isA<expr::PlaceHolder>()) {
+    return {expr.clone(), boost::none};
+  } else if (const auto *c = expr.getAs<expr::Cast>()) {
+    auto arg = simplify(c->getLHS(), constTypes);
+    return {std::unique_ptr<expr::Expr>(
+                new expr::Cast(*arg.expr, c->getRHSType())),
+            boost::none};
+  } else if (const auto *u = expr.getAs<expr::UnaryOp>()) {
+    return simplifyUnary(*u, constTypes);
+  } else if (const auto *b = expr.getAs<expr::BinaryOp>()) {
+    return simplifyBinary(*b, constTypes);
+  } else if (const auto *t = expr.getAs<expr::TernaryOp>()) {
+    auto arg0 = simplify(t->getArg0(), constTypes);
+    auto arg1 = simplify(t->getArg1(), constTypes);
+    auto arg2 = simplify(t->getArg2(), constTypes);
+    return {std::unique_ptr<expr::Expr>(new expr::TernaryOp(
+                t->getOpType(), *arg0.expr, *arg1.expr, *arg2.expr)),
+            boost::none};
+  }
+  POPLIB_UNREACHABLE();
+}
+
+} // end anonymous namespace
+
+std::unique_ptr<expr::Expr> simplifyExpr(const expr::Expr &expr,
+                                         const ConstTypes &constTypes) {
+  return simplify(expr, constTypes).expr;
+}
+
+bool dependsOnPlaceholder(const expr::Expr &expr) {
+  if (expr.isA<expr::PlaceHolder>()) {
+    return true;
+  } else if (const auto *c = expr.getAs<expr::Cast>()) {
+    return dependsOnPlaceholder(c->getLHS());
+  } else if (const auto *u = expr.getAs<expr::UnaryOp>()) {
+    return dependsOnPlaceholder(u->getArg());
+  } else if (const auto *b = expr.getAs<expr::BinaryOp>()) {
+    return dependsOnPlaceholder(b->getLHS()) ||
+           dependsOnPlaceholder(b->getRHS());
+  } else if (const auto *t = expr.getAs<expr::TernaryOp>()) {
+    return dependsOnPlaceholder(t->getArg0()) ||
+           dependsOnPlaceholder(t->getArg1()) ||
+           dependsOnPlaceholder(t->getArg2());
+  }
+  return false;
+}
+
+} // namespace popops
@@ -0,0 +1,38 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#ifndef popops_ExprSimplify_hpp
+#define popops_ExprSimplify_hpp
+
+#include <poplar/Type.hpp>
+#include <popops/Expr.hpp>
+
+#include <memory>
+#include <unordered_map>
+
+namespace popops {
+
+// Return an expression which computes the same result as expr with fewer or
+// cheaper operations. constTypes gives the type each constant in expr is
+// evaluated in, as inferred from the tensors the expression is mapped across.
+//
+// The following rewrites are applied, bottom up:
+//  - Add, Sub, Mul, Divide, Neg, Abs and Square of float constants are
+//    evaluated on the host.
+//  - Subtracting 0, multiplying or dividing by 1, raising to the power of 1
+//    and double negation are removed.
+//  - Multiplying by -1 becomes Neg and dividing by a power of 2 becomes
+//    multiplying by its reciprocal, which is exact.
+// Each rewrite gives a bit-identical result, so adding 0 is kept (-0 + 0 is
+// +0) and raising to the power of 2 isn't turned into Square.
+std::unique_ptr<expr::Expr> simplifyExpr(
+    const expr::Expr &expr,
+    const std::unordered_map<const expr::Expr *, poplar::Type> &constTypes);
+
+// Whether the result of the expression depends on a placeholder. The type of
+// the constants in an expression that doesn't depend on one is given by where
+// it is used, so two such identical expressions may have different results
+// and must not be treated as common sub-expressions.
+bool dependsOnPlaceholder(const expr::Expr &expr);
+
+} // namespace popops
+
+#endif // popops_ExprSimplify_hpp
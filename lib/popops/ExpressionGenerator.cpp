@@ -1,10 +1,13 @@
 // Copyright (c) 2019 Graphcore Ltd. All rights reserved.
 #include "ExpressionGenerator.hpp"
 #include "ExprOpUtil.hpp"
+#include "ExprSimplify.hpp"
+#include "FusedCodeletCache.hpp"
 #include "poplibs_support/Compiler.hpp"
 #include "poplibs_support/gcd.hpp"
 #include "popops/ElementWise.hpp"
 #include "popops/ElementWiseUtil.hpp"
+#include "popops/Reduce.hpp"
 #include "poputil/Broadcast.hpp"
 #include "poputil/TileMapping.hpp"
 #include "poputil/Util.hpp"
@@ -155,11 +158,15 @@ std::string getTypeAlias(const std::string &typeAsStr) {
   return str;
 }
 
+// Add the vertices computing the given regions of the outputs on a tile. Each
+// vertex writes its partial reductions to a new element of partials.
 void executeCodelet(Graph &graph, const std::string &codeletName,
-                    std::vector<Tensor> inputs, const Tensor &out,
+                    std::vector<Tensor> inputs, const std::vector<Tensor> &outs,
+                    const std::vector<FusedReduction> &reductions,
                     const std::vector<std::vector<Interval>> &intervals,
                     unsigned tile, const ComputeSet &cs, size_t numFusedOps,
-                    bool vectorizationIsSupported, bool inPlace) {
+                    bool vectorizationIsSupported, bool inPlace,
+                    std::vector<std::vector<Tensor>> &partials) {
   const auto dType = inputs[0].elementType();
   const auto &target = graph.getTarget();
   const auto vectorWidth = target.getVectorWidth(dType);
@@ -167,10 +174,22 @@ void executeCodelet(Graph &graph, const std::string &codeletName,
       std::max<unsigned>(vectorWidth, target.getAtomicStoreGranularity());
   auto vertexRegions =
       splitRegionsBetweenWorkers(target, intervals, grainSize, 2 * grainSize);
-  for (const auto &regions : vertexRegions) {
-    auto v = graph.addVertex(cs, codeletName);
+  if (vertexRegions.empty()) {
+    return;
+  }
 
-    poplar::Tensor outRegions = poplar::concat(out.flatten().slices(regions));
+  std::vector<Tensor> tilePartials;
+  for (unsigned r = 0; r != reductions.size(); ++r) {
+    tilePartials.push_back(
+        graph.addVariable(reductions[r].partialType, {vertexRegions.size()},
+                          codeletName + "/Partials"));
+    graph.setTileMapping(tilePartials.back(), tile);
+    partials[r].push_back(tilePartials.back());
+  }
+
+  for (unsigned vertex = 0; vertex != vertexRegions.size(); ++vertex) {
+    const auto &regions = vertexRegions[vertex];
+    auto v = graph.addVertex(cs, codeletName);
 
     std::vector<poplar::Tensor> inRegions(inputs.size());
 
@@ -192,12 +211,23 @@ void executeCodelet(Graph &graph, const std::string &codeletName,
       estimate += inRegions[i].numElements() % vectorWidth * numFusedOps;
     }
 
-    graph.setCycleEstimate(v, estimate);
+    // The first output is written to in1 if the operation is in place.
+    for (unsigned i = inPlace ? 1 : 0; i < outs.size(); ++i) {
+      const std::string field = i == 0 ? "out" : "out" + std::to_string(i + 1);
+      if (outs[i].numElements() == 1) {
+        graph.connect(v[field], outs[i].reshape({}));
+      } else {
+        graph.connect(v[field], poplar::concat(outs[i].slices(regions)));
+      }
+    }
 
-    if (!inPlace) {
-      graph.connect(v["out"],
-                    out.numElements() == 1 ? out.reshape({}) : outRegions);
+    for (unsigned r = 0; r != reductions.size(); ++r) {
+      graph.connect(v["partial" + std::to_string(r + 1)],
+                    tilePartials[r][vertex]);
+      estimate += inRegions[0].numElements();
     }
+
+    graph.setCycleEstimate(v, estimate);
     graph.setTileMapping(v, tile);
   }
 }
@@ -210,19 +240,31 @@ poplar::Tensor generateAndExecuteMappedOperations(
     Graph &graph, const expr::Expr &expr, const std::vector<Tensor> &inputs,
     std::unordered_map<const expr::Expr *, Type> &constTypes, Sequence &prog,
     bool inPlace, bool allInputsScalar, const std::string &debugPrefix) {
+  return generateAndExecuteMultiMappedOperations(
+             graph, {&expr}, {}, inputs, constTypes, prog, inPlace,
+             allInputsScalar, debugPrefix)
+      .front();
+}
 
-  GenerateCodeletFromMapExpr generate{inPlace, inputs};
+std::vector<poplar::Tensor> generateAndExecuteMultiMappedOperations(
+    Graph &graph, const std::vector<const expr::Expr *> &exprs,
+    const std::vector<FusedReduction> &reductions,
+    const std::vector<Tensor> &inputs,
+    std::unordered_map<const expr::Expr *, Type> &constTypes, Sequence &prog,
+    bool inPlace, bool allInputsScalar, const std::string &debugPrefix) {
 
-  // Traverse the expression tree and based on each node in the tree build up
-  // the body of the map operation in a string format representing the end code.
-  generate.traverseExpressionTree(expr, constTypes);
+  GenerateCodeletFromMapExpr generate{inPlace, inputs, reductions};
 
-  poplar::Type returnType = generate.deduceReturnType();
+  // Traverse each expression tree and based on each node in the tree build up
+  // the body of the map operation in a string format representing the end code.
+  for (const auto *expr : exprs) {
+    generate.traverseExpressionTree(*expr, constTypes);
+  }
 
   // Generate the actual codelet which will be run, compile it, add it to the
   // graph, and store the name of the generated codelet in codeletName.
   std::string codeletName =
-      generate.generateCodelet(graph, allInputsScalar, expr);
+      generate.generateCodelet(graph, allInputsScalar, exprs);
 
   size_t numFusedOp = generate.getNumFusedOps();
 
@@ -245,32 +287,91 @@ poplar::Tensor generateAndExecuteMappedOperations(
     }
   }
 
-  poplar::Tensor out;
+  std::vector<poplar::Tensor> outs;
 
   if (inPlace) {
-    out = inputs[0];
+    outs.push_back(inputs[0]);
   } else {
-    out = createOutputForElementWiseOp(
-        graph, vectorIns.size() == 0 ? inputs : vectorIns, returnType,
-        codeletName + "/Out");
+    outs.push_back(createOutputForElementWiseOp(
+        graph, vectorIns.size() == 0 ? inputs : vectorIns,
+        generate.getResultType(0), codeletName + "/Out"));
+  }
+  // The other outputs are laid out like the first so that each vertex writes
+  // all of its results to the tile it runs on.
+  for (unsigned i = 1; i < exprs.size(); ++i) {
+    outs.push_back(graph.clone(generate.getResultType(i), outs[0],
+                               codeletName + "/Out" + std::to_string(i + 1)));
+  }
+  std::vector<Tensor> outsFlat;
+  outsFlat.reserve(outs.size());
+  for (unsigned i = 0; i < outs.size(); ++i) {
+    outsFlat.push_back(outs[i].flatten());
+    if (i != 0) {
+      asPtr.push_back(&outsFlat[i]);
+    }
   }
-  auto outFlat = out.flatten();
   const auto &target = graph.getTarget();
   const auto numTiles = target.getNumTiles();
   const auto cs = graph.addComputeSet(debugPrefix);
-  graph.reorderToSimplify(&outFlat, asPtr);
-  const auto mapping = graph.getTileMapping(outFlat);
+  graph.reorderToSimplify(&outsFlat[0], asPtr);
+  const auto mapping = graph.getTileMapping(outsFlat[0]);
+  std::vector<std::vector<Tensor>> partials(reductions.size());
   for (auto tile = 0U; tile != numTiles; ++tile) {
     const auto thisTileMap = mapping[tile];
     const auto tileContiguousRegions =
-        graph.getSortedContiguousRegions(outFlat, thisTileMap);
-    executeCodelet(graph, codeletName, flattenedIns, outFlat,
+        graph.getSortedContiguousRegions(outsFlat[0], thisTileMap);
+    executeCodelet(graph, codeletName, flattenedIns, outsFlat, reductions,
                    tileContiguousRegions, tile, cs, numFusedOp,
-                   isVectorizationSupported, inPlace);
+                   isVectorizationSupported, inPlace, partials);
   }
   prog.add(Execute(cs));
 
-  return out;
+  // Reduce the partials of each vertex. The reductions are independent so
+  // their compute sets are shared.
+  std::vector<ComputeSet> css;
+  for (unsigned r = 0; r != reductions.size(); ++r) {
+    const auto &reduction = reductions[r];
+    // The partials of a SQUARE_ADD are already squared.
+    const auto op = reduction.op == popops::Operation::SQUARE_ADD
+                        ? popops::Operation::ADD
+                        : reduction.op;
+    outs.push_back(popops::reduce(
+        graph, poplar::concat(partials[r]),
+        generate.getResultType(reduction.result), {0}, op, css,
+        debugPrefix + "/Reduce" + std::to_string(r + 1)));
+  }
+  for (const auto &reduceCs : css) {
+    prog.add(Execute(reduceCs));
+  }
+
+  return outs;
+}
+
+bool isSupportedFusedReduction(popops::Operation op, poplar::Type type) {
+  if (type != poplar::FLOAT && type != poplar::HALF && type != poplar::INT) {
+    return false;
+  }
+  switch (op) {
+  case popops::Operation::ADD:
+  case popops::Operation::SQUARE_ADD:
+  case popops::Operation::MUL:
+  case popops::Operation::MAX:
+  case popops::Operation::MIN:
+    return true;
+  default:
+    return false;
+  }
+}
+
+poplar::Type getFusedReductionPartialType(popops::Operation op,
+                                          poplar::Type type) {
+  // Sums and products of halves are accumulated in float like the reduction
+  // library does. Maxima and minima are exact in any type.
+  if (type == poplar::HALF && op != popops::Operation::MAX &&
+      op != popops::Operation::MIN) {
+    return poplar::FLOAT;
+  }
+  return type;
 }
 
 // Convert a constant expression into a string representing that constant in
@@ -286,6 +387,29 @@ static bool typeSupportsVectorization(poplar::Type type) {
 void GenerateCodeletFromMapExpr::traverseExpressionTree(
     const expr::Expr &expr,
     std::unordered_map<const expr::Expr *, Type> &constTypes) {
+  traverse(expr, constTypes);
+
+  assert(data.size() == 1 && "Expression traversal left more than one result");
+  results.push_back(data.top());
+  data.pop();
+}
+
+void GenerateCodeletFromMapExpr::traverse(
+    const expr::Expr &expr,
+    std::unordered_map<const expr::Expr *, Type> &constTypes) {
+  // Reuse the variable holding the result of an identical sub-expression
+  // which has already been evaluated.
+  std::string subExprName;
+  if ((expr.isA<expr::UnaryOp>() || expr.isA<expr::BinaryOp>() ||
+       expr.isA<expr::TernaryOp>()) &&
+      dependsOnPlaceholder(expr)) {
+    subExprName = expr.name(inputs);
+    const auto match = subExprs.find(subExprName);
+    if (match != subExprs.end()) {
+      data.push(match->second);
+      return;
+    }
+  }
 
   if (const expr::Const *c = expr.getAs<expr::Const>()) {
 
@@ -305,7 +429,7 @@ void GenerateCodeletFromMapExpr::traverseExpressionTree(
     data.push({variableName, type});
 
   } else if (const expr::Cast *c = expr.getAs<expr::Cast>()) {
-    traverseExpressionTree(c->getLHS(), constTypes);
+    traverse(c->getLHS(), constTypes);
 
     poplar::Type typeCastingTo = c->getRHSType();
     auto pair = data.top();
@@ -343,7 +467,7 @@ void GenerateCodeletFromMapExpr::traverseExpressionTree(
     usedPlaceholders.insert(index);
   } else if (const expr::UnaryOp *u = expr.getAs<expr::UnaryOp>()) {
     numFusedOps++;
-    traverseExpressionTree(u->getArg(), constTypes);
+    traverse(u->getArg(), constTypes);
 
     assert(!data.empty() &&
            "Expression traversal failed in unary op, data is empty");
@@ -384,8 +508,8 @@ void GenerateCodeletFromMapExpr::traverseExpressionTree(
     numFusedOps++;
     auto opType = b->getOpType();
 
-    traverseExpressionTree(b->getRHS(), constTypes);
-    traverseExpressionTree(b->getLHS(), constTypes);
+    traverse(b->getRHS(), constTypes);
+    traverse(b->getLHS(), constTypes);
 
     assert(data.size() >= 2 &&
            "Expression traversal failed in binary op, data is less than 2");
@@ -431,9 +555,9 @@ void GenerateCodeletFromMapExpr::traverseExpressionTree(
     numFusedOps++;
     auto opType = t->getOpType();
 
-    traverseExpressionTree(t->getArg2(), constTypes);
-    traverseExpressionTree(t->getArg1(), constTypes);
-    traverseExpressionTree(t->getArg0(), constTypes);
+    traverse(t->getArg2(), constTypes);
+    traverse(t->getArg1(), constTypes);
+    traverse(t->getArg0(), constTypes);
 
     assert(data.size() >= 3 &&
            "Expression traversal failed in ternary op, data is less than 2");
@@ -490,6 +614,10 @@ void GenerateCodeletFromMapExpr::traverseExpressionTree(
     // The variable name to be used in subsequent iterations.
     initalizers.push(result);
   }
+
+  if (!subExprName.empty()) {
+    subExprs.emplace(subExprName, data.top());
+  }
 }
 
 // Generate the actual codelet.
@@ -621,15 +749,16 @@ void GenerateCodeletFromMapExpr::addVectorizedSection(
     }
   }
 
-  assert(!data.empty() && "Attempting to read data stack which is empty");
-  const std::string outType = getTypeAlias(data.top().second.toString());
-
-  const std::string outString = inPlace ? "in1" : "out";
+  // Add each output as a pointer cast.
+  for (unsigned i = 0; i < results.size(); ++i) {
+    const std::string outType = getTypeAlias(results[i].second.toString());
+    // Add: "{outType} * Out{id} = reinterpret_cast<{outType}*>(&{out}[0]);"
+    stream << outType << " * Out" << std::to_string(i + 1)
+           << " = reinterpret_cast<" << outType << "*>(&" << getOutputName(i)
+           << "[0]);\n";
+  }
 
-  // Add: "{outType} * In{id} = reinterpret_cast<{type}*>({in1/out});"
-  stream << outType << " * Out "
-         << " = reinterpret_cast<" << outType << "*>(&" << outString
-         << "[0]);\n";
+  const std::string outString = getOutputName(0);
 
   stream << "remainder = " << outString << " .size() %"
          << std::to_string(vectorizationWidth)
@@ -658,9 +787,19 @@ void GenerateCodeletFromMapExpr::addVectorizedSection(
   // Each expression is a variable initialization.
   stream << initalizerString;
 
-  assert(!data.empty() && "Attempting to read data stack which is empty");
-  // Add: "ipu::store_postinc(&Out, {result}, 1);"
-  stream << "ipu::store_postinc(&Out," << data.top().first << ",1);\n";
+  // Add: "ipu::store_postinc(&Out{id}, {result}, 1);"
+  for (unsigned i = 0; i < results.size(); ++i) {
+    stream << "ipu::store_postinc(&Out" << std::to_string(i + 1) << ","
+           << results[i].first << ",1);\n";
+  }
+
+  // Accumulate each element of the vectors into the partial reductions.
+  for (unsigned r = 0; r < reductions.size(); ++r) {
+    const auto &result = results[reductions[r].result].first;
+    stream << "for (unsigned j = 0; j != " << vectorizationWidth
+           << "; ++j) {\n"
+           << getAccumulateStatement(r, result + "[j]") << "}\n";
+  }
 
   stream << R"l(
         } // End loop
@@ -711,19 +850,52 @@ void GenerateCodeletFromMapExpr::addSerialSection(
   stream << initalizerString;
 
   // The final assignment of the aggregate of all the operations in
-  // initalizers.
-  if (allInputsScalar) {
-    stream << (inPlace ? "*in1 = " : "*out = ");
-  } else {
-    stream << (inPlace ? "in1[i] = " : "out[i] = ");
+  // initalizers to each output.
+  for (unsigned i = 0; i < results.size(); ++i) {
+    if (allInputsScalar) {
+      stream << "*" << getOutputName(i) << " = ";
+    } else {
+      stream << getOutputName(i) << "[i] = ";
+    }
+    stream << results[i].first << ";\n";
   }
 
-  assert(!data.empty() && "Attempting to read data stack which is empty");
-  stream << data.top().first << ";\n";
+  for (unsigned r = 0; r < reductions.size(); ++r) {
+    stream << getAccumulateStatement(r, results[reductions[r].result].first);
+  }
+}
+
+std::string GenerateCodeletFromMapExpr::getOutputName(unsigned result) const {
+  if (result == 0) {
+    return inPlace ? "in1" : "out";
+  }
+  return "out" + std::to_string(result + 1);
+}
+
+std::string GenerateCodeletFromMapExpr::getAccumulateStatement(
+    unsigned reduction, const std::string &value) const {
+  const auto &r = reductions[reduction];
+  const std::string acc = "acc" + std::to_string(reduction + 1);
+  const std::string x = r.partialType.toString() + "(" + value + ")";
+  switch (r.op) {
+  case popops::Operation::ADD:
+    return acc + " += " + x + ";\n";
+  case popops::Operation::SQUARE_ADD:
+    return acc + " += " + x + " * " + x + ";\n";
+  case popops::Operation::MUL:
+    return acc + " *= " + x + ";\n";
+  case popops::Operation::MAX:
+    return acc + " = max(" + acc + ", " + x + ");\n";
+  case popops::Operation::MIN:
+    return acc + " = min(" + acc + ", " + x + ");\n";
+  default:
+    throw poputil::poplibs_error("Unsupported operation in fused reduction");
+  }
 }
 
 std::string GenerateCodeletFromMapExpr::generateCodelet(
-    poplar::Graph &graph, bool allInputsScalar, const expr::Expr &expr) {
+    poplar::Graph &graph, bool allInputsScalar,
+    const std::vector<const expr::Expr *> &exprs) {
 
   // Each stage of the operation is stored as a variable initalization.
   std::string initalizerString;
@@ -778,7 +950,7 @@ std::string GenerateCodeletFromMapExpr::generateCodelet(
     }
   }
   std::string vertexName =
-      createVertexName(expr, inputs, inPlace, allInputsScalar);
+      createVertexName(exprs, reductions, inputs, inPlace, allInputsScalar);
 
   if (graph.hasCodelet(vertexName)) {
     logging::debug("Codelet already in graph {}", vertexName);
@@ -798,15 +970,25 @@ std::string GenerateCodeletFromMapExpr::generateCodelet(
   // Constructor.
   stream << vertexName << "();\n";
 
-  // The output. Aligned to 8 to support vectorization.
-  if (!inPlace) {
-    assert(!data.empty() && "Attempting to read data stack which is empty");
+  // The outputs. Aligned to 8 to support vectorization. The size of the first
+  // output gives the number of elements to process.
+  for (unsigned i = inPlace ? 1 : 0; i < results.size(); ++i) {
+    const std::string type = results[i].second.toString();
     if (allInputsScalar) {
-      body_stream << "Output<" << data.top().second.toString() << "> out;\n";
+      body_stream << "Output<" << type << ">";
+    } else if (i == 0) {
+      body_stream << "Output<Vector<" << type << ",VectorLayout::SPAN, 8 >>";
     } else {
-      body_stream << "Output<Vector<" << data.top().second.toString()
-                  << ",VectorLayout::SPAN, 8 >> out;\n";
+      body_stream << "Output<Vector<" << type
+                  << ", VectorLayout::ONE_PTR, 8>>";
     }
+    body_stream << " " << getOutputName(i) << ";\n";
+  }
+
+  // The partial reduction of each vertex.
+  for (unsigned r = 0; r < reductions.size(); ++r) {
+    body_stream << "Output<" << reductions[r].partialType.toString()
+                << "> partial" << std::to_string(r + 1) << ";\n";
   }
 
   // The inputs/inplace outputs. Aligned to 8 for vectorization. We generate
@@ -835,6 +1017,22 @@ std::string GenerateCodeletFromMapExpr::generateCodelet(
   body_stream << R"l(
           bool compute() {)l";
 
+  for (unsigned r = 0; r < reductions.size(); ++r) {
+    const auto &reduction = reductions[r];
+    const auto &type = reduction.partialType;
+    std::string identity = "0";
+    const bool isInt = type == poplar::INT;
+    if (reduction.op == popops::Operation::MUL) {
+      identity = "1";
+    } else if (reduction.op == popops::Operation::MAX) {
+      identity = isInt ? "(-2147483647 - 1)" : "-__builtin_inff()";
+    } else if (reduction.op == popops::Operation::MIN) {
+      identity = isInt ? "2147483647" : "__builtin_inff()";
+    }
+    body_stream << "\n" << type.toString() << " acc" << std::to_string(r + 1)
+                << " = " << identity << ";";
+  }
+
   // If we are vectorizing we will need a serial section to calculate the
   // remainder if the vectorization amount doesn't divide evenly.
   if (allInputsScalar) {
@@ -868,13 +1066,21 @@ std::string GenerateCodeletFromMapExpr::generateCodelet(
   stream << R"l(
           }  // End loop
         }// End serial version.
+  )l";
+
+  for (unsigned r = 0; r < reductions.size(); ++r) {
+    const auto id = std::to_string(r + 1);
+    stream << "*partial" << id << " = acc" << id << ";\n";
+  }
+
+  stream << R"l(
       return true;
       }
     };
   )l";
 
   logging::debug("Adding codelet {} to graph", vertexName);
-  graph.addCodelets(stream);
+  addFusedCodelets(graph, stream.str());
 
   return vertexName;
 }
@@ -882,7 +1088,24 @@ std::string GenerateCodeletFromMapExpr::generateCodelet(
 std::string GenerateCodeletFromMapExpr::createVertexName(
     const expr::Expr &expr, const std::vector<poplar::Tensor> &inputs,
     const bool inPlace, const bool allInputsScalar) {
-  std::string result = "Fused_" + expr.name(inputs);
+  return createVertexName({&expr}, {}, inputs, inPlace, allInputsScalar);
+}
+
+std::string GenerateCodeletFromMapExpr::createVertexName(
+    const std::vector<const expr::Expr *> &exprs,
+    const std::vector<FusedReduction> &reductions,
+    const std::vector<poplar::Tensor> &inputs, const bool inPlace,
+    const bool allInputsScalar) {
+  std::string result = "Fused";
+  for (const auto *expr : exprs) {
+    result += "_" + expr->name(inputs);
+  }
+  // The partial type is determined by the operation and the type of the
+  // result so it doesn't need to be part of the name.
+  for (const auto &reduction : reductions) {
+    result += "_Reduce" + std::to_string(static_cast<unsigned>(reduction.op)) +
+              "_" + std::to_string(reduction.result) + "_";
+  }
   result += std::to_string(inPlace);
   result += std::to_string(allInputsScalar);
   for (const auto &input : inputs) {
@@ -5,6 +5,7 @@
 #include <poplar/Program.hpp>
 #include <popops/Expr.hpp>
 #include <popops/ExprOp.hpp>
+#include <popops/Operation.hpp>
 
 #include <set>
 #include <unordered_map>
@@ -25,6 +26,35 @@ poplar::Tensor generateAndExecuteMappedOperations(
     poplar::program::Sequence &prog, bool inPlace, bool allInputsScalar,
     const std::string &debugPrefix = "");
 
+// A partial reduction of one of the results of a generated codelet.
+struct FusedReduction {
+  // The index of the result to reduce.
+  unsigned result;
+  popops::Operation op;
+  // The type each vertex accumulates its partial reduction in.
+  poplar::Type partialType;
+};
+
+// Generate and execute a codelet which computes several expressions in one
+// pass and a partial reduction of their results in each vertex. The partials
+// are then reduced by popops::reduce. Returns the result of each expression
+// followed by each reduction.
+std::vector<poplar::Tensor> generateAndExecuteMultiMappedOperations(
+    poplar::Graph &graph, const std::vector<const expr::Expr *> &exprs,
+    const std::vector<FusedReduction> &reductions,
+    const std::vector<poplar::Tensor> &inputs,
+    std::unordered_map<const expr::Expr *, poplar::Type> &constTypes,
+    poplar::program::Sequence &prog, bool inPlace, bool allInputsScalar,
+    const std::string &debugPrefix = "");
+
+// Whether the generated codelets can accumulate a partial reduction with this
+// operation of a result of this type.
+bool isSupportedFusedReduction(popops::Operation op, poplar::Type type);
+
+// The type the generated codelets accumulate partial reductions in.
+poplar::Type getFusedReductionPartialType(popops::Operation op,
+                                          poplar::Type type);
+
 struct ExprInfo {
   bool isSupported;
   bool allInputsScalar;
@@ -39,21 +69,31 @@ ExprInfo analyseExpr(const expr::Expr &expr,
 class GenerateCodeletFromMapExpr {
 public:
   GenerateCodeletFromMapExpr(bool inPlace_,
-                             const std::vector<poplar::Tensor> &ins)
-      : data(), initalizers(), inputs(ins), numFusedOps(0),
-        vectorizationIsSupported(true), inPlace(inPlace_){};
+                             const std::vector<poplar::Tensor> &ins,
+                             std::vector<FusedReduction> reductions_ = {})
+      : data(), initalizers(), reductions(std::move(reductions_)), inputs(ins),
+        numFusedOps(0), vectorizationIsSupported(true), inPlace(inPlace_){};
 
-  // Traverse the expression tree and populate the data and initalizers fields.
+  // Traverse the expression tree, populate the data and initalizers fields and
+  // add the expression as the next result of the codelet.
   void traverseExpressionTree(
       const expr::Expr &expr,
       std::unordered_map<const expr::Expr *, poplar::Type> &constTypes);
 
-  // Create the codelet, save it to file, register the codelet to poplar, then
-  // remove the file.
+  // Create the codelet and register it to poplar, reusing a compiled version
+  // from the fused codelet cache if possible. exprs are the expressions
+  // traversed, in order.
+  std::string generateCodelet(poplar::Graph &graph, bool allInputsScalar,
+                              const std::vector<const expr::Expr *> &exprs);
+
   std::string generateCodelet(poplar::Graph &graph, bool allInputsScalar,
-                              const expr::Expr &expr);
+                              const expr::Expr &expr) {
+    return generateCodelet(graph, allInputsScalar, {&expr});
+  }
 
-  poplar::Type deduceReturnType() const { return data.top().second; }
+  poplar::Type deduceReturnType() const { return results.front().second; }
+
+  poplar::Type getResultType(unsigned i) const { return results[i].second; }
 
   bool isVectorized() const { return vectorizationIsSupported; }
 
@@ -63,6 +103,19 @@ private:
   // Add the header section (includes, template traits, helper functions).
   void addHeader(std::stringstream &stream);
 
+  // Traverse the expression tree and populate the data and initalizers fields.
+  void traverse(
+      const expr::Expr &expr,
+      std::unordered_map<const expr::Expr *, poplar::Type> &constTypes);
+
+  // The name of the field the result with the given index is written to.
+  std::string getOutputName(unsigned result) const;
+
+  // The statement accumulating value into the partial reduction with the given
+  // index.
+  std::string getAccumulateStatement(unsigned reduction,
+                                     const std::string &value) const;
+
   // Add a vectorized loop to the codelet.
   void addVectorizedSection(std::stringstream &stream,
                             size_t vectorizationWidth,
@@ -81,12 +134,23 @@ private:
   // We include its type as well for deducing the type of the next expression.
   using StringTypePair = std::pair<std::string, poplar::Type>;
 
-  // At the end of the process this will just contain the variable name of the
-  // final result. During the traversal it will contain the intermedate stack
-  // of variable names/constants/placeholders which should be poped from upon
-  // hitting an operation.
+  // During the traversal this will contain the intermedate stack of variable
+  // names/constants/placeholders which should be poped from upon hitting an
+  // operation. At the end of the traversal of an expression it contains just
+  // the variable name of its result, which is moved to results.
   std::stack<StringTypePair> data;
 
+  // The variable name and type of the result of each expression traversed.
+  std::vector<StringTypePair> results;
+
+  // The variable name and type of the result of each sub-expression which
+  // depends on a placeholder, keyed on its name, so that common
+  // sub-expressions are only evaluated once.
+  std::unordered_map<std::string, StringTypePair> subExprs;
+
+  // The partial reductions of the results each vertex computes.
+  std::vector<FusedReduction> reductions;
+
   // Each expression which is executed is converted to a string and stored as
   // an initalizer.
   std::queue<std::string> initalizers;
@@ -133,6 +197,12 @@ public:
                                       const std::vector<poplar::Tensor> &inputs,
                                       const bool inPlace,
                                       const bool allInputsScalar);
+
+  static std::string
+  createVertexName(const std::vector<const expr::Expr *> &exprs,
+                   const std::vector<FusedReduction> &reductions,
+                   const std::vector<poplar::Tensor> &inputs,
+                   const bool inPlace, const bool allInputsScalar);
 };
 } // namespace popops
 
@@ -0,0 +1,157 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#include "FusedCodeletCache.hpp"
+#include "poplibs_support/Fingerprint.hpp"
+#include "poplibs_support/logging.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace poplibs_support;
+namespace fs = boost::filesystem;
+
+namespace popops {
+
+namespace {
+
+// Set when the cache can't be used, so that the problem is only reported once
+// and later codelets don't wait for commands that are going to fail.
+std::atomic<bool> cacheDisabled{false};
+
+void disableCache(const std::string &reason) {
+  if (!cacheDisabled.exchange(true)) {
+    logging::warn("Disabling the fused codelet cache: {}", reason);
+  }
+}
+
+// The popc target to compile codelets for the target with.
+boost::optional<std::string> getPopcTarget(const poplar::Target &target) {
+  switch (target.getTargetType()) {
+  case poplar::TargetType::IPU:
+    return std::string(target.getTargetArchString());
+  case poplar::TargetType::IPU_MODEL:
+  case poplar::TargetType::CPU:
+    return std::string("cpu");
+  default:
+    return boost::none;
+  }
+}
+
+std::string shellQuote(const std::string &s) {
+  std::string quoted = "'";
+  for (const auto c : s) {
+    if (c == '\'') {
+      quoted += "'\\''";
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "'";
+}
+
+// Run a command and return what it writes to stdout, or none if it fails.
+boost::optional<std::string> runCommand(const std::string &command) {
+  auto *pipe = popen(command.c_str(), "r");
+  if (!pipe) {
+    return boost::none;
+  }
+  std::string output;
+  char buffer[256];
+  while (const auto n = std::fread(buffer, 1, sizeof(buffer), pipe)) {
+    output.append(buffer, n);
+  }
+  if (pclose(pipe) != 0) {
+    return boost::none;
+  }
+  return output;
+}
+
+// The compiled codelets depend on the version of the compiler, so it is part
+// of the key of the cache. It is only queried once per process.
+const boost::optional<std::string> &getPopcVersion() {
+  static const auto version = runCommand("popc --version 2>/dev/null");
+  return version;
+}
+
+bool compileCodelets(const std::string &source, const std::string &popcTarget,
+                     const fs::path &dir, const fs::path &objectPath) {
+  boost::system::error_code ec;
+  fs::create_directories(dir, ec);
+  if (ec) {
+    disableCache("can't create " + dir.string() + ": " + ec.message());
+    return false;
+  }
+  // Compile into a uniquely named file and rename it into place so that
+  // other processes never see a partially written file.
+  const auto tempPath = dir / fs::unique_path("tmp-%%%%-%%%%-%%%%-%%%%");
+  const auto sourcePath = tempPath.string() + ".cpp";
+  const auto tempObjectPath = tempPath.string() + ".gp";
+  std::ofstream(sourcePath) << source;
+  // No flags are passed so that the codelets are compiled with the same
+  // default flags as codelets added to a graph from source.
+  const auto command = "popc --target " + popcTarget + " -o " +
+                       shellQuote(tempObjectPath) + " " +
+                       shellQuote(sourcePath);
+  const bool compiled = std::system(command.c_str()) == 0;
+  fs::remove(sourcePath, ec);
+  if (compiled) {
+    fs::rename(tempObjectPath, objectPath, ec);
+  }
+  if (!compiled || ec) {
+    fs::remove(tempObjectPath, ec);
+    disableCache("failed to compile codelets with '" + command + "'");
+    return false;
+  }
+  return true;
+}
+
+bool addCachedCodelets(poplar::Graph &graph, const std::string &source,
+                       const fs::path &dir) {
+  const auto popcTarget = getPopcTarget(graph.getTarget());
+  if (!popcTarget) {
+    return false;
+  }
+  const auto &popcVersion = getPopcVersion();
+  if (!popcVersion) {
+    disableCache("popc could not be run");
+    return false;
+  }
+  Fingerprint fingerprint;
+  fingerprint.add(source).add(*popcTarget).add(*popcVersion);
+  std::stringstream fileName;
+  fileName << std::hex << std::setfill('0') << std::setw(16)
+           << fingerprint.get() << ".gp";
+  const auto objectPath = dir / fileName.str();
+
+  boost::system::error_code ec;
+  if (fs::exists(objectPath, ec)) {
+    logging::debug("Adding cached fused codelets {}", objectPath.string());
+  } else {
+    if (!compileCodelets(source, *popcTarget, dir, objectPath)) {
+      return false;
+    }
+    logging::debug("Compiled fused codelets into {}", objectPath.string());
+  }
+  graph.addCodelets(objectPath.string());
+  return true;
+}
+
+} // end anonymous namespace
+
+void addFusedCodelets(poplar::Graph &graph, const std::string &source) {
+  const auto dir = std::getenv(fusedCodeletCacheEnvVar);
+  if (dir && *dir && !cacheDisabled &&
+      addCachedCodelets(graph, source, fs::path(dir))) {
+    return;
+  }
+  std::stringstream stream(source);
+  graph.addCodelets(stream);
+}
+
+} // namespace popops
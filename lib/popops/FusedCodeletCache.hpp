@@ -0,0 +1,27 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#ifndef popops_FusedCodeletCache_hpp
+#define popops_FusedCodeletCache_hpp
+
+#include <poplar/Graph.hpp>
+
+#include <string>
+
+namespace popops {
+
+// The environment variable naming the directory of the fused codelet cache.
+constexpr const char *fusedCodeletCacheEnvVar = "POPLIBS_FUSED_CODELET_CACHE";
+
+// Add the codelets defined in source to the graph.
+//
+// If the fused codelet cache is enabled the source is compiled with popc into
+// the cache directory, in a file named after a fingerprint of the source, the
+// target and the version of popc. Later calls with the same source, from any
+// graph or process, add the compiled file instead of compiling the source
+// again. If the cache is disabled or the codelets can't be compiled with popc
+// the source is added to the graph directly. The codelets are compiled with
+// the default flags either way.
+void addFusedCodelets(poplar::Graph &graph, const std::string &source);
+
+} // namespace popops
+
+#endif // popops_FusedCodeletCache_hpp
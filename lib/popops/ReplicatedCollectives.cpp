@@ -5,6 +5,7 @@
 #include "CollectivesProgram.hpp"
 #include "poplibs_support/Compiler.hpp"
 #include "poplibs_support/logging.hpp"
+#include "popops/Cast.hpp"
 #include "popops/DynamicSlice.hpp"
 #include "popops/ElementWise.hpp"
 #include "popops/Pad.hpp"
@@ -15,7 +16,11 @@
 #include "poputil/exceptions.hpp"
 #include <boost/dll.hpp>
 #include <boost/optional/optional.hpp>
+#include <algorithm>
 #include <cassert>
+#include <map>
+#include <string>
+#include <vector>
 
 using namespace poplar;
 using namespace poplar::program;
@@ -51,6 +56,13 @@ enum class CollectiveMethod {
 struct CollectiveOptions {
   CollectiveMethod method = CollectiveMethod::AUTO;
   bool useReplicatedImplementation = false;
+  // The type to exchange float data in, if not the type of the data.
+  boost::optional<Type> exchangeType;
+};
+
+struct AllReduceManyOptions {
+  // The target size of each bucket in bytes.
+  unsigned bucketSize = 1024 * 1024;
 };
 
 } // End anonymous namespace.
@@ -222,12 +234,28 @@ static void parseCollectiveOptions(const poplar::OptionFlags &optionFlags,
              CollectiveMethod::BIDIRECTIONAL_RING_PAIR},
             {"meet_in_middle_ring", CollectiveMethod::MEET_IN_MIDDLE_RING}})},
       {"useReplicatedImplementation",
-       OptionHandler::createWithBool(options.useReplicatedImplementation)}};
+       OptionHandler::createWithBool(options.useReplicatedImplementation)},
+      {"exchangeType",
+       OptionHandler::createWithEnum(
+           options.exchangeType,
+           std::map<std::string, boost::optional<Type>>{
+               {"float", Type(FLOAT)}, {"half", Type(HALF)}})}};
   for (const auto &entry : optionFlags) {
     spec.parse(entry.first, entry.second);
   }
 }
 
+// The type to exchange data of the given type in. Only float data can be
+// exchanged in a smaller type.
+static Type getExchangeType(const CollectiveOptions &options,
+                            const Type &dataType) {
+  if (options.exchangeType && dataType == FLOAT &&
+      *options.exchangeType == HALF) {
+    return HALF;
+  }
+  return dataType;
+}
+
 // All the operations in the all reduce (splitIntoFragments and
 // concat model parallel chunks) aim to preserve the order of the tensor
 // on the ipu and only perform transforms of elements on different ipus.
@@ -507,10 +535,15 @@ static Tensor initRingIndexTensor(Graph &graph, const Direction direction,
 // the offset is so that the meet in the middle method can start at part
 // way through the iterations. can be positive or negative so that the same
 // number can be used to initialise the clockwise and anticlockwise ring
+//
+// The data is sent in the exchange type. If this is smaller than the type of
+// the data it is cast to after each reduction and the data received is
+// cast back to be reduced in the type of the data.
 static CollectivesProgram unidirectionalRingReduceScatter(
     Graph &graph, const Tensor &toReduce, popops::Operation op,
-    Direction direction, const std::string &debugPrefix,
-    const unsigned numSteps, const int startOffset = 0) {
+    const Type &exchangeType, Direction direction,
+    const std::string &debugPrefix, const unsigned numSteps,
+    const int startOffset = 0) {
   logging::debug("Unidirectional ring reduce scatter");
 
   const auto replicationFactor = graph.getReplicationFactor();
@@ -522,7 +555,12 @@ static CollectivesProgram unidirectionalRingReduceScatter(
   auto srcBuffer = graph.addVariable(toReduce.elementType(), {fragmentSize},
                                      debugPrefix + "/ScatterSrc");
   mapBuffer(graph, srcBuffer, fragments);
-  auto dstBuffer = graph.clone(srcBuffer, debugPrefix + "/ScatterDst");
+  auto dstBuffer =
+      graph.clone(exchangeType, srcBuffer, debugPrefix + "/ScatterDst");
+  boost::optional<Tensor> sendBuffer;
+  if (exchangeType != toReduce.elementType()) {
+    sendBuffer = graph.clone(dstBuffer, debugPrefix + "/ScatterSend");
+  }
   auto repFactorTensor = graph.addReplicationIndexConstant();
 
   // Map index tensor to IPU involved in this collective program
@@ -554,7 +592,7 @@ static CollectivesProgram unidirectionalRingReduceScatter(
   // create the cross replica copy the collective needs
   program.exchangeProg.setCopy(
       crossReplicaCopy(
-          graph, srcBuffer, dstBuffer,
+          graph, sendBuffer ? sendBuffer.get() : srcBuffer, dstBuffer,
           [&](unsigned src) { return ring.getRank(src, direction, 1); }),
       direction);
   // Create program that will do a dynamic slice with index being the
@@ -563,9 +601,12 @@ static CollectivesProgram unidirectionalRingReduceScatter(
   replicatedRankSlice(program.sliceFragments, graph, fragments, srcBuffer, ring,
                       direction);
   // perform the reduction with the received data and the value sliced
-  program.reduceProg =
-      ReduceProg(srcBuffer, dstBuffer, op, debugPrefix + "/Reduce");
-  program.undefTensor = concat({srcBuffer, dstBuffer});
+  program.reduceProg = ReduceProg(srcBuffer, dstBuffer, op,
+                                  debugPrefix + "/Reduce", sendBuffer);
+  program.undefTensors = {srcBuffer, dstBuffer};
+  if (sendBuffer) {
+    program.undefTensors.push_back(sendBuffer.get());
+  }
   program.srcBuffer = std::move(srcBuffer);
   program.dstBuffer = std::move(dstBuffer);
   logging::debug("Unidirectional ring reduce scatter end");
@@ -574,7 +615,8 @@ static CollectivesProgram unidirectionalRingReduceScatter(
 
 static Tensor
 bidirectionalRingPairReduceScatter(Graph &graph, const Tensor &toReduce,
-                                   popops::Operation op, Sequence &prog,
+                                   popops::Operation op,
+                                   const Type &exchangeType, Sequence &prog,
                                    const std::string &debugPrefix) {
   // split to reduce in half and call the clockwise and anticlockwise on
   // each. The bidirectionalSequence function will then interleave the
@@ -593,11 +635,13 @@ bidirectionalRingPairReduceScatter(Graph &graph, const Tensor &toReduce,
   auto anticlockwiseFragments =
       fragments.slice(fragmentSize / 2, fragmentSize, 1);
   auto clockwiseProg = unidirectionalRingReduceScatter(
-      graph, clockwiseFragments.flatten(), op, Direction::CLOCKWISE,
-      debugPrefix + "/clockwise", graph.getReplicationFactor());
+      graph, clockwiseFragments.flatten(), op, exchangeType,
+      Direction::CLOCKWISE, debugPrefix + "/clockwise",
+      graph.getReplicationFactor());
   auto anticlockwiseProg = unidirectionalRingReduceScatter(
-      graph, anticlockwiseFragments.flatten(), op, Direction::ANTICLOCKWISE,
-      debugPrefix + "/anticlockwise", graph.getReplicationFactor());
+      graph, anticlockwiseFragments.flatten(), op, exchangeType,
+      Direction::ANTICLOCKWISE, debugPrefix + "/anticlockwise",
+      graph.getReplicationFactor());
   prog.add(bidirectionalSequence(clockwiseProg, anticlockwiseProg, graph));
   auto srcBuffer =
       concat(clockwiseProg.srcBuffer.get(), anticlockwiseProg.srcBuffer.get());
@@ -607,13 +651,15 @@ bidirectionalRingPairReduceScatter(Graph &graph, const Tensor &toReduce,
 static Tensor ringMeetInMiddleReduceScatter(Graph &graph,
                                             const Tensor &toReduce,
                                             popops::Operation op,
+                                            const Type &exchangeType,
                                             Sequence &prog,
                                             const std::string &debugPrefix) {
   logging::debug("Meet in the middle reduce scatter");
   const auto replicationFactor = graph.getReplicationFactor();
   if (replicationFactor <= 2) {
     auto program = unidirectionalRingReduceScatter(
-        graph, toReduce, op, CLOCKWISE, debugPrefix, replicationFactor);
+        graph, toReduce, op, exchangeType, CLOCKWISE, debugPrefix,
+        replicationFactor);
     prog.add(unidirectionalSequence(program, graph));
     return program.srcBuffer.get();
   }
@@ -625,10 +671,10 @@ static Tensor ringMeetInMiddleReduceScatter(Graph &graph,
   auto fragments = replicatedSplitIntoFragments(toReduce, numFragments, graph);
 
   auto clockwiseProg = unidirectionalRingReduceScatter(
-      graph, toReduce, op, Direction::CLOCKWISE, debugPrefix + "/clockwise",
-      numSteps, clockwiseOffset);
+      graph, toReduce, op, exchangeType, Direction::CLOCKWISE,
+      debugPrefix + "/clockwise", numSteps, clockwiseOffset);
   auto anticlockwiseProg = unidirectionalRingReduceScatter(
-      graph, toReduce, op, Direction::ANTICLOCKWISE,
+      graph, toReduce, op, exchangeType, Direction::ANTICLOCKWISE,
       debugPrefix + "/anticlockwise", numSteps - 1, anticlockwiseOffset);
 
   unsigned topLevelControlTile =
@@ -656,13 +702,18 @@ static Tensor internalReduceScatter(Graph &graph, const Tensor &toReduce,
   if (method == CollectiveMethod::AUTO) {
     method = pickReduceScatterMethod(graph, toReduce, op);
   }
+  const auto exchangeType = getExchangeType(options, toReduce.elementType());
+  if (exchangeType != toReduce.elementType()) {
+    logging::debug("Reduce scatter exchanges {} data as {}",
+                   toReduce.elementType(), exchangeType);
+  }
   switch (method) {
   default:
     assert(0 && "Unexpected reduce method");
   case CollectiveMethod::CLOCKWISE_RING: {
     logging::debug("Reduce scatter collective method is clockwise ring");
     auto program = unidirectionalRingReduceScatter(
-        graph, toReduce, op, CLOCKWISE, debugPrefix,
+        graph, toReduce, op, exchangeType, CLOCKWISE, debugPrefix,
         graph.getReplicationFactor());
     prog.add(unidirectionalSequence(program, graph));
     return program.srcBuffer.get();
@@ -670,21 +721,21 @@ static Tensor internalReduceScatter(Graph &graph, const Tensor &toReduce,
   case CollectiveMethod::ANTICLOCKWISE_RING: {
     logging::debug("reduce scatter collective method is anti-clockwise ring");
     auto program = unidirectionalRingReduceScatter(
-        graph, toReduce, op, ANTICLOCKWISE, debugPrefix,
+        graph, toReduce, op, exchangeType, ANTICLOCKWISE, debugPrefix,
         graph.getReplicationFactor());
     prog.add(unidirectionalSequence(program, graph));
     return program.srcBuffer.get();
   }
   case CollectiveMethod::BIDIRECTIONAL_RING_PAIR: {
     logging::debug("Reduce scatter collective method is Bidirectional ring");
-    return bidirectionalRingPairReduceScatter(graph, toReduce, op, prog,
-                                              debugPrefix);
+    return bidirectionalRingPairReduceScatter(graph, toReduce, op,
+                                              exchangeType, prog, debugPrefix);
   }
   case CollectiveMethod::MEET_IN_MIDDLE_RING: {
     logging::debug("Reduce scatter collective "
                    "method is Meet in the middle ring");
-    return ringMeetInMiddleReduceScatter(graph, toReduce, op, prog,
-                                         debugPrefix);
+    return ringMeetInMiddleReduceScatter(graph, toReduce, op, exchangeType,
+                                         prog, debugPrefix);
   }
   }
 }
@@ -774,7 +825,7 @@ static CollectivesProgram unidirectionalRingAllGather(
   program.allgatherCopy.add(Copy(dstBuffer, srcBuffer));
   replicatedRankUpdate(program.sliceFragments, graph, srcBuffer, fragments,
                        ring, direction);
-  program.undefTensor = concat({paddedResult, srcBuffer, dstBuffer});
+  program.undefTensors = {concat({paddedResult, srcBuffer, dstBuffer})};
   return program;
 }
 
@@ -980,8 +1031,23 @@ static void noCheckReplicatedAllReduce(Graph &graph, const poplar::Tensor &data,
     logging::debug("Using replicated version of allReduce");
     auto reduceScattered = internalReduceScatter(graph, dataReordered, op, prog,
                                                  debugPrefix, options);
-    allGather(graph, reduceScattered, resultReordered, prog, debugPrefix,
-              options);
+    const auto exchangeType =
+        getExchangeType(options, dataReordered.elementType());
+    if (exchangeType != dataReordered.elementType()) {
+      // Gather the result in the exchange type too. Every replica casts the
+      // data it reduced in the same way, so the results are the same on
+      // all replicas.
+      auto compressed = popops::cast(graph, reduceScattered, exchangeType, prog,
+                                     debugPrefix + "/Compress");
+      auto gathered = graph.clone(exchangeType, resultReordered,
+                                  debugPrefix + "/Gathered");
+      allGather(graph, compressed, gathered, prog, debugPrefix, options);
+      prog.add(popops::cast(graph, gathered, resultReordered,
+                            debugPrefix + "/Decompress"));
+    } else {
+      allGather(graph, reduceScattered, resultReordered, prog, debugPrefix,
+                options);
+    }
   } else {
     if (topLevelReplicationFactor > 1) {
       throw poputil::poplibs_error("Can't use non replicated collective "
@@ -1100,6 +1166,97 @@ Tensor ReplicatedCollectives::replicatedAllReduce(
   return replicatedAllReduce(graph, data, op, prog, debugPrefix, optionFlags);
 }
 
+// Parse the options of replicatedAllReduceMany() and return the remaining
+// options, which are passed to the all-reduce of each bucket.
+static poplar::OptionFlags
+parseAllReduceManyOptions(const poplar::OptionFlags &optionFlags,
+                          AllReduceManyOptions &options) {
+  using poplibs::OptionHandler;
+  using poplibs::OptionSpec;
+  const OptionSpec spec{
+      {"bucketSize", OptionHandler::createWithInteger(options.bucketSize)}};
+  poplar::OptionFlags allReduceOptions;
+  for (const auto &entry : optionFlags) {
+    if (entry.first == "bucketSize") {
+      spec.parse(entry.first, entry.second);
+    } else {
+      allReduceOptions.set(entry.first, entry.second);
+    }
+  }
+  if (options.bucketSize == 0) {
+    throw poputil::poplibs_error("bucketSize must be greater than 0");
+  }
+  return allReduceOptions;
+}
+
+std::vector<Tensor>
+replicatedAllReduceMany(Graph &graph, const std::vector<Tensor> &data,
+                        popops::Operation op, program::Sequence &prog,
+                        const std::string &debugPrefix,
+                        const poplar::OptionFlags &optionFlags) {
+  logging::info("replicatedAllReduceMany tensors={}, op={}, name={}",
+                data.size(), op, debugPrefix);
+  AllReduceManyOptions options;
+  const auto allReduceOptions =
+      parseAllReduceManyOptions(optionFlags, options);
+
+  // Clone each tensor for its result so the result of a bucket has the same
+  // IPU mapping as its input and the all-reduce doesn't need to copy it.
+  std::vector<Tensor> results;
+  results.reserve(data.size());
+  for (unsigned i = 0; i != data.size(); ++i) {
+    results.push_back(graph.clone(data[i], debugPrefix + "/result" +
+                                               std::to_string(i)));
+  }
+
+  struct Bucket {
+    std::vector<Tensor> data;
+    std::vector<Tensor> results;
+    std::size_t bytes = 0;
+  };
+  unsigned numBuckets = 0;
+  const auto allReduceBucket = [&](Bucket &bucket) {
+    if (bucket.data.empty()) {
+      return;
+    }
+    logging::debug("All reduce bucket {} of {} tensors ({}B)", numBuckets,
+                   bucket.data.size(), bucket.bytes);
+    auto result = concat(bucket.results);
+    replicatedAllReduceWithOutput(
+        graph, concat(bucket.data), result, op, prog,
+        debugPrefix + "/bucket" + std::to_string(numBuckets++),
+        allReduceOptions);
+    bucket = Bucket();
+  };
+
+  // Tensors can only be concatenated with tensors of the same type, so there
+  // is an open bucket for each type.
+  std::map<Type, Bucket> buckets;
+  const auto &target = graph.getTarget();
+  for (unsigned i = 0; i != data.size(); ++i) {
+    if (data[i].numElements() == 0) {
+      continue;
+    }
+    const auto type = data[i].elementType();
+    const auto bytes = data[i].numElements() * target.getTypeSize(type);
+    auto &bucket = buckets[type];
+    if (bytes >= options.bucketSize) {
+      // Reduce a tensor of at least the target size in its own bucket.
+      allReduceBucket(bucket);
+    }
+    bucket.data.push_back(data[i].flatten());
+    bucket.results.push_back(results[i].flatten());
+    bucket.bytes += bytes;
+    if (bucket.bytes >= options.bucketSize) {
+      allReduceBucket(bucket);
+    }
+  }
+  for (auto &entry : buckets) {
+    allReduceBucket(entry.second);
+  }
+  return results;
+}
+
 static std::vector<std::map<unsigned, unsigned>>
 createCommunicationMap(unsigned replicationFactor) {
   std::vector<std::map<unsigned, unsigned>> communicationMap;
@@ -5,14 +5,57 @@
 #include <poplibs_support/Algorithms.hpp>
 #include <popops/ElementWise.hpp>
 #include <popops/Reduce.hpp>
+#include <poputil/OptionParsing.hpp>
 #include <poputil/VertexTemplates.hpp>
 #include <poputil/exceptions.hpp>
 
+#include <boost/optional.hpp>
+
 #include <algorithm>
+#include <map>
+#include <string>
 
 namespace popops {
 namespace {
 
+enum class SortAlgorithm {
+  // Sort each interval, then repeatedly exchange the elements at the edges of
+  // neighbouring intervals and sort the intervals again until all the edges
+  // are in order.
+  ODD_EVEN_TRANSPOSITION,
+  // Sort each interval, then merge and split pairs of intervals following
+  // Batcher's merge exchange sorting network.
+  MERGE_EXCHANGE,
+};
+
+struct SortOptions {
+  SortAlgorithm algorithm = SortAlgorithm::ODD_EVEN_TRANSPOSITION;
+};
+
+SortOptions parseSortOptions(const poplar::OptionFlags &optionFlags) {
+  SortOptions options;
+
+  using poplibs::OptionHandler;
+  using poplibs::OptionSpec;
+
+  /*
+   * Any changes to spec must be reflected in the documentation comment in
+   * the header.
+   */
+  const OptionSpec spec{
+      {"algorithm",
+       OptionHandler::createWithEnum(
+           options.algorithm,
+           {{"oddEvenTransposition", SortAlgorithm::ODD_EVEN_TRANSPOSITION},
+            {"mergeExchange", SortAlgorithm::MERGE_EXCHANGE}})}};
+
+  for (const auto &entry : optionFlags) {
+    spec.parse(entry.first, entry.second);
+  }
+
+  return options;
+}
+
 poplar::program::Program swap(poplar::Graph &graph, poplar::Tensor a,
                               poplar::Tensor b) {
   poplar::program::Sequence result;
@@ -238,29 +281,268 @@ poplar::program::Sequence createOddExchange(poplar::Graph &graph,
   return createExchange(graph, key, value, 1);
 }
 
+using Comparator = std::pair<std::size_t, std::size_t>;
+
+// The comparators of Batcher's merge exchange sorting network for n elements
+// (Knuth, The Art of Computer Programming, vol. 3, algorithm 5.2.2M), grouped
+// into rounds. The comparators in a round don't share elements so they can be
+// applied in parallel. There are t(t + 1) / 2 rounds, where t = ceil(log2(n)).
+std::vector<std::vector<Comparator>> mergeExchangeRounds(std::size_t n) {
+  std::vector<std::vector<Comparator>> rounds;
+  if (n < 2) {
+    return rounds;
+  }
+  std::size_t t = 0;
+  while ((std::size_t(1) << t) < n) {
+    ++t;
+  }
+  for (std::size_t p = std::size_t(1) << (t - 1); p != 0; p >>= 1) {
+    std::size_t q = std::size_t(1) << (t - 1);
+    std::size_t r = 0;
+    std::size_t d = p;
+    while (true) {
+      std::vector<Comparator> round;
+      for (std::size_t i = 0; i + d < n; ++i) {
+        if ((i & p) == r) {
+          round.emplace_back(i, i + d);
+        }
+      }
+      if (!round.empty()) {
+        rounds.push_back(std::move(round));
+      }
+      if (q == p) {
+        break;
+      }
+      d = q - p;
+      q >>= 1;
+      r = p;
+    }
+  }
+  return rounds;
+}
+
+std::string mergeSplitVertex(poplar::Type a) {
+  return poputil::templateVertex("popops::MergeSplitVertex", a);
+}
+
+std::string mergeSplitVertex(poplar::Type a, poplar::Type b) {
+  return poputil::templateVertex("popops::MergeSplitVertexKV", a, b);
+}
+
+// The programs which apply one round of the sorting network to every row.
+struct MergeRound {
+  std::vector<poplar::Tensor> src;
+  std::vector<poplar::Tensor> dst;
+  poplar::ComputeSet cs;
+};
+
+// Sort each row of the 2D key tensor, and the value tensor along with it if
+// there is one, with a fixed number of steps.
+//
+// Each interval of a row mapped to a tile is sorted and becomes a block of the
+// sorting network. Every comparator of the network is replaced by a pair of
+// vertices, on the tiles of its blocks, which merge copies of both blocks. The
+// vertex on the tile of the first block keeps the lowest elements and the
+// vertex on the tile of the second block keeps the highest. The blocks are
+// padded to the size of the largest interval of the row, with a count of the
+// elements which aren't padding, so that this sorts the row whatever the sizes
+// of the intervals. Once sorted the row is copied from the blocks back into
+// the key tensor, which is a static copy as every block other than the last
+// non-empty one is full.
+void mergeExchangeSort(poplar::Graph &graph, const poplar::Tensor &key,
+                       const boost::optional<poplar::Tensor> &value,
+                       poplar::program::Sequence &prog,
+                       const std::string &debugPrefix) {
+  const auto sortCS = value ? sortSlice(graph, key, *value, debugPrefix)
+                            : sortSlice(graph, key, debugPrefix);
+  prog.add(poplar::program::Execute(sortCS));
+
+  const auto vertexType =
+      value ? mergeSplitVertex(key.elementType(), value->elementType())
+            : mergeSplitVertex(key.elementType());
+
+  std::vector<poplar::Tensor> initSrc, initDst, resultSrc, resultDst;
+  std::vector<MergeRound> rounds;
+  for (std::size_t i = 0; i < key.dim(0); ++i) {
+    const auto tileIntervals = graph.getTileMapping(key[i]);
+    std::vector<std::pair<poplar::Interval, unsigned>> blocks;
+    for (unsigned tile = 0; tile < tileIntervals.size(); ++tile) {
+      for (const auto &interval : tileIntervals[tile]) {
+        if (intervalNotEmpty(interval)) {
+          blocks.emplace_back(interval, tile);
+        }
+      }
+    }
+    std::sort(blocks.begin(), blocks.end(),
+              [](const std::pair<poplar::Interval, unsigned> &a,
+                 const std::pair<poplar::Interval, unsigned> &b) {
+                return intervalComp(a.first, b.first);
+              });
+    const auto numBlocks = blocks.size();
+    if (numBlocks < 2) {
+      continue;
+    }
+
+    std::size_t blockSize = 0;
+    std::vector<unsigned> initialCounts;
+    for (const auto &block : blocks) {
+      blockSize = std::max(blockSize, block.first.size());
+      initialCounts.push_back(block.first.size());
+    }
+
+    // The blocks of keys, values and the number of elements in each block.
+    std::vector<poplar::Tensor> buffers = {graph.addVariable(
+        key.elementType(), {numBlocks, blockSize}, debugPrefix + "/keys")};
+    if (value) {
+      buffers.push_back(graph.addVariable(value->elementType(),
+                                          {numBlocks, blockSize},
+                                          debugPrefix + "/values"));
+    }
+    auto counts = graph.addVariable(poplar::UNSIGNED_INT, {numBlocks},
+                                    debugPrefix + "/counts");
+    auto initialCountsConst = graph.addConstant(
+        poplar::UNSIGNED_INT, {numBlocks}, initialCounts.data(),
+        debugPrefix + "/initialCounts");
+    for (std::size_t b = 0; b < numBlocks; ++b) {
+      const auto tile = blocks[b].second;
+      for (const auto &buffer : buffers) {
+        graph.setTileMapping(buffer[b], tile);
+      }
+      graph.setTileMapping(counts[b], tile);
+      graph.setTileMapping(initialCountsConst[b], tile);
+    }
+
+    const std::vector<poplar::Tensor> slices =
+        value ? std::vector<poplar::Tensor>{key[i], (*value)[i]}
+              : std::vector<poplar::Tensor>{key[i]};
+    for (std::size_t k = 0; k < slices.size(); ++k) {
+      for (std::size_t b = 0; b < numBlocks; ++b) {
+        const auto &interval = blocks[b].first;
+        initSrc.push_back(slices[k].slice(interval));
+        initDst.push_back(buffers[k][b].slice(0, interval.size()));
+      }
+      resultSrc.push_back(buffers[k].flatten().slice(0, slices[k].dim(0)));
+      resultDst.push_back(slices[k]);
+    }
+    initSrc.push_back(initialCountsConst);
+    initDst.push_back(counts);
+
+    const auto network = mergeExchangeRounds(numBlocks);
+    for (std::size_t r = 0; r < network.size(); ++r) {
+      if (rounds.size() == r) {
+        rounds.push_back({{},
+                          {},
+                          graph.addComputeSet(debugPrefix + "/mergeRound" +
+                                              std::to_string(r))});
+      }
+      auto &round = rounds[r];
+      for (const auto &comparator : network[r]) {
+        const std::size_t pairBlocks[] = {comparator.first, comparator.second};
+        for (unsigned side = 0; side < 2; ++side) {
+          const auto tile = blocks[pairBlocks[side]].second;
+          // Both blocks are copied to the tile of each side, as the vertex
+          // writes its block while reading it.
+          auto v = graph.addVertex(round.cs, vertexType);
+          graph.setTileMapping(v, tile);
+          graph.setInitialValue(v["keepLower"], side == 0);
+          for (std::size_t k = 0; k < buffers.size(); ++k) {
+            const auto &buffer = buffers[k];
+            auto lower = graph.clone(buffer[pairBlocks[0]]);
+            auto upper = graph.clone(buffer[pairBlocks[1]]);
+            graph.setTileMapping(lower, tile);
+            graph.setTileMapping(upper, tile);
+            round.src.push_back(buffer[pairBlocks[0]]);
+            round.dst.push_back(lower);
+            round.src.push_back(buffer[pairBlocks[1]]);
+            round.dst.push_back(upper);
+            if (!value) {
+              graph.connect(v["lower"], lower);
+              graph.connect(v["upper"], upper);
+              graph.connect(v["out"], buffer[pairBlocks[side]]);
+            } else if (k == 0) {
+              graph.connect(v["lowerKey"], lower);
+              graph.connect(v["upperKey"], upper);
+              graph.connect(v["key"], buffer[pairBlocks[side]]);
+            } else {
+              graph.connect(v["lowerValue"], lower);
+              graph.connect(v["upperValue"], upper);
+              graph.connect(v["value"], buffer[pairBlocks[side]]);
+            }
+          }
+          auto blockCounts = graph.addVariable(poplar::UNSIGNED_INT, {2},
+                                               debugPrefix + "/blockCounts");
+          graph.setTileMapping(blockCounts, tile);
+          round.src.push_back(counts[pairBlocks[0]].reshape({1}));
+          round.dst.push_back(blockCounts[0].reshape({1}));
+          round.src.push_back(counts[pairBlocks[1]].reshape({1}));
+          round.dst.push_back(blockCounts[1].reshape({1}));
+          graph.connect(v["lowerCount"], blockCounts[0]);
+          graph.connect(v["upperCount"], blockCounts[1]);
+          graph.connect(v["count"], counts[pairBlocks[side]]);
+        }
+      }
+    }
+  }
+
+  if (rounds.empty()) {
+    return;
+  }
+
+  // A copy is between tensors of a single type, so the copies of each step
+  // are grouped by type.
+  const auto copy = [&](const std::vector<poplar::Tensor> &src,
+                        const std::vector<poplar::Tensor> &dst) {
+    std::map<std::string, std::pair<std::vector<poplar::Tensor>,
+                                    std::vector<poplar::Tensor>>>
+        byType;
+    for (std::size_t j = 0; j < src.size(); ++j) {
+      auto &entry = byType[src[j].elementType().toString()];
+      entry.first.push_back(src[j].flatten());
+      entry.second.push_back(dst[j].flatten());
+    }
+    for (const auto &entry : byType) {
+      prog.add(poplar::program::Copy(poplar::concat(entry.second.first),
+                                     poplar::concat(entry.second.second)));
+    }
+  };
+  copy(initSrc, initDst);
+  for (const auto &round : rounds) {
+    copy(round.src, round.dst);
+    prog.add(poplar::program::Execute(round.cs));
+  }
+  copy(resultSrc, resultDst);
+}
+
 } // namespace
 
 poplar::Tensor sort(poplar::Graph &graph, const poplar::Tensor &t, unsigned dim,
                     poplar::program::Sequence &prog,
-                    const std::string &debugPrefix) {
+                    const std::string &debugPrefix,
+                    const poplar::OptionFlags &options) {
   poplar::Tensor result = graph.clone(t);
   prog.add(poplar::program::Copy(t, result));
 
-  sortInPlace(graph, result, dim, prog, debugPrefix);
+  sortInPlace(graph, result, dim, prog, debugPrefix, options);
 
   return result;
 }
 
 void sortInPlace(poplar::Graph &graph, const poplar::Tensor &t, unsigned dim,
                  poplar::program::Sequence &prog,
-                 const std::string &debugPrefix) {
+                 const std::string &debugPrefix,
+                 const poplar::OptionFlags &optionFlags) {
   if (dim >= t.rank()) {
     throw poputil::poplibs_error(
         "Chosen sort dimension does not refer to a valid "
         "dimension in the input tensor");
   }
 
+  const auto options = parseSortOptions(optionFlags);
   poplar::Tensor tView = flattenDimension(t, dim);
+  if (options.algorithm == SortAlgorithm::MERGE_EXCHANGE) {
+    mergeExchangeSort(graph, tView, boost::none, prog, debugPrefix);
+    return;
+  }
   poplar::ComputeSet sortCS = sortSlice(graph, tView, debugPrefix);
 
   poplar::program::Sequence sortStep;
@@ -286,14 +568,15 @@ void sortInPlace(poplar::Graph &graph, const poplar::Tensor &t, unsigned dim,
 poplar::Tensor sortKeyValue(poplar::Graph &graph, const poplar::Tensor &k,
                             const poplar::Tensor &v, unsigned dim,
                             poplar::program::Sequence &prog,
-                            const std::string &debugPrefix) {
+                            const std::string &debugPrefix,
+                            const poplar::OptionFlags &options) {
   poplar::Tensor key = graph.clone(k);
   poplar::Tensor value = graph.clone(v);
 
   prog.add(poplar::program::Copy(k, key));
   prog.add(poplar::program::Copy(v, value));
 
-  sortKeyValueInPlace(graph, key, value, dim, prog, debugPrefix);
+  sortKeyValueInPlace(graph, key, value, dim, prog, debugPrefix, options);
 
   return value;
 }
@@ -301,7 +584,8 @@ poplar::Tensor sortKeyValue(poplar::Graph &graph, const poplar::Tensor &k,
 void sortKeyValueInPlace(poplar::Graph &graph, const poplar::Tensor &k,
                          const poplar::Tensor &v, unsigned dim,
                          poplar::program::Sequence &prog,
-                         const std::string &debugPrefix) {
+                         const std::string &debugPrefix,
+                         const poplar::OptionFlags &optionFlags) {
   if (k.shape() != v.shape()) {
     throw poputil::poplibs_error(
         "Key and Value arguments to sortKeyValue must be the same shape");
@@ -313,8 +597,13 @@ void sortKeyValueInPlace(poplar::Graph &graph, const poplar::Tensor &k,
         "dimension in the input tensor");
   }
 
+  const auto options = parseSortOptions(optionFlags);
   poplar::Tensor keyView = flattenDimension(k, dim);
   poplar::Tensor valueView = flattenDimension(v, dim);
+  if (options.algorithm == SortAlgorithm::MERGE_EXCHANGE) {
+    mergeExchangeSort(graph, keyView, valueView, prog, debugPrefix);
+    return;
+  }
 
   poplar::ComputeSet sortCS = sortSlice(graph, keyView, valueView, debugPrefix);
 
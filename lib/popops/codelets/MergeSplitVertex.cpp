@@ -0,0 +1,61 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#include <poplar/HalfFloat.hpp>
+#include <poplar/Vertex.hpp>
+
+namespace popops {
+
+// Merge two sorted blocks and keep either the lowest or the highest elements.
+//
+// Each block holds `count` elements followed by padding, which is treated as
+// greater than every element. `out` gets the lowest out.size() elements of
+// the merged blocks if `keepLower` is set, otherwise the remaining highest
+// elements, in order. The number of elements, excluding padding, it gets is
+// written to `count`. A vertex keeping the lower elements and a vertex keeping
+// the upper elements of the same blocks never both keep an element.
+template <typename KeyType> class MergeSplitVertex : public poplar::Vertex {
+public:
+  poplar::Input<poplar::Vector<KeyType>> lower;
+  poplar::Input<poplar::Vector<KeyType>> upper;
+  poplar::Input<unsigned> lowerCount;
+  poplar::Input<unsigned> upperCount;
+  poplar::Output<poplar::Vector<KeyType>> out;
+  poplar::Output<unsigned> count;
+  bool keepLower;
+
+  bool compute() {
+    const unsigned total = *lowerCount + *upperCount;
+    const unsigned numLower = total < out.size() ? total : out.size();
+    unsigned a = 0;
+    unsigned b = 0;
+    if (keepLower) {
+      // Ties are taken from the lower block first.
+      for (unsigned i = 0; i != numLower; ++i) {
+        if (b != *upperCount && (a == *lowerCount || upper[b] < lower[a])) {
+          out[i] = upper[b++];
+        } else {
+          out[i] = lower[a++];
+        }
+      }
+      *count = numLower;
+    } else {
+      // Merge from the back, so ties are taken from the upper block first.
+      a = *lowerCount;
+      b = *upperCount;
+      for (unsigned i = total - numLower; i != 0; --i) {
+        if (a != 0 && (b == 0 || upper[b - 1] < lower[a - 1])) {
+          out[i - 1] = lower[--a];
+        } else {
+          out[i - 1] = upper[--b];
+        }
+      }
+      *count = total - numLower;
+    }
+    return true;
+  }
+};
+
+template class MergeSplitVertex<float>;
+template class MergeSplitVertex<int>;
+template class MergeSplitVertex<half>;
+
+} // namespace popops
@@ -0,0 +1,71 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#include <poplar/HalfFloat.hpp>
+#include <poplar/Vertex.hpp>
+
+namespace popops {
+
+// As MergeSplitVertex, with a value moved along with each key.
+template <typename KeyType, typename ValueType>
+class MergeSplitVertexKV : public poplar::Vertex {
+public:
+  poplar::Input<poplar::Vector<KeyType>> lowerKey;
+  poplar::Input<poplar::Vector<ValueType>> lowerValue;
+  poplar::Input<poplar::Vector<KeyType>> upperKey;
+  poplar::Input<poplar::Vector<ValueType>> upperValue;
+  poplar::Input<unsigned> lowerCount;
+  poplar::Input<unsigned> upperCount;
+  poplar::Output<poplar::Vector<KeyType>> key;
+  poplar::Output<poplar::Vector<ValueType>> value;
+  poplar::Output<unsigned> count;
+  bool keepLower;
+
+  bool compute() {
+    const unsigned total = *lowerCount + *upperCount;
+    const unsigned numLower = total < key.size() ? total : key.size();
+    unsigned a = 0;
+    unsigned b = 0;
+    if (keepLower) {
+      // Ties are taken from the lower block first.
+      for (unsigned i = 0; i != numLower; ++i) {
+        if (b != *upperCount &&
+            (a == *lowerCount || upperKey[b] < lowerKey[a])) {
+          key[i] = upperKey[b];
+          value[i] = upperValue[b++];
+        } else {
+          key[i] = lowerKey[a];
+          value[i] = lowerValue[a++];
+        }
+      }
+      *count = numLower;
+    } else {
+      // Merge from the back, so ties are taken from the upper block first.
+      a = *lowerCount;
+      b = *upperCount;
+      for (unsigned i = total - numLower; i != 0; --i) {
+        if (a != 0 && (b == 0 || upperKey[b - 1] < lowerKey[a - 1])) {
+          --a;
+          key[i - 1] = lowerKey[a];
+          value[i - 1] = lowerValue[a];
+        } else {
+          --b;
+          key[i - 1] = upperKey[b];
+          value[i - 1] = upperValue[b];
+        }
+      }
+      *count = total - numLower;
+    }
+    return true;
+  }
+};
+
+template class MergeSplitVertexKV<float, float>;
+template class MergeSplitVertexKV<float, int>;
+template class MergeSplitVertexKV<float, half>;
+template class MergeSplitVertexKV<int, float>;
+template class MergeSplitVertexKV<int, int>;
+template class MergeSplitVertexKV<int, half>;
+template class MergeSplitVertexKV<half, float>;
+template class MergeSplitVertexKV<half, int>;
+template class MergeSplitVertexKV<half, half>;
+
+} // namespace popops
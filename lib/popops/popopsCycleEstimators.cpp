@@ -2126,6 +2126,25 @@ std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(HeapSortVertexKV)(
   return 16 * (19 * n * std::floor(std::log2(n)) + 6 * n + 2);
 }
 
+std::uint64_t
+MAKE_CYCLE_ESTIMATOR_NAME(MergeSplitVertex)(const VertexIntrospector &vertex,
+                                            const Target &target,
+                                            const Type &keyType) {
+  std::uint64_t n = vertex.getFieldInfo("out").size();
+
+  // Compare, select, load and store each element of the output.
+  return 20 + 10 * n;
+}
+
+std::uint64_t MAKE_CYCLE_ESTIMATOR_NAME(MergeSplitVertexKV)(
+    const VertexIntrospector &vertex, const Target &target, const Type &keyType,
+    const Type &valueType) {
+  std::uint64_t n = vertex.getFieldInfo("key").size();
+
+  // As MergeSplitVertex, loading and storing the value too.
+  return 20 + 14 * n;
+}
+
 std::uint64_t decrementOrGetParamsCycles(unsigned dataLen, bool isHalf) {
   // Theoretical cycle count based on simple update with -1 loop
   // load index,
@@ -2759,6 +2778,18 @@ poplibs::CycleEstimatorTable makeCyclesFunctionTable() {
       CYCLE_ESTIMATOR_ENTRY(popops, HeapSortVertexKV, HALF, INT),
       CYCLE_ESTIMATOR_ENTRY(popops, HeapSortVertexKV, HALF, FLOAT),
       CYCLE_ESTIMATOR_ENTRY(popops, HeapSortVertexKV, HALF, HALF),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertex, INT),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertex, FLOAT),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertex, HALF),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertexKV, INT, INT),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertexKV, INT, FLOAT),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertexKV, INT, HALF),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertexKV, FLOAT, INT),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertexKV, FLOAT, FLOAT),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertexKV, FLOAT, HALF),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertexKV, HALF, INT),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertexKV, HALF, FLOAT),
+      CYCLE_ESTIMATOR_ENTRY(popops, MergeSplitVertexKV, HALF, HALF),
 
       CYCLE_ESTIMATOR_ENTRY(popops, UpdateColumnsDEC, FLOAT),
       CYCLE_ESTIMATOR_ENTRY(popops, UpdateIntervalsDEC, FLOAT),
@@ -57,6 +57,17 @@ struct ReductionTypes {
   Type interTile;
 };
 
+// The compute sets and result tensors shared by a batch of reductions, which
+// are added to the program after all the reductions have been created.
+struct ReductionBatch {
+  std::vector<ComputeSet> css;
+  std::vector<Tensor> resultTensors;
+  // Added to the start tile of the stages of the next reduction which are
+  // spread over the IPU, so that they use different tiles to the stages of the
+  // reductions before it.
+  unsigned startTileOffset = 0;
+};
+
 // pick a random start tile for the intermediate to intermediate reductions to
 // use. this is an attempt to better balance work across the tiles in a large
 // model without having the whole model available at this point.
@@ -93,6 +104,7 @@ void reduceFirstDim2D(Graph &graph, const Tensor &in,
                       const ReductionTypes &reductionTypes,
                       std::vector<ComputeSet> &css,
                       ResultTensors &reductionResultTensors,
+                      unsigned startTileOffset,
                       const std::string &debugPrefix) {
   logging::debug("Reducing first dimension");
   // We only accept reductions over 2D tensors.
@@ -165,7 +177,10 @@ void reduceFirstDim2D(Graph &graph, const Tensor &in,
     // the tiles across the stages so that exchange of the partials is less.
     const auto &target = graph.getTarget();
     const auto startTile =
-        getStartTile(in.shape(), outputShape, params, target.getTilesPerIPU());
+        (getStartTile(in.shape(), outputShape, params,
+                      target.getTilesPerIPU()) +
+         startTileOffset) %
+        target.getTilesPerIPU();
 
     for (unsigned i = 0;; ++i) {
       // At each point, see if it is worth doing another reduction stage or if
@@ -223,13 +238,16 @@ std::map<std::string, poplar::Type> accumTypeMap{{"half", poplar::HALF},
 // has to be done on the first dimension. Then it calls reduceFirstDim2D
 // to do the reduction. It accepts either a vector<ComputeSet>& or a Sequence&
 // because it can be a bit faster in the latter case for reductions that
-// don't actually do any reducing.
+// don't actually do any reducing. If a batch is given with a Sequence the
+// reduction stages are added to the compute sets of the batch instead of
+// the Sequence.
 void reduceWithOutputProgOrCss(
     Graph &graph, const Tensor &in, boost::optional<Tensor> &out,
     const poplar::Type &outputType, const std::vector<std::size_t> &dims,
     ReduceParams params,
     boost::variant<std::vector<ComputeSet> &, program::Sequence &> progOrCss,
-    const std::string &debugPrefix, const poplar::OptionFlags &options) {
+    const std::string &debugPrefix, const poplar::OptionFlags &options,
+    ReductionBatch *batch = nullptr) {
 
   const auto getShape = [](const Tensor &t) {
     std::stringstream ss;
@@ -495,11 +513,24 @@ void reduceWithOutputProgOrCss(
 
   // Do the 2D->1D reduction.
   ResultTensors reductionResultTensors;
-  if (isProg) {
+  if (isProg && batch) {
+    reduceFirstDim2D(graph, input2D, out, outputShape, outputType, params,
+                     reductionTypes, batch->css, reductionResultTensors,
+                     batch->startTileOffset, debugPrefix);
+    auto &resultTensors = batch->resultTensors;
+    resultTensors.insert(resultTensors.end(),
+                         reductionResultTensors.typeA.begin(),
+                         reductionResultTensors.typeA.end());
+    resultTensors.insert(resultTensors.end(),
+                         reductionResultTensors.typeB.begin(),
+                         reductionResultTensors.typeB.end());
+    batch->startTileOffset += input2D.dim(1);
+  } else if (isProg) {
     std::vector<ComputeSet> css;
 
     reduceFirstDim2D(graph, input2D, out, outputShape, outputType, params,
-                     reductionTypes, css, reductionResultTensors, debugPrefix);
+                     reductionTypes, css, reductionResultTensors, 0,
+                     debugPrefix);
     auto &prog = boost::get<program::Sequence &>(progOrCss);
     // First mark with 'WriteUndef' any tensor that will be completely written
     // by this whole reduction, but may be written internally in two different
@@ -522,7 +553,7 @@ void reduceWithOutputProgOrCss(
     reduceFirstDim2D(graph, input2D, out, outputShape, outputType, params,
                      reductionTypes,
                      boost::get<std::vector<ComputeSet> &>(progOrCss),
-                     reductionResultTensors, debugPrefix);
+                     reductionResultTensors, 0, debugPrefix);
   }
 }
 } // end anonymous namespace
@@ -588,6 +619,57 @@ Tensor reduce(Graph &graph, const Tensor &in, const poplar::Type &outType,
   return out.get();
 }
 
+void reduceMany(Graph &graph, const std::vector<SingleReduceOp> &reductions,
+                std::vector<Tensor> &outputs, program::Sequence &prog,
+                const std::string &debugPrefix,
+                const poplar::OptionFlags &options) {
+  const bool createOutputs = outputs.empty();
+  if (!createOutputs && outputs.size() != reductions.size()) {
+    throw poputil::poplibs_error(
+        "reduceMany was given " + std::to_string(outputs.size()) +
+        " outputs for " + std::to_string(reductions.size()) + " reductions");
+  }
+  logging::info("reduceMany reductions={}, name={}", reductions.size(),
+                debugPrefix);
+
+  ReductionBatch batch;
+  for (std::size_t i = 0; i != reductions.size(); ++i) {
+    const auto &reduction = reductions[i];
+    if (createOutputs && reduction.params.update) {
+      throw poputil::poplibs_error("Cannot do an update using reduceMany() "
+                                   "without outputs.");
+    }
+    boost::optional<Tensor> out;
+    if (!createOutputs) {
+      out = outputs[i];
+    }
+    const auto outType =
+        createOutputs ? reduction.outType : outputs[i].elementType();
+    reduceWithOutputProgOrCss(graph, reduction.in, out, outType,
+                              reduction.dims, reduction.params, prog,
+                              debugPrefix + "/Reduce" + std::to_string(i) +
+                                  reduction.debugPrefix,
+                              options, &batch);
+    if (createOutputs) {
+      outputs.push_back(out.get());
+    }
+  }
+
+  // Mark the tensors written by the reductions with 'WriteUndef' as in
+  // reduceWithOutputProgOrCss(), with one program for each type.
+  std::map<Type, std::vector<Tensor>> resultTensorsByType;
+  for (const auto &t : batch.resultTensors) {
+    resultTensorsByType[t.elementType()].push_back(t);
+  }
+  for (const auto &entry : resultTensorsByType) {
+    prog.add(program::WriteUndef(concat(entry.second)));
+  }
+  logging::debug("reduceMany used {} compute sets", batch.css.size());
+  for (const auto &cs : batch.css) {
+    prog.add(program::Execute(cs));
+  }
+}
+
 Tensor mangleTo2D(const Tensor &A, std::set<unsigned> &reducedDims) {
 
   // The set of dimensions that aren't reduced.
@@ -6,7 +6,11 @@
 #include <cassert>
 
 #include <fstream>
+#include <limits>
+#include <mutex>
 #include <numeric>
+#include <tuple>
+#include <unordered_map>
 
 #include <boost/icl/split_interval_map.hpp>
 #include <boost/optional.hpp>
@@ -18,6 +22,7 @@
 
 #include "poplibs_support/logging.hpp"
 #include <poplibs_support/Algorithms.hpp>
+#include <poplibs_support/Fingerprint.hpp>
 #include <poplibs_support/ContiguousRegionsByTile.hpp>
 #include <poplibs_support/IclUtil.hpp>
 #include <poplibs_support/print.hpp>
@@ -629,6 +634,131 @@ dividePartials(std::vector<PartialsDescription> &groupedPartials, Graph &graph,
   }
   return partialsResult;
 }
+
+namespace {
+
+// Everything a TilePartialsPlan depends on. The regions are shifted by a
+// whole number of rows so that the first one starts in the first row.
+struct TilePartialsPlanKey {
+  std::vector<std::vector<Interval>> regions;
+  unsigned columns;
+  std::string inType;
+  Operation op;
+  unsigned numWorkers;
+  unsigned grainSize;
+
+  bool operator==(const TilePartialsPlanKey &other) const {
+    return std::tie(regions, columns, inType, op, numWorkers, grainSize) ==
+           std::tie(other.regions, other.columns, other.inType, other.op,
+                    other.numWorkers, other.grainSize);
+  }
+};
+
+struct TilePartialsPlanKeyHash {
+  std::size_t operator()(const TilePartialsPlanKey &key) const {
+    Fingerprint f;
+    f.add(key.regions.size());
+    for (const auto &region : key.regions) {
+      f.add(region.size());
+      for (const auto &interval : region) {
+        f.add(interval.begin()).add(interval.end());
+      }
+    }
+    f.add(key.columns).add(key.inType).add(key.op);
+    f.add(key.numWorkers).add(key.grainSize);
+    return f.get();
+  }
+};
+
+// Plans for different layouts are only added when a new reduction is
+// created, so the cache is simply emptied if it grows too large.
+constexpr std::size_t maxCachedTilePartialsPlans = 1 << 16;
+
+std::mutex tilePartialsPlanCacheMutex;
+std::unordered_map<TilePartialsPlanKey,
+                   std::shared_ptr<const TilePartialsPlan>,
+                   TilePartialsPlanKeyHash>
+    tilePartialsPlanCache;
+
+std::shared_ptr<const TilePartialsPlan>
+createTilePartialsPlan(const std::vector<std::vector<Interval>> &regions,
+                       unsigned columns, Graph &graph, Type inType,
+                       ReduceParams params) {
+  auto plan = std::make_shared<TilePartialsPlan>();
+  // Make a pattern for each column that is detected in the regions on tile
+  auto partialsDescription = gatherReductionPatterns(regions, columns);
+  plan->numColumns = partialsDescription.size();
+
+  // Grouping works by identifying a compatible patterns that follow a base
+  // pattern in memory.  This requires them to be in memory order.
+  std::sort(partialsDescription.begin(), partialsDescription.end(),
+            [](const PartialsDescription &a, const PartialsDescription &b) {
+              return (a.patterns[0].regionOffset <
+                      b.patterns[0].regionOffset);
+            });
+
+  // Group the patterns according to columns with identical patterns and
+  // adjacent in memory
+  auto groupedPartials = groupPartials(partialsDescription, columns);
+
+  // Divide the patterns to split work between workers and cope with
+  // other limitations
+  plan->partials = dividePartials(groupedPartials, graph, inType, params);
+  return plan;
+}
+
+} // end anonymous namespace
+
+std::shared_ptr<const TilePartialsPlan>
+getTilePartialsPlan(const std::vector<std::vector<Interval>> &regions,
+                    unsigned columns, Graph &graph, Type inType,
+                    ReduceParams params) {
+  // The patterns are found from the column of each element, which is
+  // unchanged by moving all the regions by a whole number of rows.
+  std::size_t firstElement = std::numeric_limits<std::size_t>::max();
+  for (const auto &region : regions) {
+    for (const auto &interval : region) {
+      firstElement = std::min(firstElement, interval.begin());
+    }
+  }
+  const auto shift = firstElement / columns * columns;
+  TilePartialsPlanKey key;
+  key.regions = regions;
+  for (auto &region : key.regions) {
+    for (auto &interval : region) {
+      interval = {interval.begin() - shift, interval.end() - shift};
+    }
+  }
+  key.columns = columns;
+  key.inType = inType.toString();
+  key.op = params.op;
+  key.numWorkers = graph.getTarget().getNumWorkerContexts();
+  key.grainSize = findGrainSizeForOp(graph, inType, params.op);
+
+  {
+    std::lock_guard<std::mutex> lock(tilePartialsPlanCacheMutex);
+    const auto match = tilePartialsPlanCache.find(key);
+    if (match != tilePartialsPlanCache.end()) {
+      return match->second;
+    }
+  }
+  auto plan = createTilePartialsPlan(key.regions, columns, graph, inType,
+                                     params);
+  std::lock_guard<std::mutex> lock(tilePartialsPlanCacheMutex);
+  if (tilePartialsPlanCache.size() >= maxCachedTilePartialsPlans) {
+    logging::debug("Emptying the reduction plan cache of {} plans",
+                   tilePartialsPlanCache.size());
+    tilePartialsPlanCache.clear();
+  }
+  tilePartialsPlanCache.emplace(std::move(key), plan);
+  return plan;
+}
+
+std::size_t getTilePartialsPlanCacheSize() {
+  std::lock_guard<std::mutex> lock(tilePartialsPlanCacheMutex);
+  return tilePartialsPlanCache.size();
+}
+
 // Store reduction results for a later writeUndef - store based on type.
 void storeReductionResultTensors(ResultTensors &results, const Tensor &data) {
   if (results.typeA.size() == 0) {
@@ -671,26 +801,11 @@ void createInputReductions(
     if (contiguousRegionsThisTile.empty()) {
       continue;
     }
-    // Make a pattern for each column that is detected in the regions on tile
-    auto partialsDescription =
-        gatherReductionPatterns(contiguousRegionsThisTile, columns);
-
-    // Grouping works by identifying a compatible patterns that follow a base
-    // pattern in memory.  This requires them to be in memory order.
-    std::sort(partialsDescription.begin(), partialsDescription.end(),
-              [](const PartialsDescription &a, const PartialsDescription &b) {
-                return (a.patterns[0].regionOffset <
-                        b.patterns[0].regionOffset);
-              });
-
-    // Group the patterns according to columns with identical patterns and
-    // adjacent in memory
-    auto groupedPartials = groupPartials(partialsDescription, columns);
-
-    // Divide the patterns to split work between workers and cope with
-    // other limitations
-    auto splitGroupedPartials =
-        dividePartials(groupedPartials, graph, in.elementType(), params);
+    // The patterns describing the columns on this tile, which are the same
+    // for every tile and reduction with the same layout.
+    const auto plan = getTilePartialsPlan(contiguousRegionsThisTile, columns,
+                                          graph, in.elementType(), params);
+    const auto &splitGroupedPartials = plan->partials;
 
     // logging begin
     if (logging::shouldLog(logging::Level::Trace)) {
@@ -746,7 +861,7 @@ void createInputReductions(
     }
     if (!isInputToOutput) {
       // Add a tensor for this tile.
-      auto data = graph.addVariable(outputType, {partialsDescription.size()},
+      auto data = graph.addVariable(outputType, {plan->numColumns},
                                     debugPrefix + "/tile_data1");
       storeReductionResultTensors(reductionResultTensors, data);
 
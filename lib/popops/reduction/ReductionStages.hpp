@@ -13,6 +13,7 @@
 
 #include <boost/optional.hpp>
 
+#include <memory>
 #include <string>
 
 namespace popops {
@@ -197,6 +198,28 @@ std::vector<PartialsDescription>
 dividePartials(std::vector<PartialsDescription> &groupedPartials,
                poplar::Graph &graph, poplar::Type inType, ReduceParams params);
 
+// The result of analysing the contiguous regions of the input on one tile:
+// the number of columns found on the tile and the patterns describing them,
+// grouped and divided between workers.
+struct TilePartialsPlan {
+  std::size_t numColumns;
+  std::vector<PartialsDescription> partials;
+};
+
+// Return the plan for the given contiguous regions on a tile of a tensor with
+// shape {rows, columns}. The plan only depends on the position of the regions
+// relative to the start of a row, so plans are shared between tiles and
+// reductions with the same layout and are kept in a process wide cache. This
+// saves repeating the analysis when the same reduction is created many times,
+// for example to accumulate gradients.
+std::shared_ptr<const TilePartialsPlan>
+getTilePartialsPlan(const std::vector<std::vector<poplar::Interval>> &regions,
+                    unsigned columns, poplar::Graph &graph, poplar::Type inType,
+                    ReduceParams params);
+
+// The number of plans in the process wide cache, for test purposes.
+std::size_t getTilePartialsPlanCacheSize();
+
 } // namespace popops
 
 #endif // ReductionStages_hpp
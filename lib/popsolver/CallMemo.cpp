@@ -0,0 +1,50 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#include <popsolver/CallMemo.hpp>
+
+#include <boost/functional/hash.hpp>
+#include <cassert>
+
+using namespace popsolver;
+
+std::size_t CallMemo::Hash::
+operator()(const std::vector<unsigned> &values) const {
+  return boost::hash_range(values.begin(), values.end());
+}
+
+bool CallMemo::lookup(const std::vector<unsigned> &values,
+                      Result &result) const {
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    const auto match = table.find(values);
+    if (match != table.end()) {
+      result = match->second;
+      ++numHits;
+      return true;
+    }
+  }
+  ++numMisses;
+  return false;
+}
+
+void CallMemo::insert(const std::vector<unsigned> &values, Result result) {
+  std::lock_guard<std::mutex> guard(mutex);
+  if (table.size() >= maxSize) {
+    return;
+  }
+  // Another user of the table may have inserted the same entry since the
+  // lookup failed, in which case it must have the same result.
+  const auto inserted = table.emplace(values, result);
+  assert(inserted.first->second == result);
+  (void)inserted;
+}
+
+double CallMemo::hitRate() const {
+  const auto h = hits();
+  const auto total = h + misses();
+  return total == 0 ? 0.0 : static_cast<double>(h) / total;
+}
+
+std::size_t CallMemo::size() const {
+  std::lock_guard<std::mutex> guard(mutex);
+  return table.size();
+}
@@ -4,6 +4,7 @@
 #include "Scheduler.hpp"
 #include <boost/range/iterator_range.hpp>
 #include <limits>
+#include <popsolver/CallMemo.hpp>
 #include <popsolver/Model.hpp>
 
 using namespace popsolver;
@@ -273,7 +274,13 @@ bool GenericAssignment::propagate(Scheduler &scheduler) {
     values[i - 1] = domains[vars[i]].val();
   }
   const auto result = vars[0];
-  const boost::optional<unsigned> x = f(values);
+  boost::optional<unsigned> x;
+  if (!memo || !memo->lookup(values, x)) {
+    x = f(values);
+    if (memo) {
+      memo->insert(values, x);
+    }
+  }
   if (!x) {
     return false;
   }
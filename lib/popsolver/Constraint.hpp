@@ -4,12 +4,14 @@
 
 #include <boost/optional.hpp>
 #include <functional>
+#include <memory>
 #include <poplar/ArrayRef.hpp>
 #include <popsolver/Variable.hpp>
 #include <vector>
 
 namespace popsolver {
 
+class CallMemo;
 class Scheduler;
 
 class Constraint {
@@ -31,13 +33,16 @@ class GenericAssignment : public Constraint {
   // is a class member instead of a local variable to reduce the number of
   // allocations needed.
   std::vector<unsigned> values;
+  // Optional table of previously computed results of f.
+  std::shared_ptr<CallMemo> memo;
 
 public:
   GenericAssignment(Variable result, std::vector<Variable> vars_,
                     std::function<boost::optional<unsigned>(
                         const std::vector<unsigned> &values)>
-                        f)
-      : vars(), f(f), values(vars_.size()) {
+                        f,
+                    std::shared_ptr<CallMemo> memo = nullptr)
+      : vars(), f(f), values(vars_.size()), memo(std::move(memo)) {
     vars.reserve(vars_.size() + 1);
     vars.push_back(result);
     vars.insert(std::end(vars), std::begin(vars_), std::end(vars_));
@@ -7,11 +7,68 @@
 #include <boost/optional.hpp>
 #include <cassert>
 #include <limits>
+#include <ostream>
 
 using namespace popsolver;
 
+// Domains with at most this many values are searched linearly by the BISECT
+// strategy as splitting them further would cost more propagation than it
+// saves.
+static constexpr unsigned minBisectDomainSize = 8;
+
+static unsigned gcd(unsigned a, unsigned b) {
+  while (b != 0) {
+    const auto t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// Return the divisors of n in ascending order.
+static std::vector<unsigned> getDivisors(unsigned n) {
+  std::vector<unsigned> lower, upper;
+  for (unsigned i = 1; i <= n / i; ++i) {
+    if (n % i == 0) {
+      lower.push_back(i);
+      if (i != n / i) {
+        upper.push_back(n / i);
+      }
+    }
+  }
+  lower.insert(lower.end(), upper.rbegin(), upper.rend());
+  return lower;
+}
+
+std::ostream &popsolver::operator<<(std::ostream &os, SearchStrategy s) {
+  switch (s) {
+  case SearchStrategy::LINEAR:
+    return os << "linear";
+  case SearchStrategy::BISECT:
+    return os << "bisect";
+  }
+  return os << "unknown";
+}
+
+SearchStats &SearchStats::operator+=(const SearchStats &other) {
+  nodes += other.nodes;
+  propagations += other.propagations;
+  constraintEvaluations += other.constraintEvaluations;
+  backtracks += other.backtracks;
+  prunes += other.prunes;
+  return *this;
+}
+
+std::ostream &popsolver::operator<<(std::ostream &os, const SearchStats &s) {
+  return os << "nodes=" << s.nodes << ", propagations=" << s.propagations
+            << ", constraintEvaluations=" << s.constraintEvaluations
+            << ", backtracks=" << s.backtracks << ", prunes=" << s.prunes;
+}
+
 Model::Model() = default;
 
+Model::Model(SearchStrategy searchStrategy) : searchStrategy(searchStrategy) {}
+
 Model::~Model() = default;
 
 void Model::addConstraint(std::unique_ptr<Constraint> c) {
@@ -59,6 +116,7 @@ Variable Model::addVariable(unsigned min, unsigned max,
   }
   initialDomains.push_back({min, max});
   isCallOperand.push_back(false);
+  factorOfConstant.push_back(0);
   if (debugName.empty()) {
     debugNames.emplace_back("var#" + std::to_string(v.id));
   } else {
@@ -219,6 +277,9 @@ void Model::equal(Variable left, unsigned right) {
 void Model::factorOf(unsigned left, Variable right) {
   const auto result = addVariable();
   equal(left, product({result, right}));
+  // gcd(0, left) == left so this also handles the first constraint on the
+  // variable.
+  factorOfConstant[right.id] = gcd(factorOfConstant[right.id], left);
 }
 
 void Model::factorOf(Variable left, Variable right) {
@@ -231,12 +292,21 @@ Variable Model::call(std::vector<Variable> vars,
                          const std::vector<unsigned> &values)>
                          f,
                      const std::string &debugName) {
+  return call(std::move(vars), std::move(f), nullptr, debugName);
+}
+
+Variable Model::call(std::vector<Variable> vars,
+                     std::function<boost::optional<unsigned>(
+                         const std::vector<unsigned> &values)>
+                         f,
+                     std::shared_ptr<CallMemo> memo,
+                     const std::string &debugName) {
   for (auto var : vars) {
     isCallOperand[var.id] = true;
   }
   auto result = addVariable(debugName);
   auto p = std::unique_ptr<Constraint>(
-      new GenericAssignment(result, std::move(vars), f));
+      new GenericAssignment(result, std::move(vars), f, std::move(memo)));
   addConstraint(std::move(p));
   return result;
 }
@@ -293,24 +363,108 @@ bool Model::minimize(Scheduler &scheduler,
     }
     return false;
   }
+  switch (searchStrategy) {
+  case SearchStrategy::LINEAR:
+    break;
+  case SearchStrategy::BISECT:
+    if (factorOfConstant[v->id] != 0) {
+      return minimizeDivisors(scheduler, *v, objectives, foundSolution,
+                              solution);
+    }
+    if (domains[*v].size() > minBisectDomainSize) {
+      return minimizeBisect(scheduler, *v, objectives, foundSolution, solution);
+    }
+    break;
+  }
+  return minimizeLinear(scheduler, *v, objectives, foundSolution, solution);
+}
+
+// Restrict the domain of v to [min, max] and search for a lower cost
+// solution. If one is found the objective is bounded by it.
+bool Model::tryDomain(Scheduler &scheduler, Variable v, unsigned min,
+                      unsigned max, const std::vector<Variable> &objectives,
+                      bool &foundSolution, Solution &solution) {
+  ++scheduler.getStats().nodes;
+  scheduler.checkpoint();
+  if (min == max) {
+    scheduler.set(v, min);
+  } else {
+    if (min != scheduler.getDomains()[v].min()) {
+      scheduler.setMin(v, min);
+    }
+    if (max != scheduler.getDomains()[v].max()) {
+      scheduler.setMax(v, max);
+    }
+  }
+  bool improvedSolution = false;
+  if (!scheduler.propagate()) {
+    ++scheduler.getStats().prunes;
+  } else if (minimize(scheduler, objectives, foundSolution, solution)) {
+    improvedSolution = true;
+  }
+  scheduler.backtrack();
+  if (improvedSolution) {
+    scheduler.setMax(objectives.front(), solution[objectives.front()]);
+    bool succeeded = scheduler.propagate();
+    assert(succeeded);
+    (void)succeeded;
+  }
+  return improvedSolution;
+}
+
+bool Model::minimizeLinear(Scheduler &scheduler, Variable v,
+                           const std::vector<Variable> &objectives,
+                           bool &foundSolution, Solution &solution) {
   // Evaluate the cost for every possible value of this variable.
   bool improvedSolution = false;
-  for (unsigned value = scheduler.getDomains()[*v].min();
-       value <= scheduler.getDomains()[*v].max(); ++value) {
-    auto savedDomains = scheduler.getDomains();
-    scheduler.set(*v, value);
-    bool valueImprovedSolution = false;
-    if (scheduler.propagate() &&
-        minimize(scheduler, objectives, foundSolution, solution)) {
-      valueImprovedSolution = true;
+  for (unsigned value = scheduler.getDomains()[v].min();
+       value <= scheduler.getDomains()[v].max(); ++value) {
+    if (tryDomain(scheduler, v, value, value, objectives, foundSolution,
+                  solution)) {
+      improvedSolution = true;
+    }
+  }
+  return improvedSolution;
+}
+
+bool Model::minimizeBisect(Scheduler &scheduler, Variable v,
+                           const std::vector<Variable> &objectives,
+                           bool &foundSolution, Solution &solution) {
+  const auto &domain = scheduler.getDomains()[v];
+  const auto mid = domain.min() + (domain.max() - domain.min()) / 2;
+  bool improvedSolution = false;
+  // Bounding the objective after a solution is found may shrink the domain
+  // of v so the bounds of each half are recomputed before it is searched.
+  if (domain.min() <= mid &&
+      tryDomain(scheduler, v, domain.min(), std::min(mid, domain.max()),
+                objectives, foundSolution, solution)) {
+    improvedSolution = true;
+  }
+  if (domain.max() > mid &&
+      tryDomain(scheduler, v, std::max(mid + 1, domain.min()), domain.max(),
+                objectives, foundSolution, solution)) {
+    improvedSolution = true;
+  }
+  return improvedSolution;
+}
+
+bool Model::minimizeDivisors(Scheduler &scheduler, Variable v,
+                             const std::vector<Variable> &objectives,
+                             bool &foundSolution, Solution &solution) {
+  // Any value that is not a divisor would fail to propagate so only the
+  // divisors are tried.
+  bool improvedSolution = false;
+  for (const auto value : divisors.at(factorOfConstant[v.id])) {
+    const auto &domain = scheduler.getDomains()[v];
+    if (value < domain.min()) {
+      continue;
+    }
+    if (value > domain.max()) {
+      break;
     }
-    scheduler.setDomains(std::move(savedDomains));
-    if (valueImprovedSolution) {
+    if (tryDomain(scheduler, v, value, value, objectives, foundSolution,
+                  solution)) {
       improvedSolution = true;
-      scheduler.setMax(objectives.front(), solution[objectives.front()]);
-      bool succeeded = scheduler.propagate();
-      assert(succeeded);
-      (void)succeeded;
     }
   }
   return improvedSolution;
@@ -325,10 +479,20 @@ Solution Model::minimize(const std::vector<Variable> &v) {
   for (const auto &c : constraints) {
     constraintPtrs.push_back(c.get());
   }
+  if (searchStrategy == SearchStrategy::BISECT) {
+    for (const auto c : factorOfConstant) {
+      if (c != 0 && !divisors.count(c)) {
+        divisors.emplace(c, getDivisors(c));
+      }
+    }
+  }
   // Perform initial constraint propagation.
   Scheduler scheduler(initialDomains, std::move(constraintPtrs));
-  if (scheduler.initialPropagate() &&
-      minimize(scheduler, v, foundSolution, solution))
+  const bool improvedSolution =
+      scheduler.initialPropagate() &&
+      minimize(scheduler, v, foundSolution, solution);
+  searchStats = scheduler.getStats();
+  if (improvedSolution)
     return solution;
   return Solution();
 }
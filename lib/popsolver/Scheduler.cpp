@@ -6,7 +6,8 @@
 using namespace popsolver;
 
 Scheduler::Scheduler(Domains domains_, std::vector<Constraint *> constraints_)
-    : domains(std::move(domains_)), constraints(std::move(constraints_)) {
+    : domains(std::move(domains_)), constraints(std::move(constraints_)),
+      savedStamp(domains.size()) {
   unsigned numConstraints = constraints.size();
   queued.resize(numConstraints);
   for (unsigned c = 0; c != numConstraints; ++c) {
@@ -19,7 +20,22 @@ Scheduler::Scheduler(Domains domains_, std::vector<Constraint *> constraints_)
   }
 }
 
+void Scheduler::backtrack() {
+  assert(!trailMarks.empty());
+  const auto mark = trailMarks.back();
+  trailMarks.pop_back();
+  ++stats.backtracks;
+  // Only the entries recorded since the checkpoint are undone.
+  while (trail.size() > mark.trailSize) {
+    const auto &entry = trail.back();
+    domains[Variable(entry.first)] = entry.second;
+    trail.pop_back();
+  }
+  currentStamp = mark.stamp;
+}
+
 bool Scheduler::propagate() {
+  ++stats.propagations;
   while (!worklist.empty()) {
     auto c = worklist.front();
     worklist.pop();
@@ -27,6 +43,7 @@ bool Scheduler::propagate() {
     // call to propagate(). The propagate() method is responsible for computing
     // the fixed point such that a second call to propagate() immediately after
     // would make no further changes.
+    ++stats.constraintEvaluations;
     bool succeeded = constraints[c]->propagate(*this);
     queued[c] = 0;
     if (!succeeded) {
@@ -5,6 +5,7 @@
 #include <cassert>
 #include <popsolver/Model.hpp>
 #include <queue>
+#include <utility>
 #include <vector>
 
 namespace popsolver {
@@ -21,6 +22,25 @@ class Scheduler {
   std::vector<std::vector<unsigned>> variableConstraints;
   std::queue<unsigned> worklist;
   std::vector<bool> queued;
+
+  /// The trail records the previous domain of each variable modified since
+  /// the most recent checkpoint so the changes can be undone on backtrack.
+  std::vector<std::pair<unsigned, Domain>> trail;
+  struct TrailMark {
+    std::size_t trailSize;
+    unsigned stamp;
+  };
+  std::vector<TrailMark> trailMarks;
+  /// Stamp of the current checkpoint, or 0 if there is no checkpoint. Each
+  /// checkpoint gets a unique stamp.
+  unsigned currentStamp = 0;
+  unsigned nextStamp = 1;
+  /// The stamp of the checkpoint at which each variable's domain was last
+  /// saved to the trail. A variable only needs to be saved once per
+  /// checkpoint.
+  std::vector<unsigned> savedStamp;
+  SearchStats stats;
+
   void queueConstraints(Variable v) {
     if (v.id < variableConstraints.size()) {
       for (auto c : variableConstraints[v.id]) {
@@ -31,31 +51,56 @@ class Scheduler {
       }
     }
   }
+  void saveDomain(Variable v) {
+    if (currentStamp != 0 && savedStamp[v.id] != currentStamp) {
+      trail.emplace_back(v.id, domains[v]);
+      savedStamp[v.id] = currentStamp;
+    }
+  }
 
 public:
   Scheduler(Domains domains, std::vector<Constraint *> constraints);
   const Domains &getDomains() { return domains; }
-  void setDomains(Domains value) { domains = value; }
+  void setDomains(Domains value) {
+    assert(trailMarks.empty());
+    domains = value;
+  }
   void set(Variable v, unsigned value) {
     assert(value >= domains[v].min_);
     assert(value <= domains[v].max_);
+    saveDomain(v);
     domains[v].min_ = domains[v].max_ = value;
     queueConstraints(v);
   }
   void setMin(Variable v, unsigned value) {
     assert(value >= domains[v].min_);
     assert(value <= domains[v].max_);
+    saveDomain(v);
     domains[v].min_ = value;
     queueConstraints(v);
   }
   void setMax(Variable v, unsigned value) {
     assert(value >= domains[v].min_);
     assert(value <= domains[v].max_);
+    saveDomain(v);
     domains[v].max_ = value;
     queueConstraints(v);
   }
+  /// Record the current domains so that subsequent changes can be undone by
+  /// a matching call to backtrack(). Checkpoints can be nested.
+  void checkpoint() {
+    trailMarks.push_back({trail.size(), currentStamp});
+    currentStamp = nextStamp++;
+  }
+  /// Restore the domains to their state at the most recent checkpoint. This
+  /// takes time proportional to the number of variables that were changed.
+  void backtrack();
   bool propagate();
   bool initialPropagate();
+  /// Counters describing the work done using this scheduler. The propagation
+  /// and backtrack counts are maintained by the scheduler, the others are
+  /// maintained by the search.
+  SearchStats &getStats() { return stats; }
 };
 
 } // End namespace popsolver.
@@ -20,6 +20,7 @@ std::ostream &operator<<(std::ostream &os, const Options &o) {
      << ",\n doGradWPass: " << o.doGradWPass
      << ",\n partialsType: " << o.partialsType
      << ",\n sharedBuckets: " << o.sharedBuckets
+     << ",\n plannerSearchStrategy: " << o.plannerSearchStrategy
      << ",\n partitioner.optimiseForSpeed: " << o.partitioner.optimiseForSpeed
      << ",\n partitioner.forceBucketSpills: " << o.partitioner.forceBucketSpills
      << ",\n partitioner.useActualWorkerSplitCosts: "
@@ -30,6 +31,10 @@ std::ostream &operator<<(std::ostream &os, const Options &o) {
 static std::map<std::string, poplar::Type> partialsTypeMap{
     {"half", poplar::HALF}, {"float", poplar::FLOAT}};
 
+static std::map<std::string, popsolver::SearchStrategy> searchStrategyMap{
+    {"linear", popsolver::SearchStrategy::LINEAR},
+    {"bisect", popsolver::SearchStrategy::BISECT}};
+
 Options parseOptionFlags(const OptionFlags &flags) {
   Options options;
 
@@ -44,6 +49,9 @@ Options parseOptionFlags(const OptionFlags &flags) {
       {"partialsType",
        OptionHandler::createWithEnum(options.partialsType, partialsTypeMap)},
       {"sharedBuckets", OptionHandler::createWithBool(options.sharedBuckets)},
+      {"plannerSearchStrategy",
+       OptionHandler::createWithEnum(options.plannerSearchStrategy,
+                                     searchStrategyMap)},
       {"partitioner.optimiseForSpeed",
        OptionHandler::createWithBool(options.partitioner.optimiseForSpeed)},
       {"partitioner.forceBucketSpills",
@@ -61,12 +69,14 @@ bool operator<(const Options &a, const Options &b) {
   return std::tie(
              a.availableMemoryProportion, a.metaInfoBucketOversizeProportion,
              a.doGradAPass, a.doGradWPass, a.partialsType, a.sharedBuckets,
-             a.partitioner.optimiseForSpeed, a.partitioner.forceBucketSpills,
+             a.plannerSearchStrategy, a.partitioner.optimiseForSpeed,
+             a.partitioner.forceBucketSpills,
              a.partitioner.useActualWorkerSplitCosts) <
          std::tie(
              b.availableMemoryProportion, b.metaInfoBucketOversizeProportion,
              b.doGradAPass, b.doGradWPass, b.partialsType, b.sharedBuckets,
-             b.partitioner.optimiseForSpeed, a.partitioner.forceBucketSpills,
+             b.plannerSearchStrategy, b.partitioner.optimiseForSpeed,
+             a.partitioner.forceBucketSpills,
              b.partitioner.useActualWorkerSplitCosts);
 }
 
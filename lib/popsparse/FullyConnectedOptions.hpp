@@ -5,6 +5,7 @@
 
 #include <poplar/OptionFlags.hpp>
 #include <poplar/Type.hpp>
+#include <popsolver/Model.hpp>
 
 #include <ostream>
 #include <tuple>
@@ -28,6 +29,9 @@ struct Options {
   poplar::Type partialsType = poplar::FLOAT;
   // If set, forces the buckets to be used for all three passes to be the same
   bool sharedBuckets = true;
+  // The strategy the planner's solver uses to search for the best plan.
+  popsolver::SearchStrategy plannerSearchStrategy =
+      popsolver::SearchStrategy::LINEAR;
 
   struct Partitioner {
     // Optimise bucket overflow allocation for speed. Overflow allocation would
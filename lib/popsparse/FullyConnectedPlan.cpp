@@ -1048,7 +1048,7 @@ createPlan(const PlanningObjective &objective, const Target &target,
         return ceildiv(size, grouping);
       });
 
-  popsolver::Model m;
+  popsolver::Model m(options.plannerSearchStrategy);
   // Create partitions variables
   const PartitionVariables fwdPartition = [&] {
     std::vector<Vector<popsolver::Variable>> mPartitions(hierarchy.size());
@@ -105,3 +105,24 @@ BOOST_AUTO_TEST_CASE(ValidateTopLevel) {
   t = ptree("0");
   BOOST_CHECK_THROW(uut(t), poplar::invalid_option);
 }
+
+BOOST_AUTO_TEST_CASE(Fingerprint) {
+  const ConvOptions options(2, 1216, {});
+  ConvOptions same(2, 1216, {});
+  BOOST_CHECK(options == same);
+  BOOST_CHECK_EQUAL(poplibs_support::fingerprint(options),
+                    poplibs_support::fingerprint(same));
+
+  ConvOptions otherMemory = options;
+  otherMemory.availableMemoryProportion = 0.3;
+  BOOST_CHECK_NE(poplibs_support::fingerprint(options),
+                 poplibs_support::fingerprint(otherMemory));
+
+  ConvOptions otherConstraints = options;
+  otherConstraints.planConstraints.put("method", "AMP");
+  BOOST_CHECK_NE(poplibs_support::fingerprint(options),
+                 poplibs_support::fingerprint(otherConstraints));
+  same.planConstraints.put("method", "AMP");
+  BOOST_CHECK_EQUAL(poplibs_support::fingerprint(same),
+                    poplibs_support::fingerprint(otherConstraints));
+}
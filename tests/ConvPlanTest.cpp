@@ -9,7 +9,9 @@
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/test/unit_test.hpp>
+#include <cstdio>
 #include <popnn/codelets.hpp>
+#include <tbb/task_arena.h>
 #include <vector>
 
 const auto testIpuName = deviceTypeToIPUName(TEST_TARGET);
@@ -48,6 +50,123 @@ BOOST_AUTO_TEST_CASE(getCachedPlans) {
   poplin::getPlan(target, params, poplin::ConvOptions(target), &cache);
 }
 
+BOOST_AUTO_TEST_CASE(SaveAndLoadCachedPlans) {
+  poplar::Graph graph(poplar::Target::createIPUTarget(2, testIpuName));
+  auto &target = graph.getTarget();
+  const std::string path = "ConvPlanTestSaveAndLoadCachedPlans.json";
+  const auto options = poplin::ConvOptions(target);
+
+  poplin::PlanningCache cache;
+  const auto plan = poplin::getPlan(target, params, options, &cache);
+  cache.save(target, path);
+
+  // The loaded plan is used without running the planner.
+  poplin::PlanningCache loadedCache;
+  loadedCache.load(target, path);
+  const auto loadedPlan =
+      poplin::getPlan(target, params, options, &loadedCache);
+  BOOST_CHECK(!(plan < loadedPlan) && !(loadedPlan < plan));
+  BOOST_CHECK_EQUAL(loadedCache.getStats().candidates, 0);
+
+  // Plans saved for a different target must not be reused but are kept when
+  // the cache is saved again. Only the target differs, the options are the
+  // same, so the plans are only told apart by the target.
+  poplar::Graph otherGraph(poplar::Target::createIPUTarget(1, testIpuName));
+  auto &otherTarget = otherGraph.getTarget();
+  poplin::PlanningCache otherCache;
+  otherCache.load(otherTarget, path);
+  poplin::getPlan(otherTarget, params, options, &otherCache);
+  BOOST_CHECK(otherCache.getStats().candidates > 0);
+  otherCache.save(otherTarget, path);
+
+  poplin::PlanningCache reloadedCache;
+  reloadedCache.load(target, path);
+  const auto reloadedPlan =
+      poplin::getPlan(target, params, options, &reloadedCache);
+  BOOST_CHECK(!(plan < reloadedPlan) && !(reloadedPlan < plan));
+  BOOST_CHECK_EQUAL(reloadedCache.getStats().candidates, 0);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(MergeAndLoadPlanIndex) {
+  poplar::Graph graph(poplar::Target::createIPUTarget(2, testIpuName));
+  auto &target = graph.getTarget();
+  const std::string path = "ConvPlanTestMergeAndLoadPlanIndex.idx";
+  const auto options = poplin::ConvOptions(target);
+  std::remove(path.c_str());
+
+  // Two workers each plan a different convolution and merge their plans into
+  // the same index.
+  poplin::PlanningCache cache;
+  const auto plan = poplin::getPlan(target, params, options, &cache);
+  cache.mergeIntoIndex(target, path);
+  poplin::PlanningCache fcCache;
+  const auto fcPlan = poplin::getPlan(target, fcParams, options, &fcCache);
+  fcCache.mergeIntoIndex(target, path);
+
+  poplin::PlanningCache loadedCache;
+  loadedCache.loadIndex(target, path);
+  const auto loadedPlan =
+      poplin::getPlan(target, params, options, &loadedCache);
+  BOOST_CHECK(!(plan < loadedPlan) && !(loadedPlan < plan));
+  const auto loadedFcPlan =
+      poplin::getPlan(target, fcParams, options, &loadedCache);
+  BOOST_CHECK(!(fcPlan < loadedFcPlan) && !(loadedFcPlan < fcPlan));
+  BOOST_CHECK_EQUAL(loadedCache.getStats().candidates, 0);
+
+  // An index for a different target is ignored and can't be merged into.
+  poplar::Graph otherGraph(poplar::Target::createIPUTarget(1, testIpuName));
+  auto &otherTarget = otherGraph.getTarget();
+  const auto otherOptions = poplin::ConvOptions(otherTarget);
+  poplin::PlanningCache otherCache;
+  otherCache.loadIndex(otherTarget, path);
+  poplin::getPlan(otherTarget, params, otherOptions, &otherCache);
+  BOOST_CHECK(otherCache.getStats().candidates > 0);
+  BOOST_CHECK_THROW(otherCache.mergeIntoIndex(otherTarget, path),
+                    poputil::poplibs_error);
+  std::remove(path.c_str());
+  std::remove((path + ".lock").c_str());
+}
+
+BOOST_AUTO_TEST_CASE(PlanningStats) {
+  poplar::Graph graph(poplar::Target::createIPUTarget(2, testIpuName));
+  auto &target = graph.getTarget();
+  const auto options = poplin::ConvOptions(target);
+
+  poplin::PlanningCache cache;
+  BOOST_CHECK_EQUAL(cache.getStats().candidates, 0);
+  poplin::getPlan(target, params, options, &cache);
+  const auto stats = cache.getStats();
+  BOOST_CHECK(stats.candidates > 0);
+  BOOST_CHECK(stats.nodes > 0);
+  BOOST_CHECK(stats.propagations > 0);
+  BOOST_CHECK(stats.constraintEvaluations > 0);
+  BOOST_CHECK_EQUAL(stats.backtracks, stats.nodes);
+  BOOST_CHECK(stats.prunes <= stats.nodes);
+
+  // Plans found in the cache do not run the planner.
+  poplin::getPlan(target, params, options, &cache);
+  BOOST_CHECK_EQUAL(cache.getStats().candidates, stats.candidates);
+  BOOST_CHECK_EQUAL(cache.getStats().nodes, stats.nodes);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelAndSerialSearchesMatch) {
+  poplar::Graph graph(poplar::Target::createIPUTarget(2, testIpuName));
+  auto &target = graph.getTarget();
+  const auto options = poplin::ConvOptions(target);
+
+  // With a single thread the candidates are planned in enumeration order, as
+  // in a serial search.
+  tbb::task_arena serialArena(1);
+  for (const auto &p : {params, fcParams}) {
+    const auto parallelPlan = poplin::getPlan(target, p, options, nullptr);
+    poplin::Plan serialPlan;
+    serialArena.execute(
+        [&] { serialPlan = poplin::getPlan(target, p, options, nullptr); });
+    BOOST_CHECK(!(parallelPlan < serialPlan) && !(serialPlan < parallelPlan));
+  }
+}
+
 BOOST_AUTO_TEST_CASE(StartTileIsPassOblivious) {
   poplar::Graph graph(poplar::Target::createIPUTarget(2, testIpuName));
   auto &target = graph.getTarget();
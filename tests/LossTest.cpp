@@ -22,6 +22,7 @@
 #include <iostream>
 #include <limits>
 #include <random>
+#include <set>
 
 using namespace poplar;
 using namespace poplar::program;
@@ -154,6 +155,31 @@ static void getModelLossAndDeltas(
     }
     break;
   }
+  case LossType::SOFTMAX_CROSS_ENTROPY_LOSS: {
+    for (std::size_t b = 0; b < batchSize; b++) {
+      double max = activations[b][0];
+      for (std::size_t t = 0; t < numClasses; t++) {
+        max = std::max(max, activations[b][t]);
+      }
+      double sum = 0;
+      for (std::size_t t = 0; t < numClasses; t++) {
+        sum += exp(activations[b][t] - max);
+      }
+      for (std::size_t t = 0; t < numClasses; t++) {
+        double expect = (t == expected[b] ? 1 : 0);
+        double prob = exp(activations[b][t] - max) / sum;
+        double delta = (prob - expect) * scalingForDeltas;
+        if (expected[b] == MASKED_LABEL_CODE) {
+          delta = 0;
+        }
+        deltas[b][t] = delta;
+        if (t == expected[b]) {
+          loss[b] -= log(prob);
+        }
+      }
+    }
+    break;
+  }
   default:
     BOOST_FAIL("calculateExpectedResults unimplemented for given LossType");
     break;
@@ -206,8 +232,16 @@ static bool lossTest(const LossType lossType, std::size_t batchSize,
   std::uniform_real_distribution<double> dist(0.0, 1.0);
 
   const auto scaleForDeltas = 1000.0f;
+  const bool softmaxLoss = lossType == LossType::SOFTMAX_CROSS_ENTROPY_LOSS;
 
   for (std::size_t b = 0; b < batchSize; ++b) {
+    if (softmaxLoss) {
+      // The fused softmax takes logits.
+      for (std::size_t c = 0; c < numClasses; ++c) {
+        hostActivations[b][c] = 8.0 * dist(randomEngine) - 4.0;
+      }
+      continue;
+    }
     double batchSum = 0.0;
     for (std::size_t c = 0; c < numClasses; ++c) {
       hostActivations[b][c] = dist(randomEngine);
@@ -222,9 +256,31 @@ static bool lossTest(const LossType lossType, std::size_t batchSize,
     }
   }
   copy(target, hostActivations, fpType, rawHostActivations.get());
+  if (softmaxLoss) {
+    // The loss is sensitive to the rounding of the logits, so the model uses
+    // the same values as the device.
+    copy(target, fpType, rawHostActivations.get(), hostActivations);
+  }
   std::vector<std::uint64_t> hostExpected;
   getExpected(hostActivations, hostExpected, randomEngine, maskLabels);
   copyLabels(expectedType, hostExpected, rawHostExpected.get());
+  if (softmaxLoss) {
+    // Mask some of the classes with logits of -infinity, including the first
+    // of some rows, keeping the label and the maximum of each row.
+    for (std::size_t b = 0; b < batchSize; ++b) {
+      const auto maxClass = std::distance(
+          hostActivations[b].begin(),
+          std::max_element(hostActivations[b].begin(),
+                           hostActivations[b].end()));
+      for (std::size_t c = 0; c < numClasses; ++c) {
+        if ((b + c) % 3 == 0 && c != hostExpected[b] &&
+            c != std::size_t(maxClass)) {
+          hostActivations[b][c] = -std::numeric_limits<double>::infinity();
+        }
+      }
+    }
+    copy(target, hostActivations, fpType, rawHostActivations.get());
+  }
 
   auto deltasScale =
       graph.addConstant(deltas.elementType(), {}, scaleForDeltas);
@@ -233,7 +289,7 @@ static bool lossTest(const LossType lossType, std::size_t batchSize,
   graph.setTileMapping(deltasScale, 0);
   graph.setTileMapping(tModelOutputScaling, 0);
   auto prog =
-      (lossType == LossType::CROSS_ENTROPY_LOSS && scaling)
+      (lossType != LossType::SUM_SQUARED_LOSS && scaling)
           ?
           // (modelOutputScaling != 1.0)) ?
           calcLoss(graph, activations, expected, loss, deltas, deltasScale,
@@ -257,11 +313,11 @@ static bool lossTest(const LossType lossType, std::size_t batchSize,
   boost::multi_array<double, 2> modelDeltas(
       boost::extents[batchSize][numClasses]);
   boost::multi_array<double, 1> modelLoss(boost::extents[batchSize]);
-  bool scaledLoss = (lossType == LossType::CROSS_ENTROPY_LOSS) && scaling;
+  bool scaledLoss = (lossType != LossType::SUM_SQUARED_LOSS) && scaling;
   //(modelOutputScaling != 1.0);
   getModelLossAndDeltas(lossType, hostActivations, hostExpected, modelDeltas,
                         modelLoss, fpType, scaledLoss ? scaleForDeltas : 1.0f,
-                        scaledLoss ? modelOutputScaling : 1.0f);
+                        scaledLoss && !softmaxLoss ? modelOutputScaling : 1.0f);
 
   const double relativeTolerance = fpType == FLOAT ? 0.01 : 0.1;
   const double absoluteTolerance = fpType == FLOAT ? 1e-6 : 1e-5;
@@ -452,8 +508,9 @@ static std::vector<double> model_topK(std::vector<double> &acts, int numK) {
 
 static bool topKTest(const Type &fpType, std::size_t batchSize,
                      std::size_t numClasses, std::size_t numK,
-                     bool sort = false) {
-  auto device = createTestDevice(TEST_TARGET, 1, 4);
+                     bool sort = false, unsigned numTiles = 4,
+                     bool interleaved = false, bool negInf = false) {
+  auto device = createTestDevice(TEST_TARGET, 1, numTiles);
   auto target = device.getTarget();
   poplar::Graph graph(target);
   popops::addCodelets(graph);
@@ -462,6 +519,14 @@ static bool topKTest(const Type &fpType, std::size_t batchSize,
   auto activations =
       graph.addVariable(fpType, {batchSize, numClasses},
                         VariableMappingMethod::LINEAR, "activations");
+  if (interleaved) {
+    // Map the elements to the tiles in turn so each tile holds many intervals
+    // of each row.
+    const auto flatActivations = activations.flatten();
+    for (std::size_t i = 0; i != flatActivations.numElements(); ++i) {
+      graph.setTileMapping(flatActivations[i], i % numTiles);
+    }
+  }
 
   auto outputIndices = graph.addVariable(
       fpType, {batchSize, numK}, VariableMappingMethod::LINEAR, "indices");
@@ -479,6 +544,16 @@ static bool topKTest(const Type &fpType, std::size_t batchSize,
       boost::extents[batchSize][numClasses]);
 
   writeRandomValues(target, fpType, hostActivations, 0.0, 1.0, randomEngine);
+  if (negInf) {
+    // Leave few enough finite values that the top k includes -inf values.
+    for (unsigned b = 0; b != batchSize; ++b) {
+      for (unsigned c = 0; c != numClasses; ++c) {
+        if (c % 8 != 0) {
+          hostActivations[b][c] = -std::numeric_limits<double>::infinity();
+        }
+      }
+    }
+  }
   copy(target, hostActivations, fpType, rawHostActivations.get());
 
   Sequence prog;
@@ -486,6 +561,8 @@ static bool topKTest(const Type &fpType, std::size_t batchSize,
 
   auto rawHostOut = allocateHostMemoryForTensor(values, "output", graph,
                                                 uploadProg, downloadProg, tmap);
+  auto rawHostOutIndices = allocateHostMemoryForTensor(
+      outputIndices, "outputIndices", graph, uploadProg, downloadProg, tmap);
 
   Engine engine(graph, Sequence(uploadProg, prog, downloadProg));
   device.bind([&](const Device &d) {
@@ -518,7 +595,21 @@ static bool topKTest(const Type &fpType, std::size_t batchSize,
     }
 
     for (unsigned i = 0; i < numK; ++i) {
-      matches &= std::fabs(maxElement[i] - deviceActs[i]) < 0.00001;
+      matches &= maxElement[i] == deviceActs[i] ||
+                 std::fabs(maxElement[i] - deviceActs[i]) < 0.00001;
+    }
+
+    // Each index must be a distinct element of the input with the value
+    // returned for it.
+    const auto indicesHost =
+        reinterpret_cast<unsigned *>(rawHostOutIndices.get()) + b * numK;
+    std::set<unsigned> seen;
+    for (unsigned i = 0; i < numK; ++i) {
+      const auto index = indicesHost[i];
+      matches &= index < numClasses && seen.insert(index).second &&
+                 (hostActivations[b][index] == outHost[b * numK + i] ||
+                  std::fabs(hostActivations[b][index] -
+                            outHost[b * numK + i]) < 0.00001);
     }
   }
   return matches;
@@ -597,6 +688,18 @@ BOOST_AUTO_TEST_CASE(topKFloat) {
   // Test K==Size
   BOOST_CHECK(topKTest(FLOAT, 1, 20, 20, false));
   BOOST_CHECK(topKTest(FLOAT, 1, 20, 20, true));
+
+  // Test inputs spread over enough tiles to need several merge stages.
+  BOOST_CHECK(topKTest(FLOAT, 3, 20000, 5, true, 64));
+  BOOST_CHECK(topKTest(FLOAT, 2, 20000, 100, false, 64));
+
+  // Test rows with many intervals on each tile.
+  BOOST_CHECK(topKTest(FLOAT, 2, 300, 40, true, 4, true));
+  BOOST_CHECK(topKTest(FLOAT, 3, 1000, 10, false, 16, true));
+
+  // Test a top k that includes -inf values.
+  BOOST_CHECK(topKTest(FLOAT, 2, 200, 50, true, 4, false, true));
+  BOOST_CHECK(topKTest(FLOAT, 2, 300, 60, false, 16, true, true));
 }
 
 BOOST_AUTO_TEST_CASE(topKHalf) {
@@ -624,6 +727,9 @@ BOOST_AUTO_TEST_CASE(topKHalf) {
   // Test K==Size
   BOOST_CHECK(topKTest(HALF, 1, 20, 20, false));
   BOOST_CHECK(topKTest(HALF, 1, 20, 20, true));
+
+  // Test a top k that includes -inf values.
+  BOOST_CHECK(topKTest(HALF, 2, 300, 60, true, 16, true, true));
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -651,7 +757,11 @@ BOOST_AUTO_TEST_SUITE_END()
 #define ENUMERATE_LOSS_TYPE_TESTS(b, n, tr, ml)                                \
   ENUMERATE_VALID_LOSS_TYPE_TESTS(SUM_SQUARED_LOSS, b, n, tr, false, false)    \
   ENUMERATE_VALID_LOSS_TYPE_TESTS(CROSS_ENTROPY_LOSS, b, n, tr, ml, false)     \
-  ENUMERATE_VALID_LOSS_TYPE_TESTS(CROSS_ENTROPY_LOSS, b, n, tr, ml, true)
+  ENUMERATE_VALID_LOSS_TYPE_TESTS(CROSS_ENTROPY_LOSS, b, n, tr, ml, true)     \
+  ENUMERATE_VALID_LOSS_TYPE_TESTS(SOFTMAX_CROSS_ENTROPY_LOSS, b, n, tr, ml,    \
+                                  false)                                       \
+  ENUMERATE_VALID_LOSS_TYPE_TESTS(SOFTMAX_CROSS_ENTROPY_LOSS, b, n, tr, ml,    \
+                                  true)
 
 ENUMERATE_LOSS_TYPE_TESTS(1, 1, true, false)
 ENUMERATE_LOSS_TYPE_TESTS(100, 20, true, true)
@@ -14,8 +14,12 @@
 #include <boost/program_options.hpp>
 #include <boost/random.hpp>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
 #include <limits>
 #include <random>
+#include <unistd.h>
 
 #include <popops/ElementWise.hpp>
 using namespace poplar;
@@ -284,6 +288,134 @@ static bool mapTest(const pe::Expr &expr, bool inPlace = true,
   return true;
 }
 
+// Check that mapMultiple computes the same results and reductions when they
+// are fused into one codelet as when each is computed separately.
+static bool mapMultipleTest() {
+  constexpr std::size_t size = 100;
+  auto device = createTestDevice(deviceType, 1, 4);
+  poplar::Graph graph(device.getTarget());
+  popops::addCodelets(graph);
+
+  std::vector<poplar::Tensor> ins;
+  for (unsigned i = 0; i != 3; ++i) {
+    const auto name = "in" + std::to_string(i + 1);
+    ins.push_back(
+        graph.addVariable(FLOAT, {size}, VariableMappingMethod::LINEAR, name));
+    graph.createHostWrite(name, ins.back());
+  }
+
+  const auto scaled = pe::Add(pe::Mul(pe::_1, pe::_2), pe::_3);
+  const auto absolute = pe::Abs(pe::_1);
+  const std::vector<popops::MapReduction> reductions = {
+      {0, popops::Operation::ADD},
+      {0, popops::Operation::SQUARE_ADD},
+      {1, popops::Operation::MAX},
+      {0, popops::Operation::MIN}};
+
+  Sequence prog;
+  const auto fused = popops::mapMultiple(graph, {&scaled, &absolute},
+                                         reductions, ins, prog, "Fused");
+  const auto unfused = popops::mapMultiple(
+      graph, {&scaled, &absolute}, reductions, ins, prog, "Unfused",
+      {{"enableGenerateCodelet", "false"}});
+
+  std::vector<std::vector<float>> hostFused, hostUnfused;
+  for (unsigned i = 0; i != fused.size(); ++i) {
+    graph.createHostRead("fused" + std::to_string(i), fused[i]);
+    graph.createHostRead("unfused" + std::to_string(i), unfused[i]);
+    hostFused.emplace_back(fused[i].numElements());
+    hostUnfused.emplace_back(unfused[i].numElements());
+  }
+
+  std::mt19937 randomEngine;
+  boost::random::uniform_real_distribution<float> randDist(-1.0f, 1.0f);
+  std::vector<std::vector<float>> hostIns(3, std::vector<float>(size));
+  for (auto &hostIn : hostIns) {
+    for (auto &x : hostIn) {
+      x = randDist(randomEngine);
+    }
+  }
+
+  Engine engine(graph, prog);
+  device.bind([&](const Device &d) {
+    engine.load(d);
+    for (unsigned i = 0; i != hostIns.size(); ++i) {
+      engine.writeTensor("in" + std::to_string(i + 1), hostIns[i].data(),
+                         hostIns[i].data() + hostIns[i].size());
+    }
+    engine.run(0);
+    for (unsigned i = 0; i != fused.size(); ++i) {
+      engine.readTensor("fused" + std::to_string(i), hostFused[i].data(),
+                        hostFused[i].data() + hostFused[i].size());
+      engine.readTensor("unfused" + std::to_string(i), hostUnfused[i].data(),
+                        hostUnfused[i].data() + hostUnfused[i].size());
+    }
+  });
+
+  bool matches = true;
+  for (unsigned i = 0; i != hostFused.size(); ++i) {
+    for (unsigned j = 0; j != hostFused[i].size(); ++j) {
+      const auto expected = hostUnfused[i][j];
+      const auto tolerance = 1e-5f * std::max(1.0f, std::fabs(expected));
+      if (std::fabs(hostFused[i][j] - expected) > tolerance) {
+        std::cerr << "Result " << i << " doesn't match at index " << j << ": "
+                  << hostFused[i][j] << " " << expected << "\n";
+        matches = false;
+      }
+    }
+  }
+  return matches;
+}
+
+// Count the compiled codelets in a fused codelet cache directory.
+static unsigned countCompiledCodelets(const char *dir) {
+  unsigned count = 0;
+  if (auto *d = opendir(dir)) {
+    while (const auto *entry = readdir(d)) {
+      const std::string name = entry->d_name;
+      if (name.size() > 3 && name.compare(name.size() - 3, 3, ".gp") == 0) {
+        ++count;
+      }
+    }
+    closedir(d);
+  }
+  return count;
+}
+
+// The number of compute sets used to map the expression across three float
+// tensors without generating a codelet.
+static int countUnfusedComputeSets(const pe::Expr &expr) {
+  auto device = createTestDevice(deviceType, 1, 4);
+  poplar::Graph graph(device.getTarget());
+  popops::addCodelets(graph);
+  std::vector<Tensor> ins;
+  for (unsigned i = 0; i != 3; ++i) {
+    ins.push_back(graph.addVariable(FLOAT, {10}, VariableMappingMethod::LINEAR,
+                                    "in" + std::to_string(i)));
+  }
+  Sequence prog;
+  const auto out = popops::map(graph, expr, ins, prog, "",
+                               {{"enableGenerateCodelet", "false"}});
+  graph.createHostRead("out", out);
+  Engine engine(graph, prog);
+  ProfileValue profile = engine.getProfile();
+  return profile["graphProfile"]["graph"]["numComputeSets"].asInt();
+}
+
+// Remove a directory and the files in it.
+static void removeDirectory(const char *dir) {
+  if (auto *d = opendir(dir)) {
+    while (const auto *entry = readdir(d)) {
+      const std::string name = entry->d_name;
+      if (name != "." && name != "..") {
+        std::remove((std::string(dir) + "/" + name).c_str());
+      }
+    }
+    closedir(d);
+  }
+  rmdir(dir);
+}
+
 } // end anonymous namespace
 
 #define CHECK(test)                                                            \
@@ -508,6 +640,54 @@ int main(int argc, char **argv) {
   } else if (test == "MissingPlaceholder") {
     // Add an unused int argument.
     CHECK((mapTest<10, float, float, int>(pe::Add(pe::_1, pe::_2))));
+  } else if (test == "Simplify") {
+    // Repeated sub-expressions, identities and constant sub-expressions which
+    // are simplified before the map is executed.
+    const pe::Square diff(pe::Sub(pe::_1, pe::_2));
+    CHECK((mapTest<10, float>(
+        pe::Add(pe::Mul(diff, pe::Const(1.0f)),
+                pe::Divide(pe::Add(diff, pe::Pow(pe::_3, pe::Const(2.0f))),
+                           pe::Mul(pe::Const(2.0f), pe::Const(2.0f)))),
+        true, true)));
+    CHECK((mapTest<10, float>(
+        pe::Sub(pe::Neg(pe::Neg(pe::_1)), pe::Mul(pe::_2, pe::Const(-1.0f))),
+        false, true)));
+    if (isIpuModel(deviceType)) {
+      // The repeated sub-expression is only computed once, saving the compute
+      // sets of its Sub and Square.
+      const pe::Square otherDiff(pe::Sub(pe::_1, pe::_3));
+      CHECK((countUnfusedComputeSets(pe::Add(diff, diff)) + 2 ==
+             countUnfusedComputeSets(pe::Add(diff, otherDiff))));
+    }
+  } else if (test == "MultipleOutputs") {
+    CHECK(mapMultipleTest());
+  } else if (test == "CodeletCache") {
+    if (std::system("popc --version > /dev/null 2>&1") != 0) {
+      std::cerr << "Skipping the test as popc can't be run" << std::endl;
+      return 77;
+    }
+    char cacheDir[] = "/tmp/MapFusionTestXXXXXX";
+    if (!mkdtemp(cacheDir)) {
+      std::cerr << "Failed to create the codelet cache directory" << std::endl;
+      return 1;
+    }
+    setenv("POPLIBS_FUSED_CODELET_CACHE", cacheDir, 1);
+    const auto expr = pe::Mul(pe::Add(pe::_1, pe::_2), pe::_3);
+    {
+      auto device = createTestDevice(deviceType, 1, 4);
+      popops::warmFusedCodeletCache(
+          device.getTarget(),
+          {{&expr, {FLOAT, FLOAT, FLOAT}, {false, false, false}, true},
+           {&expr, {FLOAT, FLOAT, FLOAT}, {false, false, false}, false}});
+    }
+    const bool warmed = countCompiledCodelets(cacheDir) == 2;
+    // The maps reuse the compiled codelets rather than compiling more.
+    const bool mapped = mapTest<10, float>(expr);
+    const bool reused = countCompiledCodelets(cacheDir) == 2;
+    removeDirectory(cacheDir);
+    CHECK(warmed);
+    CHECK(mapped);
+    CHECK(reused);
   } else {
     std::cerr << "Unknown test: " << test << std::endl;
     return 1;
@@ -4,6 +4,7 @@
 #define BOOST_TEST_MODULE NonLinearityTest
 #include "../popnn/NonLinearityInternal.hpp"
 #include "TestDevice.hpp"
+#include <algorithm>
 #include <boost/test/unit_test.hpp>
 #include <iostream>
 #include <limits>
@@ -422,3 +423,130 @@ BOOST_AUTO_TEST_CASE(
         checkIsClose("deltaOutH", hDeltaOutH, hRefDeltaOut, TOL, HALF_ATOL));
   }
 }
+
+// Check the softmax of a [numRows][numChannels] tensor mapped by mapRows and
+// holding getValue(row, channel) against the reference for each type and
+// softmax variant, in place and out of place.
+template <typename MapRows, typename GetValue>
+static void checkSoftMaxRows(TestDevice &device, unsigned numRows,
+                             unsigned numChannels, const MapRows &mapRows,
+                             const GetValue &getValue) {
+  auto &target = device.getTarget();
+  Graph graph(target);
+  popnn::addCodelets(graph);
+  popops::addCodelets(graph);
+  poplin::addCodelets(graph);
+
+  boost::multi_array<double, 2> hActIn(boost::extents[numRows][numChannels]);
+  for (unsigned r = 0; r < numRows; ++r) {
+    for (unsigned c = 0; c < numChannels; ++c) {
+      hActIn[r][c] = getValue(r, c);
+    }
+  }
+
+  for (const auto type : {FLOAT, HALF}) {
+    for (const auto nl :
+         {NonLinearityType::SOFTMAX, NonLinearityType::SOFTMAX_STABLE,
+          NonLinearityType::SOFTMAX_SCALED}) {
+      for (const bool inPlace : {false, true}) {
+        auto act = graph.addVariable(type, {numRows, numChannels}, "act");
+        mapRows(graph, act);
+
+        std::vector<std::pair<std::string, char *>> tmap;
+        Sequence uploadProg, downloadProg;
+        auto rawHActIn = allocateHostMemoryForTensor(
+            act, "act", graph, uploadProg, downloadProg, tmap);
+
+        auto prog = Sequence();
+        Tensor out;
+        if (inPlace) {
+          nonLinearityInPlace(graph, nl, act, prog);
+          out = act;
+        } else {
+          out = nonLinearity(graph, nl, act, prog);
+        }
+        auto rawHActOut = allocateHostMemoryForTensor(
+            out, "out", graph, uploadProg, downloadProg, tmap);
+
+        auto hRefOut = hActIn;
+        poplibs_test::nonLinearity(nl, hRefOut);
+        if (nl == NonLinearityType::SOFTMAX_SCALED) {
+          for (unsigned r = 0; r < numRows; ++r) {
+            for (unsigned c = 0; c < numChannels; ++c) {
+              hRefOut[r][c] *= SOFTMAX_SCALING;
+            }
+          }
+        }
+
+        copy(target, hActIn, type, rawHActIn.get());
+        Engine engine(graph, Sequence(uploadProg, prog, downloadProg));
+        attachStreams(engine, tmap);
+        device.bind([&](const Device &d) { engine.loadAndRun(d); });
+        boost::multi_array<double, 2> hActOut(
+            boost::extents[numRows][numChannels]);
+        copy(target, type, rawHActOut.get(), hActOut);
+
+        BOOST_TEST(checkIsClose("actOut", hActOut, hRefOut, TOL,
+                                type == FLOAT ? FLOAT_ATOL : HALF_ATOL));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(NonLinearitySoftMaxRowsOnTiles) {
+  auto device = createTestDevice(TEST_TARGET, 1, 4);
+  const unsigned numWorkers = device.getTarget().getNumWorkerContexts();
+  const unsigned numRows = 3 * numWorkers + 2;
+  const unsigned numChannels = 100;
+
+  // Map whole rows to tiles, except for one row which is split between tiles
+  // and one row which is alone on a tile, so that both the whole row and the
+  // split row vertices are used.
+  const auto mapRows = [&](Graph &graph, const Tensor &t) {
+    graph.setTileMapping(t.slice(0, numWorkers), 0);
+    graph.setTileMapping(t.slice(numWorkers, 2 * numWorkers), 1);
+    graph.setTileMapping(t[2 * numWorkers].slice(0, numChannels / 2), 2);
+    graph.setTileMapping(
+        t[2 * numWorkers].slice(numChannels / 2, numChannels), 3);
+    graph.setTileMapping(t.slice(2 * numWorkers + 1, numRows - 1), 3);
+    graph.setTileMapping(t[numRows - 1], 2);
+  };
+
+  // Some rows have elements of -infinity, including their first, in each of
+  // the whole, split and lone rows.
+  const auto getValue = [&](unsigned r, unsigned c) {
+    if ((r == 1 || r == 2 * numWorkers || r == numRows - 1) && c % 7 == 0) {
+      return -std::numeric_limits<double>::infinity();
+    }
+    return (1.0 - 2 * ((r + c) & 1)) * (1 + r % 6) * 0.01 * c;
+  };
+  checkSoftMaxRows(device, numRows, numChannels, mapRows, getValue);
+}
+
+BOOST_AUTO_TEST_CASE(NonLinearitySoftMaxLongRows) {
+  auto device = createTestDevice(TEST_TARGET, 1, 4);
+  const unsigned numRows = 3;
+  const unsigned numChannels = 3001;
+
+  // Long rows, as in attention, which are split between the workers of a
+  // tile: one row alone on a tile, one split unevenly between two tiles and
+  // one whose elements alternate between two tiles.
+  const auto mapRows = [&](Graph &graph, const Tensor &t) {
+    graph.setTileMapping(t[0], 0);
+    graph.setTileMapping(t[1].slice(0, 100), 1);
+    graph.setTileMapping(t[1].slice(100, numChannels), 2);
+    for (unsigned c = 0; c < numChannels; c += 500) {
+      const auto end = std::min(c + 500, numChannels);
+      graph.setTileMapping(t[2].slice(c, end), 2 + (c / 500) % 2);
+    }
+  };
+  // Values which are exact in half, with elements of -infinity in the split
+  // row.
+  const auto getValue = [](unsigned r, unsigned c) {
+    if (r == 1 && c % 7 == 0) {
+      return -std::numeric_limits<double>::infinity();
+    }
+    return ((c * (r + 3)) % 64) / 16.0 - 2.0;
+  };
+  checkSoftMaxRows(device, numRows, numChannels, mapRows, getValue);
+}
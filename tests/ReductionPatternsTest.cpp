@@ -5,6 +5,7 @@
 #include <boost/test/unit_test.hpp>
 #include <poplar/Engine.hpp>
 
+#include <algorithm>
 #include <iostream>
 
 using namespace poplar;
@@ -455,3 +456,40 @@ BOOST_AUTO_TEST_CASE(ReducePatternsDivideDifferentLengths) {
   }
   BOOST_TEST(checkResult(dividedReductions, expected, expectedColumns));
 }
+
+BOOST_AUTO_TEST_CASE(ReducePatternsPlanCache) {
+  auto device = createTestDevice(DeviceType::IpuModel);
+  Graph graph(device.getTarget());
+  const unsigned columns = 8;
+  // The same layout starting in row 0 and in row 3, which should share a plan.
+  const std::vector<std::vector<Interval>> regionsA = {{{2, 6}, {10, 14}}};
+  const std::vector<std::vector<Interval>> regionsB = {{{26, 30}, {34, 38}}};
+  // Columns in different positions, which need a different plan.
+  const std::vector<std::vector<Interval>> regionsC = {{{3, 7}, {11, 15}}};
+
+  const auto initialSize = getTilePartialsPlanCacheSize();
+  const auto planA = getTilePartialsPlan(regionsA, columns, graph, FLOAT,
+                                         popops::Operation::ADD);
+  BOOST_CHECK_EQUAL(getTilePartialsPlanCacheSize(), initialSize + 1);
+  const auto planB = getTilePartialsPlan(regionsB, columns, graph, FLOAT,
+                                         popops::Operation::ADD);
+  BOOST_CHECK_EQUAL(planA, planB);
+  BOOST_CHECK_EQUAL(getTilePartialsPlanCacheSize(), initialSize + 1);
+  const auto planC = getTilePartialsPlan(regionsC, columns, graph, FLOAT,
+                                         popops::Operation::ADD);
+  BOOST_CHECK_NE(planA, planC);
+  const auto planMax = getTilePartialsPlan(regionsA, columns, graph, FLOAT,
+                                           popops::Operation::MAX);
+  BOOST_CHECK_NE(planA, planMax);
+  BOOST_CHECK_EQUAL(getTilePartialsPlanCacheSize(), initialSize + 3);
+
+  BOOST_CHECK_EQUAL(planA->numColumns, 4);
+  std::vector<unsigned> planColumns;
+  for (const auto &partials : planA->partials) {
+    planColumns.insert(planColumns.end(), partials.columns.begin(),
+                       partials.columns.end());
+  }
+  std::sort(planColumns.begin(), planColumns.end());
+  BOOST_TEST(planColumns == std::vector<unsigned>({2, 3, 4, 5}),
+             boost::test_tools::per_element());
+}
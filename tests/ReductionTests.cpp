@@ -6,11 +6,14 @@
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <poplar/Engine.hpp>
 #include <poplibs_test/Util.hpp>
 #include <popops/Reduce.hpp>
 #include <popops/codelets.hpp>
 #include <poputil/TileMapping.hpp>
+#include <string>
+#include <vector>
 
 // Tolerances used in tests
 #define FLOAT_REL_TOL 0.01
@@ -324,6 +327,93 @@ static bool reduceOpsTest(const DeviceType &deviceType,
   return matchesModel;
 }
 
+// Reduce several tensors, each with a different shape and reduced
+// dimensions, in a single call to reduceMany. One of them doesn't reduce any
+// dimensions.
+static bool reduceManyTest(const DeviceType &deviceType,
+                           const std::vector<std::size_t> &dims,
+                           const Type &outType, popops::Operation operation) {
+  auto device = createTestDevice(deviceType, 1, 64);
+  const auto &target = device.getTarget();
+  Graph graph(target);
+  popops::addCodelets(graph);
+
+  assert(dims.size() == 3);
+  const std::vector<std::vector<std::size_t>> shapes = {
+      dims, {dims[1], dims[0], dims[2]}, {dims[2], dims[1], dims[0]}};
+  const std::vector<std::vector<std::size_t>> redVects = {{0}, {0, 1}, {}};
+
+  auto prog = Sequence();
+  std::vector<Tensor> ins;
+  std::vector<popops::SingleReduceOp> reductions;
+  for (unsigned i = 0; i != shapes.size(); ++i) {
+    ins.push_back(graph.addVariable(outType, shapes[i], "in"));
+    poputil::mapTensorLinearly(graph, ins.back());
+    reductions.emplace_back(ins.back(), redVects[i], operation);
+  }
+  std::vector<Tensor> outs;
+  popops::reduceMany(graph, reductions, outs, prog);
+  if (outs.size() != reductions.size()) {
+    std::cerr << "Expected " << reductions.size() << " outputs but got "
+              << outs.size() << "\n";
+    return false;
+  }
+
+  Sequence uploadProg, downloadProg;
+  std::vector<std::pair<std::string, char *>> tmap;
+  std::vector<std::unique_ptr<char[]>> rawHostIns, rawHostOuts;
+  for (unsigned i = 0; i != shapes.size(); ++i) {
+    const auto suffix = std::to_string(i);
+    rawHostIns.push_back(allocateHostMemoryForTensor(
+        ins[i], "in" + suffix, graph, uploadProg, downloadProg, tmap));
+    rawHostOuts.push_back(allocateHostMemoryForTensor(
+        outs[i], "out" + suffix, graph, uploadProg, downloadProg, tmap));
+  }
+
+  std::mt19937 randomEngine;
+  std::vector<boost::multi_array<double, 3>> hostIns;
+  for (unsigned i = 0; i != shapes.size(); ++i) {
+    const auto &shape = shapes[i];
+    hostIns.emplace_back(boost::extents[shape[0]][shape[1]][shape[2]]);
+    writeRandomValues(target, outType, hostIns.back(), -2., 2., randomEngine);
+    copy(target, hostIns.back(), outType, rawHostIns[i].get());
+  }
+
+  Engine engine(graph, Sequence(uploadProg, prog, downloadProg), options);
+  device.bind([&](const Device &d) {
+    engine.load(d);
+    attachStreams(engine, tmap);
+
+    engine.run(0); // Run.
+  });
+
+  const double absoluteTolerance =
+      outType == FLOAT ? FLOAT_ABS_TOL : HALF_ABS_TOL;
+  const double relativeTolerance =
+      outType == FLOAT ? FLOAT_REL_TOL : HALF_REL_TOL;
+
+  bool matchesModel = true;
+  for (unsigned i = 0; i != shapes.size(); ++i) {
+    std::vector<std::size_t> outDims;
+    for (std::size_t d = 0; d != shapes[i].size(); ++d) {
+      if (std::find(redVects[i].begin(), redVects[i].end(), d) ==
+          redVects[i].end()) {
+        outDims.push_back(d);
+      }
+    }
+    boost::multi_array<double, 1> hostOut(
+        boost::extents[outs[i].numElements()]);
+    copy(target, outType, rawHostOuts[i].get(), hostOut);
+    boost::multi_array<double, 1> modelReduced(
+        boost::extents[outs[i].numElements()]);
+    reduceTensor(hostIns[i], modelReduced, outDims, operation);
+    matchesModel &=
+        checkIsClose("out" + std::to_string(i), hostOut, modelReduced,
+                     relativeTolerance, absoluteTolerance);
+  }
+  return matchesModel;
+}
+
 int main(int argc, char **argv) {
   namespace po = boost::program_options;
 
@@ -373,7 +463,7 @@ int main(int argc, char **argv) {
                                  " LOGICAL_AND or LOGICAL_OR)")
     ("test",
      po::value<std::string>(&test)->required(),
-     "Test: Add | Ops");
+     "Test: Add | Ops | Many");
   // clang-format on
   po::variables_map vm;
   try {
@@ -409,6 +499,10 @@ int main(int argc, char **argv) {
     auto matchesModel =
         reduceOpsTest(deviceType, dims.val, redVect.val, outType, operation);
     return matchesModel ? 0 : 1;
+  } else if (test == "Many") {
+    auto matchesModel =
+        reduceManyTest(deviceType, dims.val, outType, operation);
+    return matchesModel ? 0 : 1;
   } else {
     std::cerr << "Unknown test '" << test << "'";
     return 1;
@@ -0,0 +1,198 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#define BOOST_TEST_MODULE ReferenceConvolutionTest
+#include "ReferenceTestCommon.hpp"
+#include <boost/multi_array.hpp>
+#include <boost/test/unit_test.hpp>
+#include <poplibs_test/Convolution.hpp>
+
+#include <functional>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace poplibs_test::conv;
+
+namespace {
+
+struct TestConvParams {
+  std::vector<unsigned> inputFieldSize;
+  std::vector<unsigned> truncationLower;
+  std::vector<unsigned> truncationUpper;
+  std::vector<unsigned> inputDilation;
+  std::vector<unsigned> paddingLower;
+  std::vector<unsigned> paddingUpper;
+  std::vector<bool> flipInput;
+  std::vector<unsigned> kernelSize;
+  std::vector<unsigned> kernelTruncationLower;
+  std::vector<unsigned> kernelTruncationUpper;
+  std::vector<unsigned> kernelDilation;
+  std::vector<unsigned> kernelPaddingLower;
+  std::vector<unsigned> kernelPaddingUpper;
+  std::vector<bool> flipKernel;
+  std::vector<unsigned> outputTruncationLower;
+  std::vector<unsigned> outputTruncationUpper;
+  std::vector<unsigned> stride;
+  std::vector<unsigned> outputPaddingLower;
+  std::vector<unsigned> outputPaddingUpper;
+  unsigned batchSize;
+  unsigned numConvGroups;
+  unsigned inputChannelsPerConvGroup;
+  unsigned outputChannelsPerConvGroup;
+
+  // A convolution with no transforms.
+  TestConvParams(std::vector<unsigned> inputFieldSize,
+                 std::vector<unsigned> kernelSize, unsigned batchSize,
+                 unsigned numConvGroups, unsigned inputChannelsPerConvGroup,
+                 unsigned outputChannelsPerConvGroup)
+      : inputFieldSize(inputFieldSize), kernelSize(kernelSize),
+        batchSize(batchSize), numConvGroups(numConvGroups),
+        inputChannelsPerConvGroup(inputChannelsPerConvGroup),
+        outputChannelsPerConvGroup(outputChannelsPerConvGroup) {
+    const auto numFieldDims = inputFieldSize.size();
+    for (auto v : {&truncationLower, &truncationUpper, &paddingLower,
+                   &paddingUpper, &kernelTruncationLower,
+                   &kernelTruncationUpper, &kernelPaddingLower,
+                   &kernelPaddingUpper, &outputTruncationLower,
+                   &outputTruncationUpper, &outputPaddingLower,
+                   &outputPaddingUpper}) {
+      v->assign(numFieldDims, 0);
+    }
+    for (auto v : {&inputDilation, &kernelDilation, &stride}) {
+      v->assign(numFieldDims, 1);
+    }
+    flipInput.assign(numFieldDims, false);
+    flipKernel.assign(numFieldDims, false);
+  }
+
+  static unsigned transformedSize(unsigned size, unsigned truncationLower,
+                                  unsigned truncationUpper, unsigned dilation,
+                                  unsigned paddingLower,
+                                  unsigned paddingUpper) {
+    size -= truncationLower + truncationUpper;
+    size = size == 0 ? 0 : (size - 1) * dilation + 1;
+    return size + paddingLower + paddingUpper;
+  }
+
+  std::vector<unsigned> getOutputFieldSize() const {
+    std::vector<unsigned> outputFieldSize;
+    for (unsigned dim = 0; dim != inputFieldSize.size(); ++dim) {
+      const auto in = transformedSize(inputFieldSize[dim], truncationLower[dim],
+                                      truncationUpper[dim], inputDilation[dim],
+                                      paddingLower[dim], paddingUpper[dim]);
+      const auto kernel = transformedSize(
+          kernelSize[dim], kernelTruncationLower[dim],
+          kernelTruncationUpper[dim], kernelDilation[dim],
+          kernelPaddingLower[dim], kernelPaddingUpper[dim]);
+      auto out = (in > kernel ? in - kernel : kernel - in) + 1;
+      out -= outputTruncationLower[dim] + outputTruncationUpper[dim];
+      out = (out + stride[dim] - 1) / stride[dim];
+      outputFieldSize.push_back(outputPaddingLower[dim] + out +
+                                outputPaddingUpper[dim]);
+    }
+    return outputFieldSize;
+  }
+};
+
+unsigned product(const std::vector<unsigned> &v) {
+  return std::accumulate(v.begin(), v.end(), 1U, std::multiplies<unsigned>());
+}
+
+struct Results {
+  boost::multi_array<double, 3> fwd;
+  boost::multi_array<double, 3> bwd;
+  boost::multi_array<double, 4> weights;
+  boost::multi_array<double, 1> biases;
+};
+
+Results runPasses(const TestConvParams &p, Implementation implementation,
+                  unsigned seed) {
+  std::mt19937 randomEngine(seed);
+  const auto inputChannels = p.numConvGroups * p.inputChannelsPerConvGroup;
+  const auto outputChannels = p.numConvGroups * p.outputChannelsPerConvGroup;
+  const auto inputElements = product(p.inputFieldSize);
+  const auto outputElements = product(p.getOutputFieldSize());
+  boost::multi_array<double, 3> in(
+      boost::extents[p.batchSize][inputChannels][inputElements]);
+  boost::multi_array<double, 4> kernel(
+      boost::extents[p.numConvGroups][p.outputChannelsPerConvGroup]
+                    [p.inputChannelsPerConvGroup][product(p.kernelSize)]);
+  boost::multi_array<double, 1> biases(boost::extents[outputChannels]);
+  boost::multi_array<double, 3> deltas(
+      boost::extents[p.batchSize][outputChannels][outputElements]);
+  fillRandom(in, randomEngine);
+  fillRandom(kernel, randomEngine);
+  fillRandom(biases, randomEngine);
+  fillRandom(deltas, randomEngine);
+
+  Results results;
+  results.fwd.resize(
+      boost::extents[p.batchSize][outputChannels][outputElements]);
+  convolution(p.inputFieldSize, p.truncationLower, p.truncationUpper,
+              p.inputDilation, p.paddingLower, p.paddingUpper, p.flipInput,
+              p.kernelSize, p.kernelTruncationLower, p.kernelTruncationUpper,
+              p.kernelDilation, p.kernelPaddingLower, p.kernelPaddingUpper,
+              p.flipKernel, p.outputTruncationLower, p.outputTruncationUpper,
+              p.stride, p.outputPaddingLower, p.outputPaddingUpper, in, kernel,
+              biases, results.fwd, implementation);
+  results.bwd.resize(
+      boost::extents[p.batchSize][inputChannels][inputElements]);
+  convolutionBackward(
+      p.inputFieldSize, p.truncationLower, p.truncationUpper, p.inputDilation,
+      p.paddingLower, p.paddingUpper, p.flipInput, p.kernelSize,
+      p.kernelTruncationLower, p.kernelTruncationUpper, p.kernelDilation,
+      p.kernelPaddingLower, p.kernelPaddingUpper, p.flipKernel,
+      p.outputTruncationLower, p.outputTruncationUpper, p.stride,
+      p.outputPaddingLower, p.outputPaddingUpper, deltas, kernel, results.bwd,
+      implementation);
+  results.weights.resize(boost::extents[kernel.shape()[0]][kernel.shape()[1]]
+                                       [kernel.shape()[2]][kernel.shape()[3]]);
+  results.weights = kernel;
+  results.biases.resize(boost::extents[outputChannels]);
+  results.biases = biases;
+  weightUpdate(p.inputFieldSize, p.truncationLower, p.truncationUpper,
+               p.inputDilation, p.paddingLower, p.paddingUpper, p.flipInput,
+               p.kernelSize, p.kernelTruncationLower, p.kernelTruncationUpper,
+               p.kernelDilation, p.kernelPaddingLower, p.kernelPaddingUpper,
+               p.flipKernel, p.outputTruncationLower, p.outputTruncationUpper,
+               p.stride, p.outputPaddingLower, p.outputPaddingUpper, 0.5, in,
+               deltas, results.weights, results.biases, implementation);
+  return results;
+}
+
+void checkImplementationsMatch(const TestConvParams &p) {
+  const auto naive = runPasses(p, Implementation::NAIVE, 1);
+  const auto parallel = runPasses(p, Implementation::PARALLEL, 1);
+  BOOST_CHECK(bitIdentical(naive.fwd, parallel.fwd));
+  BOOST_CHECK(bitIdentical(naive.bwd, parallel.bwd));
+  BOOST_CHECK(bitIdentical(naive.weights, parallel.weights));
+  BOOST_CHECK(bitIdentical(naive.biases, parallel.biases));
+}
+
+} // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(ParallelMatchesNaive2D) {
+  checkImplementationsMatch(TestConvParams({7, 9}, {3, 3}, 2, 1, 5, 6));
+}
+
+BOOST_AUTO_TEST_CASE(ParallelMatchesNaiveGrouped1D) {
+  checkImplementationsMatch(TestConvParams({11}, {4}, 3, 3, 2, 3));
+}
+
+BOOST_AUTO_TEST_CASE(ParallelMatchesNaiveTransformed) {
+  TestConvParams p({9, 8}, {3, 2}, 2, 2, 3, 4);
+  p.truncationLower = {1, 0};
+  p.inputDilation = {2, 1};
+  p.paddingLower = {1, 2};
+  p.paddingUpper = {2, 0};
+  p.flipInput = {true, false};
+  p.kernelDilation = {1, 2};
+  p.kernelPaddingUpper = {0, 1};
+  p.flipKernel = {false, true};
+  p.stride = {2, 3};
+  p.outputPaddingUpper = {1, 0};
+  checkImplementationsMatch(p);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelMatchesNaive3D) {
+  checkImplementationsMatch(TestConvParams({4, 5, 3}, {2, 3, 1}, 2, 1, 3, 2));
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#define BOOST_TEST_MODULE ReferenceGemmTest
+#include "ReferenceTestCommon.hpp"
+#include <boost/multi_array.hpp>
+#include <boost/test/unit_test.hpp>
+#include <poplibs_test/GeneralMatrixMultiply.hpp>
+
+#include <random>
+
+using namespace poplibs_test::gemm;
+
+namespace {
+
+void checkImplementationsMatch(unsigned g, unsigned m, unsigned n, unsigned k,
+                               bool transposeA, bool transposeB) {
+  std::mt19937 randomEngine(g * 1000 + m * 100 + n * 10 + k);
+  boost::multi_array<double, 3> matA(
+      transposeA ? boost::extents[g][k][m] : boost::extents[g][m][k]);
+  boost::multi_array<double, 3> matB(
+      transposeB ? boost::extents[g][n][k] : boost::extents[g][k][n]);
+  boost::multi_array<double, 3> matC(boost::extents[g][m][n]);
+  fillRandom(matA, randomEngine);
+  fillRandom(matB, randomEngine);
+  fillRandom(matC, randomEngine);
+
+  boost::multi_array<double, 3> naive(boost::extents[g][m][n]);
+  boost::multi_array<double, 3> blocked(boost::extents[g][m][n]);
+  generalGroupedMatrixMultiply(matA, matB, naive, transposeA, transposeB,
+                               Implementation::NAIVE);
+  generalGroupedMatrixMultiply(matA, matB, blocked, transposeA, transposeB,
+                               Implementation::BLOCKED);
+  BOOST_CHECK(bitIdentical(naive, blocked));
+
+  generalGroupedMatrixMultiply(matA, matB, matC, naive, 0.75, -1.5, transposeA,
+                               transposeB, Implementation::NAIVE);
+  generalGroupedMatrixMultiply(matA, matB, matC, blocked, 0.75, -1.5,
+                               transposeA, transposeB, Implementation::BLOCKED);
+  BOOST_CHECK(bitIdentical(naive, blocked));
+
+  // The 2D variants, with the result accumulated in place.
+  boost::multi_array<double, 2> matA2D = matA[0];
+  boost::multi_array<double, 2> matB2D = matB[0];
+  boost::multi_array<double, 2> naive2D = matC[0];
+  boost::multi_array<double, 2> blocked2D = matC[0];
+  generalMatrixMultiply(matA2D, matB2D, naive2D, naive2D, 0.5, 2.0, transposeA,
+                        transposeB, Implementation::NAIVE);
+  generalMatrixMultiply(matA2D, matB2D, blocked2D, blocked2D, 0.5, 2.0,
+                        transposeA, transposeB, Implementation::BLOCKED);
+  BOOST_CHECK(bitIdentical(naive2D, blocked2D));
+
+  generalMatrixMultiply(matA2D, matB2D, naive2D, transposeA, transposeB,
+                        Implementation::NAIVE);
+  generalMatrixMultiply(matA2D, matB2D, blocked2D, transposeA, transposeB,
+                        Implementation::BLOCKED);
+  BOOST_CHECK(bitIdentical(naive2D, blocked2D));
+}
+
+} // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(BlockedMatchesNaive) {
+  for (const bool transposeA : {false, true}) {
+    for (const bool transposeB : {false, true}) {
+      checkImplementationsMatch(2, 37, 300, 270, transposeA, transposeB);
+      checkImplementationsMatch(1, 1, 5, 3, transposeA, transposeB);
+      checkImplementationsMatch(3, 64, 1, 129, transposeA, transposeB);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BlockedEmptyInnerDimension) {
+  checkImplementationsMatch(1, 4, 5, 0, false, false);
+}
+
+BOOST_AUTO_TEST_CASE(BlockedColumnMajorOperands) {
+  std::mt19937 randomEngine;
+  boost::multi_array<double, 2> matA(boost::extents[7][5]);
+  boost::multi_array<double, 2> matB(boost::extents[5][9],
+                                     boost::fortran_storage_order());
+  fillRandom(matA, randomEngine);
+  fillRandom(matB, randomEngine);
+  boost::multi_array<double, 2> matBRowMajor(boost::extents[5][9]);
+  matBRowMajor = matB;
+
+  boost::multi_array<double, 2> naive(boost::extents[7][9]);
+  boost::multi_array<double, 2> blocked(boost::extents[7][9],
+                                        boost::fortran_storage_order());
+  generalMatrixMultiply(matA, matBRowMajor, naive, false, false,
+                        Implementation::NAIVE);
+  generalMatrixMultiply(matA, matB, blocked, false, false,
+                        Implementation::BLOCKED);
+  boost::multi_array<double, 2> blockedRowMajor(boost::extents[7][9]);
+  blockedRowMajor = blocked;
+  BOOST_CHECK(bitIdentical(naive, blockedRowMajor));
+}
@@ -0,0 +1,27 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#ifndef ReferenceTestCommon_hpp__
+#define ReferenceTestCommon_hpp__
+
+// Common test functions for the tests that compare implementations of the
+// host reference models.
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+template <class MultiArray>
+void fillRandom(MultiArray &a, std::mt19937 &randomEngine) {
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::generate(a.data(), a.data() + a.num_elements(),
+                [&] { return dist(randomEngine); });
+}
+
+template <class MultiArray>
+bool bitIdentical(const MultiArray &a, const MultiArray &b) {
+  return a.num_elements() == b.num_elements() &&
+         std::equal(a.data(), a.data() + a.num_elements(), b.data());
+}
+
+} // namespace
+#endif // ReferenceTestCommon_hpp__
@@ -13,6 +13,9 @@
 #include <poputil/TileMapping.hpp>
 #include <poputil/exceptions.hpp>
 
+#include <numeric>
+#include <vector>
+
 using namespace poplar;
 using namespace poplar::program;
 using namespace poputil;
@@ -402,3 +405,76 @@ BOOST_AUTO_TEST_CASE(DeviceSortKVInt) {
     BOOST_CHECK(std::is_sorted(begin, end));
   }
 }
+
+// Sort a key-value pair of tensors whose intervals on each tile have different
+// sizes with the merge exchange algorithm.
+BOOST_AUTO_TEST_CASE(DeviceSortKVMergeExchangeUnevenIntervals) {
+  constexpr std::size_t numTiles = 16;
+  constexpr std::size_t numRows = 3;
+  constexpr std::size_t rowSize = 1001;
+
+  auto device = createTestDevice(TEST_TARGET, 1, numTiles);
+  Graph graph(device.getTarget());
+  auto seq = Sequence();
+  popops::addCodelets(graph);
+
+  Tensor tKey = graph.addVariable(FLOAT, {numRows, rowSize});
+  Tensor tValue = graph.addVariable(INT, {numRows, rowSize});
+  // Map intervals of increasing size to the tiles in turn, so some tiles have
+  // several intervals of each row.
+  std::size_t begin = 0;
+  for (std::size_t i = 0; begin != tKey.numElements(); ++i) {
+    const auto end = std::min(begin + 1 + 7 * (i % 11), tKey.numElements());
+    graph.setTileMapping(tKey.flatten().slice(begin, end), i % numTiles);
+    graph.setTileMapping(tValue.flatten().slice(begin, end), i % numTiles);
+    begin = end;
+  }
+
+  const OptionFlags options{{"algorithm", "mergeExchange"}};
+  Tensor tOut = sortKeyValue(graph, tKey, tValue, 1, seq, "", options);
+  sortInPlace(graph, tKey, 1, seq, "", options);
+
+  graph.createHostWrite("key", tKey);
+  graph.createHostWrite("value", tValue);
+  graph.createHostRead("sortedKey", tKey);
+  graph.createHostRead("out", tOut);
+
+  std::vector<float> key(numRows * rowSize);
+  std::vector<int> value(numRows * rowSize);
+  boost::random::mt19937 gen;
+  boost::random::uniform_int_distribution<> dist(-1024, 1024);
+  std::generate(key.begin(), key.end(), std::bind(dist, gen));
+  std::iota(value.begin(), value.end(), 0);
+
+  std::vector<float> sortedKey(key.size());
+  std::vector<int> out(value.size());
+  Engine eng(graph, seq);
+  device.bind([&](const Device &d) {
+    eng.load(d);
+    eng.writeTensor("key", key.data(), key.data() + key.size());
+    eng.writeTensor("value", value.data(), value.data() + value.size());
+    eng.run();
+
+    eng.readTensor("sortedKey", sortedKey.data(),
+                   sortedKey.data() + sortedKey.size());
+    eng.readTensor("out", out.data(), out.data() + out.size());
+  });
+
+  for (std::size_t row = 0; row < numRows; ++row) {
+    const auto keyBegin = key.begin() + row * rowSize;
+    const auto sortedBegin = sortedKey.begin() + row * rowSize;
+    const auto outBegin = out.begin() + row * rowSize;
+
+    BOOST_CHECK(std::is_permutation(keyBegin, keyBegin + rowSize, sortedBegin));
+    BOOST_CHECK(std::is_sorted(sortedBegin, sortedBegin + rowSize));
+
+    // The values are the indices of the keys they were paired with, so each
+    // must be the index of a key in this row equal to the sorted key.
+    BOOST_CHECK(std::is_permutation(value.begin() + row * rowSize,
+                                    value.begin() + (row + 1) * rowSize,
+                                    outBegin));
+    for (std::size_t i = 0; i < rowSize; ++i) {
+      BOOST_CHECK_EQUAL(key[outBegin[i]], sortedBegin[i]);
+    }
+  }
+}
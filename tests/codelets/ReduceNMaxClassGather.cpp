@@ -34,9 +34,6 @@ std::vector<std::vector<DataType>> cpp_model(std::vector<DataType> in,
       v.push_back(in[j]);
     }
 
-    while (v.size() < topK) {
-      v.push_back(std::numeric_limits<DataType>::lowest());
-    }
     std::sort(v.begin(), v.end(), std::greater<DataType>());
     v.erase(v.begin() + topK, v.end());
   }
@@ -47,7 +44,7 @@ std::vector<std::vector<DataType>> cpp_model(std::vector<DataType> in,
 template <typename DataType>
 static bool doTest(const DeviceType &deviceType, const Type &dataType,
                    const Type &labelType, unsigned divisor, unsigned size,
-                   unsigned topK, bool sort) {
+                   unsigned topK, unsigned numRegions, bool sort) {
   auto device = createTestDevice(deviceType);
   auto &target = device.getTarget();
 
@@ -55,6 +52,29 @@ static bool doTest(const DeviceType &deviceType, const Type &dataType,
   divisor = (1u << divisorLog2);
 
   const auto nOutputs = (size + divisor - 1) / divisor;
+  // The vertex needs at least topK elements for each output.
+  if (size - (nOutputs - 1) * divisor < topK) {
+    std::cerr << "error: each output must have at least k elements\n";
+    return false;
+  }
+
+  // Split the activations into regions that are in reverse order in the row
+  // they come from, so the vertex must map each position to its row index.
+  std::vector<unsigned> regions;
+  std::vector<unsigned> rowIndex(size);
+  for (unsigned r = 0; r < numRegions; ++r) {
+    const auto begin = r * size / numRegions;
+    const auto end = (r + 1) * size / numRegions;
+    const auto rowBegin = size - end;
+    if (begin == end) {
+      continue;
+    }
+    regions.push_back(begin);
+    regions.push_back(rowBegin);
+    for (unsigned i = begin; i < end; ++i) {
+      rowIndex[i] = rowBegin + (i - begin);
+    }
+  }
 
   Graph graph(target);
   popnn::addCodelets(graph);
@@ -116,11 +136,10 @@ static bool doTest(const DeviceType &deviceType, const Type &dataType,
   auto v = graph.addVertex(cs, vertexName);
   graph.setTileMapping(v, 0);
 
-  unsigned index = 0;
   graph.connect(v["activations"], activations);
   graph.connect(v["maxValues"], partialValues);
   graph.connect(v["maxValuesIndices"], maxIndices);
-  graph.setInitialValue(v["index"], index);
+  graph.setInitialValue(v["regions"], regions);
   graph.setInitialValue(v["size"], size);
   graph.setInitialValue(v["divisorLog2"], divisorLog2);
   graph.setInitialValue(v["numK"], topK);
@@ -154,11 +173,13 @@ static bool doTest(const DeviceType &deviceType, const Type &dataType,
   }
   bool success = true;
   // We check the indices before we do any sorting stuff.
+  std::vector<DataType> hostRow(size);
+  for (unsigned i = 0; i < size; ++i) {
+    hostRow[rowIndex[i]] = hostActivations[i];
+  }
   for (unsigned i = 0; i < nOutputs * topK; ++i) {
     unsigned ind = flattened_index_array[i];
-    if (ind != std::numeric_limits<unsigned>::max()) {
-      success &= hostActivations[ind] == flattened_device_array[i];
-    }
+    success &= ind < size && hostRow[ind] == flattened_device_array[i];
   }
 
   // We have to carefuly sort the flattened device output by sorting each topK
@@ -187,6 +208,7 @@ int main(int argc, char **argv) {
   Type activationType;
   Type labelType = UNSIGNED_INT;
   unsigned divisor, size, topK;
+  unsigned numRegions = 1;
   po::options_description desc("Options");
   // clang-format off
   desc.add_options()("help", "Print help")(
@@ -199,7 +221,9 @@ int main(int argc, char **argv) {
       "size", po::value<unsigned>(&size)->required(),
       "Total size to process with vertex")(
       "k", po::value<unsigned>(&topK)->required(),
-      "Find the 'k' amount of top elements in the set");
+      "Find the 'k' amount of top elements in the set")(
+      "regions", po::value<unsigned>(&numRegions)->default_value(numRegions),
+      "Number of regions of the row the input is made of");
   // clang-format on
 
   po::variables_map vm;
@@ -218,32 +242,32 @@ int main(int argc, char **argv) {
   if (activationType == FLOAT) {
     // Test without sorting the output.
     if (!doTest<float>(deviceType, activationType, labelType, divisor, size,
-                       topK, false))
+                       topK, numRegions, false))
       return 1;
 
     // Check with sorting the output.
     if (!doTest<float>(deviceType, activationType, labelType, divisor, size,
-                       topK, true))
+                       topK, numRegions, true))
       return 1;
   } else if (activationType == INT) {
     // Test without sorting the output.
     if (!doTest<int>(deviceType, activationType, labelType, divisor, size, topK,
-                     false))
+                     numRegions, false))
       return 1;
 
     // Check with sorting the output.
     if (!doTest<int>(deviceType, activationType, labelType, divisor, size, topK,
-                     true))
+                     numRegions, true))
       return 1;
   } else if (activationType == UNSIGNED_INT) {
     // Test without sorting the output.
     if (!doTest<unsigned>(deviceType, activationType, labelType, divisor, size,
-                          topK, false))
+                          topK, numRegions, false))
       return 1;
 
     // Check with sorting the output.
     if (!doTest<unsigned>(deviceType, activationType, labelType, divisor, size,
-                          topK, true))
+                          topK, numRegions, true))
       return 1;
   } else {
     // Type is unsupported.
@@ -2,6 +2,7 @@
 #include "Constraint.hpp"
 #include "Scheduler.hpp"
 
+#include <popsolver/CallMemo.hpp>
 #include <popsolver/Model.hpp>
 #define BOOST_TEST_MODULE GenericAssignment
 #include <boost/test/unit_test.hpp>
@@ -77,3 +78,86 @@ BOOST_AUTO_TEST_CASE(GenericAssignmentReturnsInvalid) {
 
   BOOST_CHECK(!assign.propagate(scheduler));
 }
+
+BOOST_AUTO_TEST_CASE(GenericAssignmentMemo) {
+  unsigned numEvaluations = 0;
+  auto f = [&](const std::vector<unsigned> &values)
+      -> boost::optional<unsigned> {
+    ++numEvaluations;
+    if (values[0] == 3)
+      return boost::none;
+    return values[0] * 2u;
+  };
+  auto memo = std::make_shared<CallMemo>();
+  GenericAssignment assign(a, {b}, f, memo);
+
+  for (unsigned i = 0; i != 2; ++i) {
+    Domains domains;
+    domains.emplace_back(0, 10); // a
+    domains.emplace_back(2, 2);  // b
+    Scheduler scheduler(domains, {&assign});
+    BOOST_CHECK(assign.propagate(scheduler));
+    BOOST_CHECK_EQUAL(scheduler.getDomains()[a].val(), 4);
+  }
+  // Invalid results are remembered too.
+  for (unsigned i = 0; i != 2; ++i) {
+    Domains domains;
+    domains.emplace_back(0, 10); // a
+    domains.emplace_back(3, 3);  // b
+    Scheduler scheduler(domains, {&assign});
+    BOOST_CHECK(!assign.propagate(scheduler));
+  }
+  BOOST_CHECK_EQUAL(numEvaluations, 2);
+  BOOST_CHECK_EQUAL(memo->hits(), 2);
+  BOOST_CHECK_EQUAL(memo->misses(), 2);
+  BOOST_CHECK_EQUAL(memo->size(), 2);
+  BOOST_CHECK_EQUAL(memo->hitRate(), 0.5);
+}
+
+BOOST_AUTO_TEST_CASE(GenericAssignmentMemoSharedBetweenModels) {
+  unsigned numEvaluations = 0;
+  auto f = [&](const std::vector<unsigned> &values)
+      -> boost::optional<unsigned> {
+    ++numEvaluations;
+    return values[0] + values[1];
+  };
+  auto memo = std::make_shared<CallMemo>();
+  for (unsigned i = 0; i != 3; ++i) {
+    Model m;
+    auto x = m.addVariable(1, 4);
+    auto y = m.addVariable(1, 4);
+    auto cost = m.call({x, y}, f, memo);
+    auto s = m.minimize(cost);
+    BOOST_CHECK(s.validSolution());
+    BOOST_CHECK_EQUAL(s[cost], 2);
+  }
+  BOOST_CHECK_EQUAL(numEvaluations, memo->size());
+  BOOST_CHECK_EQUAL(memo->misses(), memo->size());
+  BOOST_CHECK(memo->hits() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(GenericAssignmentMemoMaxSize) {
+  unsigned numEvaluations = 0;
+  auto f = [&](const std::vector<unsigned> &values)
+      -> boost::optional<unsigned> {
+    ++numEvaluations;
+    return values[0];
+  };
+  auto memo = std::make_shared<CallMemo>(2);
+  GenericAssignment assign(a, {b}, f, memo);
+
+  for (unsigned i = 0; i != 2; ++i) {
+    for (unsigned value = 0; value != 3; ++value) {
+      Domains domains;
+      domains.emplace_back(0, 10);        // a
+      domains.emplace_back(value, value); // b
+      Scheduler scheduler(domains, {&assign});
+      BOOST_CHECK(assign.propagate(scheduler));
+      BOOST_CHECK_EQUAL(scheduler.getDomains()[a].val(), value);
+    }
+  }
+  // Only the first two results are recorded.
+  BOOST_CHECK_EQUAL(memo->size(), 2);
+  BOOST_CHECK_EQUAL(numEvaluations, 4);
+  BOOST_CHECK_EQUAL(memo->hits(), 2);
+}
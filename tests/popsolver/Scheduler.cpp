@@ -0,0 +1,136 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+#include "Constraint.hpp"
+#include "Scheduler.hpp"
+#include <memory>
+#define BOOST_TEST_MODULE Scheduler
+#include <boost/test/unit_test.hpp>
+
+using namespace popsolver;
+
+BOOST_AUTO_TEST_CASE(BacktrackRestoresDomains) {
+  Variable a(0), b(1);
+  auto less = std::unique_ptr<Less>(new Less(a, b));
+  Domains domains;
+  domains.push_back({0, 10}); // a
+  domains.push_back({0, 10}); // b
+  Scheduler scheduler(domains, {less.get()});
+  BOOST_CHECK(scheduler.initialPropagate());
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[a].max(), 9);
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[b].min(), 1);
+
+  scheduler.checkpoint();
+  scheduler.set(b, 5);
+  BOOST_CHECK(scheduler.propagate());
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[a].max(), 4);
+  scheduler.backtrack();
+
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[a].min(), 0);
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[a].max(), 9);
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[b].min(), 1);
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[b].max(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(NestedBacktrack) {
+  Variable a(0), b(1);
+  auto less = std::unique_ptr<Less>(new Less(a, b));
+  Domains domains;
+  domains.push_back({0, 10}); // a
+  domains.push_back({0, 10}); // b
+  Scheduler scheduler(domains, {less.get()});
+  BOOST_CHECK(scheduler.initialPropagate());
+
+  scheduler.checkpoint();
+  scheduler.setMax(b, 8);
+  BOOST_CHECK(scheduler.propagate());
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[a].max(), 7);
+
+  scheduler.checkpoint();
+  scheduler.setMax(b, 6);
+  scheduler.setMax(b, 4);
+  BOOST_CHECK(scheduler.propagate());
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[a].max(), 3);
+  scheduler.backtrack();
+
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[a].max(), 7);
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[b].max(), 8);
+
+  // Changes made after returning to the outer checkpoint are undone along
+  // with the ones made before the inner checkpoint.
+  scheduler.setMin(a, 2);
+  BOOST_CHECK(scheduler.propagate());
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[b].min(), 3);
+  scheduler.backtrack();
+
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[a].min(), 0);
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[a].max(), 9);
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[b].min(), 1);
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[b].max(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(FailedPropagationIsUndone) {
+  Variable a(0), b(1);
+  auto less = std::unique_ptr<Less>(new Less(a, b));
+  Domains domains;
+  domains.push_back({0, 10}); // a
+  domains.push_back({0, 10}); // b
+  Scheduler scheduler(domains, {less.get()});
+  BOOST_CHECK(scheduler.initialPropagate());
+
+  scheduler.checkpoint();
+  scheduler.set(a, 5);
+  scheduler.set(b, 5);
+  BOOST_CHECK(!scheduler.propagate());
+  scheduler.backtrack();
+
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[a].min(), 0);
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[a].max(), 9);
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[b].min(), 1);
+  BOOST_CHECK_EQUAL(scheduler.getDomains()[b].max(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(SchedulerStats) {
+  Variable a(0), b(1);
+  auto less = std::unique_ptr<Less>(new Less(a, b));
+  Domains domains;
+  domains.push_back({0, 10}); // a
+  domains.push_back({0, 10}); // b
+  Scheduler scheduler(domains, {less.get()});
+  BOOST_CHECK(scheduler.initialPropagate());
+  BOOST_CHECK_EQUAL(scheduler.getStats().propagations, 1);
+  BOOST_CHECK_EQUAL(scheduler.getStats().constraintEvaluations, 1);
+
+  scheduler.checkpoint();
+  scheduler.setMin(a, 5);
+  scheduler.setMax(b, 5);
+  BOOST_CHECK(!scheduler.propagate());
+  scheduler.backtrack();
+  BOOST_CHECK_EQUAL(scheduler.getStats().propagations, 2);
+  BOOST_CHECK_EQUAL(scheduler.getStats().constraintEvaluations, 2);
+  BOOST_CHECK_EQUAL(scheduler.getStats().backtracks, 1);
+}
+
+BOOST_AUTO_TEST_CASE(MinimizeStats) {
+  Model m;
+  auto a = m.addVariable(0, 5);
+  auto b = m.addVariable(0, 5);
+  m.less(a, b);
+  auto cost = m.call({a, b},
+                     [](const std::vector<unsigned> &values)
+                         -> boost::optional<unsigned> {
+                       if (values[0] % 2 == 0)
+                         return boost::none;
+                       return values[0] + values[1];
+                     });
+  auto s = m.minimize(cost);
+  BOOST_CHECK(s.validSolution());
+  BOOST_CHECK_EQUAL(s[cost], 3);
+  const auto &stats = m.getSearchStats();
+  BOOST_CHECK(stats.nodes > 0);
+  // Every node is undone once it has been explored.
+  BOOST_CHECK_EQUAL(stats.backtracks, stats.nodes);
+  // Even values of a are rejected by propagation.
+  BOOST_CHECK(stats.prunes > 0);
+  BOOST_CHECK(stats.prunes < stats.nodes);
+  BOOST_CHECK(stats.propagations > stats.nodes);
+  BOOST_CHECK(stats.constraintEvaluations > 0);
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2020 Graphcore Ltd. All rights reserved.
+// Check that the search strategies find solutions of the same cost and report
+// how long each of them takes.
+//
+#include <popsolver/Model.hpp>
+#define BOOST_TEST_MODULE SearchStrategy
+#include <boost/test/unit_test.hpp>
+#include <boost/timer/timer.hpp>
+
+using namespace popsolver;
+
+namespace {
+
+// A small model in the style of the convolution planner. A field of size
+// fieldSize and a number of channels are split over up to numTiles tiles.
+// The cost is the per-tile compute plus a per-tile exchange overhead.
+struct PartitionModel {
+  Model m;
+  Variable fieldSplit;
+  Variable chanSplit;
+  Variable cycles;
+  Variable tiles;
+
+  PartitionModel(SearchStrategy strategy, unsigned numTiles, unsigned fieldSize,
+                 unsigned numChans)
+      : m(strategy) {
+    fieldSplit = m.addVariable(1, fieldSize, "fieldSplit");
+    chanSplit = m.addVariable(1, numChans, "chanSplit");
+    m.factorOf(numChans, chanSplit);
+    tiles = m.product({fieldSplit, chanSplit}, "tiles");
+    m.lessOrEqual(tiles, numTiles);
+    const auto fieldPerTile =
+        m.ceildiv(m.addConstant(fieldSize), fieldSplit, "fieldPerTile");
+    const auto chansPerTile =
+        m.ceildiv(m.addConstant(numChans), chanSplit, "chansPerTile");
+    const auto compute = m.call(
+        {fieldPerTile, chansPerTile},
+        [](const std::vector<unsigned> &values) -> boost::optional<unsigned> {
+          return values[0] * values[1] + 20;
+        },
+        "compute");
+    const auto exchange = m.call(
+        {fieldSplit, chanSplit},
+        [](const std::vector<unsigned> &values) -> boost::optional<unsigned> {
+          return (values[0] + values[1]) * 4;
+        },
+        "exchange");
+    cycles = m.sum({compute, exchange}, "cycles");
+  }
+};
+
+Solution solve(PartitionModel &model, const char *name) {
+  boost::timer::cpu_timer timer;
+  auto s = model.m.minimize({model.cycles, model.tiles});
+  BOOST_TEST_MESSAGE(name << ": " << timer.format());
+  return s;
+}
+
+} // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(BisectDivisor) {
+  Model m(SearchStrategy::BISECT);
+  auto a = m.addVariable(1, 1000);
+  m.factorOf(96, a);
+  m.lessOrEqual(20, a);
+  auto s = m.minimize(a);
+  BOOST_CHECK_EQUAL(s[a], 24);
+}
+
+BOOST_AUTO_TEST_CASE(BisectLargeDomain) {
+  Model m(SearchStrategy::BISECT);
+  auto a = m.addVariable(0, 100000);
+  auto b = m.addVariable(0, 100000);
+  m.lessOrEqual(m.addConstant(12345), m.sum({a, b}));
+  m.lessOrEqual(m.addConstant(5000), a);
+  auto s = m.minimize({m.sum({a, b}), b});
+  BOOST_CHECK_EQUAL(s[a] + s[b], 12345);
+  BOOST_CHECK_EQUAL(s[b], 0);
+}
+
+BOOST_AUTO_TEST_CASE(CompareStrategies) {
+  PartitionModel linear(SearchStrategy::LINEAR, 1472, 1000, 256);
+  PartitionModel bisect(SearchStrategy::BISECT, 1472, 1000, 256);
+  const auto linearSolution = solve(linear, "linear");
+  const auto bisectSolution = solve(bisect, "bisect");
+  BOOST_REQUIRE(linearSolution.validSolution());
+  BOOST_REQUIRE(bisectSolution.validSolution());
+  BOOST_CHECK_EQUAL(linearSolution[linear.cycles],
+                    bisectSolution[bisect.cycles]);
+  BOOST_CHECK_EQUAL(linearSolution[linear.tiles], bisectSolution[bisect.tiles]);
+}
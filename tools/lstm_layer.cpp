@@ -5,6 +5,7 @@
 #include <boost/program_options.hpp>
 #include <boost/test/tools/floating_point_comparison.hpp>
 #include <cassert>
+#include <cmath>
 #include <exception>
 #include <fstream>
 #include <istream>
@@ -74,6 +75,7 @@ int main(int argc, char **argv) {
   bool preweightInput = false;
   poplibs_test::Pass pass = poplibs_test::Pass::FWD;
   std::string recompMode;
+  unsigned recompCheckpointInterval;
   unsigned runs = 1;
   std::string profileDir = ".";
   double availableMemoryProportion;
@@ -126,7 +128,11 @@ int main(int argc, char **argv) {
      "Run phase all | fwd | bwd | wu")
     ("recomputation-mode",
      po::value<std::string>(&recompMode),
-     "Recomputation mode none | cellAndTanh")
+     "Recomputation mode none | cellAndTanh | full")
+    ("recomputation-checkpoint-interval",
+     po::value<unsigned>(&recompCheckpointInterval),
+     "Number of steps between the states saved for full recomputation "
+     "(0 = automatic)")
     ("ignore-data",
      "Don't perform host-to-device or vice versa transfers (no validation)")
     ("runs", po::value<unsigned>(&runs)->default_value(runs),
@@ -205,6 +211,10 @@ int main(int argc, char **argv) {
   if (!vm["recomputation-mode"].empty()) {
     options.set("recomputationMode", recompMode);
   }
+  if (!vm["recomputation-checkpoint-interval"].empty()) {
+    options.set("recomputationCheckpointInterval",
+                std::to_string(recompCheckpointInterval));
+  }
   if (preweightInput) {
     options.set({{"preCalcWeights", "true"}});
   }
@@ -227,6 +237,37 @@ int main(int argc, char **argv) {
   std::tie(fwdOutputSeq, lastCellState) =
       popnn::lstm::lstmFwd(graph, params, fwdStateInit, input, weights,
                            fwdIntermediatesPtr, prog, "fwd", options, &cache);
+  if (fwdIntermediatesPtr) {
+    // Report the memory the forward pass keeps live for the backward pass
+    // compared to saving every intermediate of every step. With full
+    // recomputation the backward pass also allocates a buffer for the
+    // intermediates of the steps between two saved states, so count it too.
+    const auto typeSize = target.getTypeSize(dataType);
+    const std::size_t numIntermediatesPerStep =
+        params.outputFullSequence ? 6 : 7;
+    const std::size_t stepBytes =
+        numIntermediatesPerStep * batchSize * outputSize * typeSize;
+    const auto noRecompBytes = std::size_t(sequenceSize) * stepBytes;
+    std::size_t recompBufferBytes = 0;
+    if (recompMode == "full") {
+      // Mirrors the checkpoint interval the LSTM picks by default.
+      const unsigned checkpointInterval =
+          vm["recomputation-checkpoint-interval"].empty() ||
+                  recompCheckpointInterval == 0
+              ? std::max(1u, static_cast<unsigned>(
+                                 std::ceil(std::sqrt(sequenceSize))))
+              : std::min(recompCheckpointInterval, sequenceSize);
+      recompBufferBytes = checkpointInterval * stepBytes;
+    }
+    const auto savedBytes =
+        fwdIntermediates.numElements() * typeSize + recompBufferBytes;
+    std::cout << "Intermediates for the backward pass: " << savedBytes
+              << " bytes, including " << recompBufferBytes
+              << " bytes recomputed by the backward pass ("
+              << noRecompBytes << " bytes without recomputation, "
+              << (noRecompBytes - std::min(savedBytes, noRecompBytes))
+              << " bytes saved)\n";
+  }
   auto nextLayerGrads = graph.addVariable(
       dataType, {sequenceSize, batchSize, outputSize}, "nextLayerGrads");
   mapTensorLinearly(graph, nextLayerGrads);
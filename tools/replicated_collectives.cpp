@@ -1,7 +1,9 @@
 // Copyright (c) 2018 Graphcore Ltd. All rights reserved.
 #include "TestDevice.hpp"
+#include <algorithm>
 #include <boost/program_options.hpp>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <poplar/CycleCount.hpp>
 #include <poplar/Device.hpp>
@@ -110,6 +112,29 @@ static Tensor createTensorToReduce(Graph &graph, const Type &type,
   return createTensorToReduce(graph, type, numElements, shuffleMapping);
 }
 
+// Print how far the result is from the reference computed in double
+// precision, to show the error added by exchanging data in a smaller type.
+template <std::size_t N>
+static void printErrors(const boost::multi_array<double, N> &actual,
+                        const boost::multi_array<double, N> &expected) {
+  double maxAbsError = 0;
+  double maxRelError = 0;
+  double sumRelError = 0;
+  const auto numElements = actual.num_elements();
+  for (unsigned i = 0; i != numElements; ++i) {
+    const auto absError = std::fabs(actual.data()[i] - expected.data()[i]);
+    const auto magnitude = std::fabs(expected.data()[i]);
+    const auto relError = magnitude == 0 ? absError : absError / magnitude;
+    maxAbsError = std::max(maxAbsError, absError);
+    maxRelError = std::max(maxRelError, relError);
+    sumRelError += relError;
+  }
+  std::cout << "Max absolute error: " << maxAbsError << "\n";
+  std::cout << "Max relative error: " << maxRelError << "\n";
+  std::cout << "Mean relative error: "
+            << (numElements ? sumRelError / numElements : 0) << "\n";
+}
+
 static Tensor createOnIpuShuffled(Graph &graph, const Type &type,
                                   const Tensor &ref) {
   auto result = graph.addVariable(type, {ref.numElements()},
@@ -197,12 +222,15 @@ int main(int argc, char **argv) {
   bool replicateTopLevelGraph = false;
   bool shuffleMapping = false;
   unsigned iterations = 1;
-  const auto type = poplar::HALF;
+  Type type = poplar::HALF;
+  boost::optional<std::string> exchangeType;
   // Some GCL config only support collectives on 1 side of the ladder
   // so add option to force the entire tensor onto single ipu
   bool forceMapping = false;
   bool inPlace = false;
   unsigned forceIpu = 0;
+  unsigned numTensors = 1;
+  boost::optional<unsigned> bucketSize;
   // GCL only options.
   std::string maxBytesPerTile;
 
@@ -223,6 +251,10 @@ int main(int argc, char **argv) {
      "Collective: reduce_scatter | all_gather | all_reduce")
     ("reduction-operator", po::value(&reduceOp)->default_value(reduceOp),
      "Reduction operator: ADD | MUL | MIN | MAX")
+    ("data-type", po::value<Type>(&type)->default_value(type),
+     "Type of the data to reduce")
+    ("exchange-type", po::value(&exchangeType),
+     "Type to exchange the data in: float | half")
     ("elements", po::value(&numElements)->default_value(numElements),
      "Number of elements per rank")
     ("shuffle-mapping", po::value(&shuffleMapping)->default_value(false),
@@ -242,6 +274,11 @@ int main(int argc, char **argv) {
      "bidirectional_ring_pair | meet_in_middle_ring")
     ("force-mapping", po::value(&forceIpu),
          "for all elements onto one ipu")
+    ("tensors", po::value(&numTensors)->default_value(numTensors),
+     "Number of tensors to split the elements between. If greater than 1 "
+     "the tensors are reduced with replicatedAllReduceMany()")
+    ("bucket-size", po::value(&bucketSize),
+     "Target size in bytes of the buckets of replicatedAllReduceMany()")
     ("iterations,i",
      po::value(&iterations)->default_value(1),
      "Number of time the allReduce operation is called")
@@ -269,6 +306,17 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  if (numTensors == 0 || numTensors > numElements) {
+    std::cerr << "The number of tensors must be between 1 and the number of "
+                 "elements\n";
+    return 1;
+  }
+
+  if (numTensors != 1 && inPlace) {
+    std::cerr << "Can't operate in place on multiple tensors\n";
+    return 1;
+  }
+
   if (vm.count("force-mapping")) {
     forceMapping = true;
   }
@@ -329,6 +377,12 @@ int main(int argc, char **argv) {
   if (vm.count("gcl")) {
     options.set("useGclCollectives", "true");
   }
+  if (bucketSize) {
+    options.set("bucketSize", std::to_string(*bucketSize));
+  }
+  if (exchangeType) {
+    options.set("exchangeType", *exchangeType);
+  }
   if (vm.count("gcl-max-bytes-per-tile")) {
     if (vm.count("gcl")) {
       options.set("maxBytesPerTile", maxBytesPerTile);
@@ -341,7 +395,19 @@ int main(int argc, char **argv) {
   input = createTensorToReduce(graph, type, numElements, shuffleMapping,
                                forceMapping, forceIpu);
   output = createOnIpuShuffled(graph, type, input);
-  if (inPlace) {
+  if (numTensors != 1) {
+    // Split the elements between tensors of different sizes.
+    std::vector<Tensor> inputs, outputs;
+    for (unsigned i = 0; i != numTensors; ++i) {
+      const auto begin = numElements * i / numTensors;
+      const auto end = numElements * (i + 1) / numTensors;
+      inputs.push_back(input.slice(begin, end));
+      outputs.push_back(output.slice(begin, end));
+    }
+    const auto results = popops::replicatedAllReduceMany(
+        graph, inputs, reduceOp, prog, "allReduce", options);
+    prog.add(Copy(concat(results), concat(outputs)));
+  } else if (inPlace) {
     popops::replicatedAllReduceInPlace(graph, input, reduceOp, prog,
                                        "allReduce", options);
     // input gets zeroed before we read the output back in
@@ -435,8 +501,10 @@ int main(int argc, char **argv) {
     engine.run(2);
   });
   bool matchesModel;
-  double relativeTolerance = type == HALF ? HALF_REL_TOL : FLOAT_REL_TOL;
-  double absoluteTolerance = type == HALF ? HALF_ABS_TOL : FLOAT_ABS_TOL;
+  const bool halfPrecision =
+      type == HALF || (exchangeType && *exchangeType == "half");
+  double relativeTolerance = halfPrecision ? HALF_REL_TOL : FLOAT_REL_TOL;
+  double absoluteTolerance = halfPrecision ? HALF_ABS_TOL : FLOAT_ABS_TOL;
   if (doAllGather) {
     boost::multi_array<double, 2> hostGathered(
         boost::extents[numPartials][numElements]);
@@ -446,11 +514,13 @@ int main(int argc, char **argv) {
     for (unsigned i = 0; i != numPartials; ++i) {
       hostGatheredExpected[i] = hostChunks;
     }
+    printErrors(hostGathered, hostGatheredExpected);
     matchesModel = checkIsClose("gathered", hostGathered, hostGatheredExpected,
                                 relativeTolerance, absoluteTolerance);
   } else {
     boost::multi_array<double, 1> hostReduced(boost::extents[numElements]);
     copy(target, type, rawHostOutput.get(), hostReduced);
+    printErrors(hostReduced, hostChunks);
     matchesModel = checkIsClose("reduced", hostReduced, hostChunks,
                                 relativeTolerance, absoluteTolerance);
   }